@@ -0,0 +1,55 @@
+#include "../tsk2_solver.h"
+/**
+ * A module for testing the solver
+ */
+/**
+ * Solve the same system twice with the different accuracy.
+ * The number of iterations differs, but the number of allocations must not.
+ * The tridiagonal system has no halo, so every process solves its own copy
+ * Results:
+ *      A number of allocations per solve
+ */
+static size_t testSolverAllocations( ProgramEnv* env_p){
+    enum { NODES_COUNT = 64 };
+    int* IA = new int[NODES_COUNT + 1];
+    int* JA = new int[3 * NODES_COUNT];
+    double* A = new double[3 * NODES_COUNT];
+    size_t edge_idx = 0;
+    for( int node_idx = 0; node_idx < NODES_COUNT; ++node_idx ){
+        IA[node_idx] = edge_idx;
+        for( int neighbor_idx = node_idx - 1; neighbor_idx <= node_idx + 1;
+            ++neighbor_idx ){
+            if( neighbor_idx >= 0 && neighbor_idx < NODES_COUNT ){
+                JA[edge_idx] = neighbor_idx;
+                A[edge_idx] = neighbor_idx == node_idx ? 2.5 : -1;
+                ++edge_idx;
+            }
+        }
+    }
+    IA[NODES_COUNT] = edge_idx;
+    NetGraph graph( NODES_COUNT, edge_idx, IA, JA, A, env_p, new ComScheme);
+    MathVector b_vec( NODES_COUNT, env_p);
+    b_vec.fillVector();
+    SolverWorkspace workspace( NODES_COUNT, env_p);
+    // Warm up the workspace
+    solverCG( graph, b_vec, false, 1e-2, env_p, workspace);
+    size_t start_count = MathVector::getAllocationsCount();
+    SolverSolution coarse_solution = solverCG( graph, b_vec, false, 1e-2,
+        env_p, workspace);
+    size_t coarse_count = MathVector::getAllocationsCount() - start_count;
+    start_count = MathVector::getAllocationsCount();
+    SolverSolution fine_solution = solverCG( graph, b_vec, false, 1e-8,
+        env_p, workspace);
+    size_t fine_count = MathVector::getAllocationsCount() - start_count;
+    if( coarse_solution.getIterationsNumber() >=
+        fine_solution.getIterationsNumber() || coarse_count != fine_count ){
+        std::cout << "A solver allocation test failed" << std::endl;
+    }
+    return fine_count;
+}
+/**
+ * Launch all tests
+ */
+void launchSolverTests( ProgramEnv* env_p){
+    testSolverAllocations( env_p);
+}
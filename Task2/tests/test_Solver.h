@@ -0,0 +1,5 @@
+#include "../tsk2_real.h"
+/**
+ * A header file for the solver tests
+ */
+void launchSolverTests( ProgramEnv* env_p);
@@ -1,4 +1,5 @@
 #include "../tsk2_vector.h"
+#include "../tsk2_simd.h"
 /**
  * A module for testing the vector
  */
@@ -102,6 +103,7 @@ static double testSparseMV( ProgramEnv* env_p ){
     if( env_p->getProcessNum() < 2 ){
         IA[0] = 0;
         IA[1] = 1;
+        IA[2] = 2;
         JA[0] = 1;
         JA[1] = 0;
         A[0] = 3.0;
@@ -111,16 +113,78 @@ static double testSparseMV( ProgramEnv* env_p ){
         vec_mult[0] = 5;
         vec_mult[1] = 6;
         double res_l2 = sqrt( 18*18 + 10*10);
+        SimdIsa_t detected_isa = getSimdIsa();
+        setSimdIsa( SIMD_SCALAR);
         MathVector sparse_mult = sparseMV( graph, vec_mult);
         if ( fabs( sparse_mult.calculateL2() - res_l2) >=
     DOUBLE_COMPARISON_ACCURACY ){
             std::cout << "A sparse MV test failed" << std::endl;
         }
+        // The multiplication goes through the kernel of every instruction set
+        for( int isa = SIMD_SCALAR + 1; isa < SIMD_ISA_COUNT; ++isa ){
+            if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+                continue;
+            }
+            setSimdIsa( static_cast<SimdIsa_t>( isa));
+            MathVector isa_mult = sparseMV( graph, vec_mult);
+            if( fabs( isa_mult[0] - sparse_mult[0]) >=
+                DOUBLE_COMPARISON_ACCURACY ||
+                fabs( isa_mult[1] - sparse_mult[1]) >=
+                DOUBLE_COMPARISON_ACCURACY ){
+                std::cout << "A sparse MV test failed: " <<
+                getSimdIsaName( static_cast<SimdIsa_t>( isa)) << std::endl;
+            }
+        }
+        setSimdIsa( detected_isa);
         return sparse_mult[0] + sparse_mult[1];
     } else{
         return 0;
     }
 }
+/**
+ * Compare the vectorized kernels with the scalar kernels.
+ * The length of the local vectors isn't a multiple of the vector register,
+ * so the remainder handling is tested too.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testSimdKernels( ProgramEnv* env_p){
+    const size_t vec_len = 1003;
+    MathVector vec_a( vec_len, env_p), vec_b( vec_len, env_p);
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        vec_a[vec_idx] = sin( vec_idx);
+        vec_b[vec_idx] = cos( vec_idx);
+    }
+    SimdIsa_t detected_isa = getSimdIsa();
+    setSimdIsa( SIMD_SCALAR);
+    double res_product = dotProduct( vec_a, vec_b);
+    MathVector res_comb( vec_len, env_p);
+    linearCombination( vec_a, vec_b, 0.5, -2, res_comb);
+    for( int isa = SIMD_SCALAR + 1; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        MathVector comb( vec_len, env_p);
+        // The dot product is reduced in the single precision
+        bool has_failed = fabs( dotProduct( vec_a, vec_b) - res_product) >=
+            DOUBLE_COMPARISON_ACCURACY * fabs( res_product) +
+            DOUBLE_COMPARISON_ACCURACY;
+        linearCombination( vec_a, vec_b, 0.5, -2, comb);
+        for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+            if( fabs( comb[vec_idx] - res_comb[vec_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ){
+                has_failed = true;
+            }
+        }
+        if( has_failed ){
+            std::cout << "A SIMD kernel test failed: " <<
+            getSimdIsaName( static_cast<SimdIsa_t>( isa)) << std::endl;
+        }
+    }
+    setSimdIsa( detected_isa);
+    return res_product;
+}
 /**
  * Launch all tests
  */
@@ -128,4 +192,5 @@ void launchTests( ProgramEnv* env_p){
     testDotProduct( env_p);
     testLinearCombination( env_p);
     testSparseMV( env_p);
+    testSimdKernels( env_p);
 }
@@ -31,6 +31,21 @@ public:
     std::vector<int>& getRecvOffset(){  
         return recv_offset_;
     }
+    std::vector<float>& getSendBuffer(){
+        return send_buffer_;
+    }
+    std::vector<float>& getHaloValues(){
+        return halo_values_;
+    }
+    std::vector<double>& getHaloColumns(){
+        return halo_columns_;
+    }
+    std::vector<MPI_Request>& getRequests(){
+        return requests_;
+    }
+    std::vector<MPI_Status>& getStatuses(){
+        return statuses_;
+    }
     void print( ProgramEnv* env_p){
         std::map<int, int>& local_to_global = env_p->getLocalToGlobal();
         for( int processor_rank = 0; processor_rank < env_p->getProcessNum();
@@ -77,5 +92,19 @@ private:
      std::vector<int> recv_;
      std::vector<int> send_offset_;
      std::vector<int> recv_offset_;
+    /**
+     * The buffers for the exchange, allocated once with the scheme.
+     * The halo node with the local index node_idx is stored in
+     * halo_values[node_idx - nodes_count]
+     */
+     std::vector<float> send_buffer_;
+     std::vector<float> halo_values_;
+    /**
+     * The widened halo, the kernel reads the halo column column_idx
+     * from halo_columns[column_idx - nodes_count]
+     */
+     std::vector<double> halo_columns_;
+     std::vector<MPI_Request> requests_;
+     std::vector<MPI_Status> statuses_;
 };
 #endif
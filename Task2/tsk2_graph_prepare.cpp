@@ -8,12 +8,56 @@
 #include <algorithm>
 #include "tsk2_graph_prepare.h"
 #include "tsk2_com.h"
+#include "tsk2_vector.h"
+// The diagonal is this times the sum of the other cells of the row
+static const double DOMINANCE_COEFF = 2;
 /**
  * Generate a graph of a network from a matrix
  * of a pre-set parameters.
+ * The cells are 1, fillMatrix() sets the coefficients
  */
 void
 NetGraph::generate( MatrixParameters *params_p){ 
+    generateBlock<false>( params_p);
+}
+/**
+ * Generate a graph and set its coefficients in one pass:
+ * a row is written with the coefficients of its cells,
+ * and its diagonal is set, when the row ends.
+ * The matrix is the same, as generate() and fillMatrix() make.
+ */
+void
+NetGraph::generateFilled( MatrixParameters *params_p){ 
+    generateBlock<true>( params_p);
+}
+/**
+ * Write an edge from the node to the neighbor, both are global.
+ * The coefficient of the cell is the one of fillMatrix(),
+ * if the graph is filled, and 1 otherwise
+ */
+template <bool is_filled>
+inline void
+NetGraph::addEdge( size_t& block_edge_idx, size_t node_idx,
+                   size_t neighbor_idx, double& row_sum){
+    // The neighbor is a local or a halo node
+    assert( env_p_->getGlobalToLocal().count( neighbor_idx));
+    JA[block_edge_idx] = env_p_->getGlobalToLocal()[neighbor_idx];
+    if( is_filled ){
+        A[block_edge_idx] = cos( node_idx + neighbor_idx
+            + node_idx * neighbor_idx );
+        row_sum += fabs( A[block_edge_idx]);
+    } else{
+        A[block_edge_idx] = 1;
+    }
+    ++block_edge_idx;
+}
+/**
+ * Generate the rows of the block
+ * If is_filled = true, then set the coefficients of the cells too
+ */
+template <bool is_filled>
+void
+NetGraph::generateBlock( MatrixParameters *params_p){ 
     size_t row_len = params_p->getRowLen();
     size_t column_len = params_p->getColumnLen();
     size_t not_divided = params_p->getNotDivided();
@@ -53,13 +97,13 @@ NetGraph::generate( MatrixParameters *params_p){
 			size_t node_idx = row_idx * (column_len + 1) + column_idx;
             assert( global_to_local[node_idx] < nodes_count_);
             IA[global_to_local[node_idx]] = block_edge_idx;
+            // A sum of the cells on the row, except for the diagonal
+            double row_sum = 0;
 			
             if( row_idx > 0 ){
                 // Edge from (row_idx; column_idx) to (row_idx - 1; column_idx)
-                JA[block_edge_idx] = 
-                    global_to_local[node_idx - (column_len + 1)]; 
-                A[block_edge_idx] = 1;
-                ++block_edge_idx;
+                addEdge<is_filled>( block_edge_idx, node_idx,
+                    node_idx - (column_len + 1), row_sum);
             }
             if( row_idx > 0 && column_idx < column_len ){
                 // Include an edge from a cell division
@@ -67,66 +111,101 @@ NetGraph::generate( MatrixParameters *params_p){
 				// Cell is divided
                 if( upper_cell_idx % (divided + not_divided) >= not_divided ){
                     // An edge from (row_idx; column_idx) to (row_idx - 1; column_idx + 1)
-                    JA[block_edge_idx] = global_to_local[node_idx - column_len];
-                    A[block_edge_idx] = 1;
-                    ++block_edge_idx;
+                    addEdge<is_filled>( block_edge_idx, node_idx,
+                        node_idx - column_len, row_sum);
                 }
             }
             // Edge from (row_idx; column_idx) to (row_idx; column_idx - 1)
             if( column_idx > 0 ){
-                JA[block_edge_idx] = global_to_local[node_idx - 1];
-                A[block_edge_idx] = 1;
-                ++block_edge_idx;
+                addEdge<is_filled>( block_edge_idx, node_idx, node_idx - 1, row_sum);
             }
-			// Edge from a node to itself
+			// Edge from a node to itself, it is set after the other edges
+			size_t diagonal_idx = block_edge_idx;
 			JA[block_edge_idx] = global_to_local[node_idx];
-			A[block_edge_idx] = 1;
-            ++block_edge_idx;
+			++block_edge_idx;
             // Edge from (row_idx; column_idx) to (row_idx; column_idx + 1)
             if( column_idx < column_len ){
-                JA[block_edge_idx] = global_to_local[node_idx + 1];
-                A[block_edge_idx] = 1;
-                ++block_edge_idx;
+                addEdge<is_filled>( block_edge_idx, node_idx, node_idx + 1, row_sum);
             }
             // Look at the cell below
             if( row_idx < row_len && column_idx > 0 ){
                 size_t below_cell_idx = row_idx * column_len + column_idx - 1;
                 if( below_cell_idx % (divided + not_divided) >= not_divided ){
                     // An edge from (row_idx; column_idx) to (row_idx + 1; column_idx - 1)
-                    JA[block_edge_idx] = global_to_local[node_idx + column_len];
-                    A[block_edge_idx] = 1;
-                    ++block_edge_idx;
+                    addEdge<is_filled>( block_edge_idx, node_idx,
+                        node_idx + column_len, row_sum);
                 }
             }
             if( row_idx < row_len ){
                 // Edge from (row_idx; column_idx) to (row_idx + 1; column_idx)
-                JA[block_edge_idx] = global_to_local[node_idx + (column_len + 1)];
-                A[block_edge_idx] = 1;
-                ++block_edge_idx;
+                addEdge<is_filled>( block_edge_idx, node_idx,
+                    node_idx + (column_len + 1), row_sum);
             }
+            A[diagonal_idx] = is_filled ? DOMINANCE_COEFF * row_sum : 1;
 			
         }
     }
-    edges_count_ = block_edge_idx;
+    // The arrays were allocated for the calculated number of edges
+    assert( block_edge_idx == edges_count_);
 	IA[nodes_count_] = edges_count_;
 }
 
+/**
+ * Calculate a number of the edges( not-null cells) of the block rows.
+ * The edges of a node are the same, as generate() includes.
+ */
+size_t
+NetGraph::countEdges( MatrixParameters* params_p){
+    size_t row_len = params_p->getRowLen();
+    size_t column_len = params_p->getColumnLen();
+    size_t not_divided = params_p->getNotDivided();
+    size_t divided = params_p->getDivided();
+    size_t start_row_idx = env_p_->getStartRow();
+    size_t end_row_idx = env_p_->getEndRow();
+    size_t start_column_idx = env_p_->getStartColumn();
+    size_t end_column_idx = env_p_->getEndColumn();
+    size_t edges_count = 0;
+    for( size_t row_idx = start_row_idx; row_idx < end_row_idx; ++row_idx ){
+        for( size_t column_idx = start_column_idx; column_idx < end_column_idx;
+             ++column_idx ){
+            // Edge from a node to itself
+            ++edges_count;
+            if( row_idx > 0 ){
+                ++edges_count;
+                size_t upper_cell_idx = (row_idx - 1) * column_len + column_idx;
+                if( column_idx < column_len &&
+                    upper_cell_idx % (divided + not_divided) >= not_divided ){
+                    ++edges_count;
+                }
+            }
+            if( column_idx > 0 ){
+                ++edges_count;
+            }
+            if( column_idx < column_len ){
+                ++edges_count;
+            }
+            if( row_idx < row_len ){
+                ++edges_count;
+                size_t below_cell_idx = row_idx * column_len + column_idx - 1;
+                if( column_idx > 0 &&
+                    below_cell_idx % (divided + not_divided) >= not_divided ){
+                    ++edges_count;
+                }
+            }
+        }
+    }
+    return edges_count;
+}
 /** 
  * Fill the matrix
  * Make it diagonally dominant
  */
 void NetGraph::fillMatrix(){
     std::map<int, int>& local_to_global = env_p_->getLocalToGlobal();
-    const double DOMINANCE_COEFF = 2;
     for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx){
         // A sum of all matrix cells on the row, except for the diagonal
         double row_sum = 0;
-        /**
-         * For the rightmost node IA doesn't specify the edges index.
-         * Instead, get it from the graph
-         */
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
+        size_t end_idx = IA[node_idx + 1];
         /** 
          * A position of a diagonal element:
          * of a node that has an edge to itself
@@ -149,36 +228,19 @@ void NetGraph::fillMatrix(){
     }
 }
 /**
- * Make a diagonal matrix from the current graph
- * If is_reverse = true, then make it reversed
+ * Copy the diagonal of the local nodes
  */
-NetGraph NetGraph::makeDiagonalMatrix( bool is_reverse){
-    int* diagonal_IA = new int[nodes_count_];
-    int* diagonal_JA = new int[nodes_count_];
-    double* diagonal_A = new double[nodes_count_];
+void NetGraph::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
     for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
-        diagonal_IA[node_idx] = node_idx;
-        /**
-         * For the rightmost node IA doesn't specify the edges index.
-         * Instead, get it from the graph
-         */
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
+        size_t end_idx = IA[node_idx + 1];
         for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
         ++edge_idx){
             if(JA[edge_idx] == node_idx ){
-                diagonal_JA[node_idx] = node_idx;
-                if( is_reverse ){
-                    diagonal_A[node_idx] = 1.0 / A[edge_idx];
-                } else{
-                    diagonal_A[node_idx] = A[edge_idx];
-                }
+                diagonal[node_idx] = A[edge_idx];
             }
         }
     }
-    ComScheme* com_scheme_p = new ComScheme;
-    return NetGraph( nodes_count_, nodes_count_, diagonal_IA, diagonal_JA,
-    diagonal_A, env_p_, com_scheme_p);
 }
 /**
  * Create a communication scheme for the graph
@@ -200,8 +262,7 @@ NetGraph::createComScheme(){
      * Add the local nodes, that neighbor halo, to the send_to_process array.
      */
     for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
+        size_t end_idx = IA[node_idx + 1];
         for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
         ++edge_idx){
             size_t neighbor_node = JA[edge_idx];
@@ -239,4 +300,12 @@ NetGraph::createComScheme(){
         send_offset.push_back( send.size());
         recv_offset.push_back( recv.size());
     }
+    // Allocate the exchange buffers, so the multiplication doesn't do it
+    com_scheme_p_->getSendBuffer().resize( send.size());
+    com_scheme_p_->getHaloValues().resize( local_to_global.size() -
+        nodes_count_);
+    com_scheme_p_->getHaloColumns().resize( local_to_global.size() -
+        nodes_count_);
+    com_scheme_p_->getRequests().resize( send.size() + recv.size());
+    com_scheme_p_->getStatuses().resize( send.size() + recv.size());
 }
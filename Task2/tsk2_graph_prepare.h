@@ -6,8 +6,8 @@
 #include <cmath>
 #include "tsk2_real.h"
 #include "tsk2_com.h"
+class MathVector;
 enum { 
-    NETGRAPH_MAX_EDGES_NODE = 6,
     NETGRAPH_NOT_DIVIDED_EDGES = 2,
     NETGRAPH_DIVIDED_EDGES = 3
 };
@@ -94,10 +94,10 @@ NetGraph( MatrixParameters *params_p,
 
     nodes_count_ = (end_row_idx - start_row_idx) * (end_column_idx -
     start_column_idx);
-    size_t edges_count_max = nodes_count_ * NETGRAPH_MAX_EDGES_NODE;
+    edges_count_ = countEdges( params_p);
     IA = new int[nodes_count_ + 1];
-    JA = new int[2 * edges_count_max];
-    A = new double[2 * edges_count_max];
+    JA = new int[edges_count_];
+    A = new double[edges_count_];
     // The communication scheme is not prepared
     com_scheme_p_ = nullptr;
 }
@@ -133,8 +133,7 @@ void printGraph(){
         if( env_p_->getProcessRank() == processor_rank ){
             for( int node_idx = 0; node_idx < nodes_count_; ++node_idx ){
                 std::cout << "Node index: " << local_to_global[node_idx] << std::endl << "Edges to: ";        
-                size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-                    edges_count_;
+                size_t end_idx = IA[node_idx + 1];
                 for( int edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
                     std::cout << local_to_global[JA[edge_idx]] << " ";
                 }
@@ -167,10 +166,17 @@ ComScheme* getComScheme(){
     return com_scheme_p_;
 }
 void generate( MatrixParameters *params_p);
+void generateFilled( MatrixParameters *params_p);
 void fillMatrix();
-NetGraph makeDiagonalMatrix( bool is_reverse);
+void copyDiagonal( MathVector& diagonal);
 void createComScheme();
 private:
+    size_t countEdges( MatrixParameters* params_p);
+    template <bool is_filled>
+    void generateBlock( MatrixParameters *params_p);
+    template <bool is_filled>
+    void addEdge( size_t& block_edge_idx, size_t node_idx, size_t neighbor_idx,
+                  double& row_sum);
     /** 
      * JA and A stores information about all rows.
      * To get information about a single row,
@@ -0,0 +1,49 @@
+/**
+ * The preconditioners of the CG solver
+ */
+#include <chrono>
+#include <cassert>
+#include "tsk2_preconditioner.h"
+typedef std::chrono::milliseconds ms;
+/**
+ * Take the inverse of the diagonal of the local nodes
+ */
+void JacobiPreconditioner::setup( NetGraph& matrix){
+    size_t nodes_count = matrix.getNodesCount();
+    if( reverse_diagonal_.getVecLen() != nodes_count ){
+        reverse_diagonal_ = MathVector( nodes_count,
+            reverse_diagonal_.getEnv());
+    }
+    matrix.copyDiagonal( reverse_diagonal_);
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        reverse_diagonal_[node_idx] = 1.0 / reverse_diagonal_[node_idx];
+    }
+}
+void JacobiPreconditioner::apply( MathVector& residual, MathVector& result){
+    size_t vec_len = residual.getVecLen();
+    assert( reverse_diagonal_.getVecLen() == vec_len);
+    assert( result.getVecLen() == vec_len);
+    const double* reverse_diagonal = reverse_diagonal_.getValues();
+    const double* residual_values = residual.getValues();
+    double* result_values = result.getValues();
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        result_values[vec_idx] = reverse_diagonal[vec_idx] *
+            residual_values[vec_idx];
+    }
+}
+/**
+ * The time is calculated only if MEASURE_VECTOR_OPS define is set
+ */
+void applyWithMeasure( Preconditioner& preconditioner, MathVector& residual,
+                       MathVector& result, double& time){
+	#ifdef MEASURE_VECTOR_OPS
+    std::chrono::time_point<std::chrono::high_resolution_clock> t0 = std::chrono::high_resolution_clock::now();
+	#endif
+    preconditioner.apply( residual, result);
+	#ifdef MEASURE_VECTOR_OPS
+    std::chrono::time_point<std::chrono::high_resolution_clock> t1 = std::chrono::high_resolution_clock::now();
+	std::chrono::milliseconds new_time = std::chrono::duration_cast<ms>(t1 - t0);
+    std::cout << new_time.count() << std::endl;
+    time += new_time.count();
+	#endif
+}
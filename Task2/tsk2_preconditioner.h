@@ -0,0 +1,44 @@
+#ifndef PRECONDITIONER_H
+    #define PRECONDITIONER_H
+#include "tsk2_graph_prepare.h"
+#include "tsk2_vector.h"
+/**
+ * A preconditioner of the CG solver, z = M^-1 * r.
+ * The preconditioner is set up for the local part of the matrix
+ * before the solve and is applied on every iteration,
+ * so a stronger preconditioner doesn't change the solver loop.
+ */
+class Preconditioner{
+public:
+    virtual ~Preconditioner() {}
+    /**
+     * Build the preconditioner of the matrix
+     */
+    virtual void setup( NetGraph& matrix) = 0;
+    /**
+     * Apply the preconditioner to the local part of the residual
+     * The result must not be the residual
+     */
+    virtual void apply( MathVector& residual, MathVector& result) = 0;
+};
+/**
+ * The Jacobi preconditioner, M = D.
+ * The inverse of the diagonal is a vector of the local nodes,
+ * the apply is one loop over the elements without the halo exchange.
+ */
+class JacobiPreconditioner: public Preconditioner{
+public:
+    JacobiPreconditioner( ProgramEnv* env_p): reverse_diagonal_( 0, env_p) {}
+    void setup( NetGraph& matrix);
+    void apply( MathVector& residual, MathVector& result);
+private:
+    // The inverse of the diagonal, D^-1
+    MathVector reverse_diagonal_;
+};
+/**
+ * The wrapper over the apply.
+ * Calculate the time of the apply and append it to the time.
+ */
+void applyWithMeasure( Preconditioner& preconditioner, MathVector& residual,
+                       MathVector& result, double& time);
+#endif
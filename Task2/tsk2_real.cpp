@@ -9,6 +9,7 @@
 #include "tsk2_vector.h"
 #include "tsk2_solver.h"
 #include "tests/test_Vector.h"
+#include "tests/test_Solver.h"
  
 
 typedef std::chrono::milliseconds ms;
@@ -128,6 +129,28 @@ void divideMatrix( MatrixParameters* params_p, ProgramEnv* env_p){
             ++halo_nodes_num;
         }
     }
+    /**
+     * A divided cell has an edge from (row_idx; column_idx)
+     * to (row_idx - 1; column_idx + 1), so the first node of the last column
+     * neighbors the block on the previous row and the next column,
+     * and the last node of the first column neighbors the block
+     * on the next row and the previous column
+     */
+    if( block_row_idx > 0 && block_column_idx < block_columns - 1 ){
+        size_t node_idx = (row_start_idx - 1) * (column_len + 1)
+            + column_end_idx;
+        global_to_local[node_idx] = local_nodes_num + halo_nodes_num;
+        local_to_global[local_nodes_num + halo_nodes_num] = node_idx;
+        parts.push_back( processor_rank - block_columns + 1);
+        ++halo_nodes_num;
+    }
+    if( block_row_idx < block_rows - 1 && block_column_idx > 0 ){
+        size_t node_idx = row_end_idx * (column_len + 1) + column_start_idx - 1;
+        global_to_local[node_idx] = local_nodes_num + halo_nodes_num;
+        local_to_global[local_nodes_num + halo_nodes_num] = node_idx;
+        parts.push_back( processor_rank + block_columns - 1);
+        ++halo_nodes_num;
+    }
 }
 int main( int argc, char **argv){
     if( argc == 1 ){
@@ -149,6 +172,7 @@ int main( int argc, char **argv){
     divideMatrix( &matrix_param, &program_env);
     // Run the tests
     launchTests( &program_env);
+    launchSolverTests( &program_env);
     std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
     // Measure the phases time if the parameter is set
 #ifdef MEASURE_GENERATE
@@ -159,7 +183,12 @@ int main( int argc, char **argv){
     std::chrono::high_resolution_clock::now();
 #endif
     NetGraph graph( &matrix_param, &program_env);
-    graph.generate( &matrix_param);
+    // The one-pass graph is filled in the generation
+    if( program_env.isTwoPassFill() ){
+        graph.generate( &matrix_param);
+    } else{
+        graph.generateFilled( &matrix_param);
+    }
 #ifdef MEASURE_GENERATE
     #ifdef MEASURE_MEMORY
     uint64_t generate_after_mem = getMemoryUsage();
@@ -180,7 +209,9 @@ int main( int argc, char **argv){
     std::chrono::high_resolution_clock::time_point fill_start =
     std::chrono::high_resolution_clock::now();
 #endif
-    graph.fillMatrix();
+    if( program_env.isTwoPassFill() ){
+        graph.fillMatrix();
+    }
     MathVector b_vec( graph.getNodesCount(), &program_env);
     b_vec.fillVector();
     graph.createComScheme();
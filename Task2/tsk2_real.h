@@ -9,6 +9,8 @@ class ProgramEnv{
 private:
     // Is a debug print enabled
     bool debug_print_;
+    // Is the graph generated and filled in two passes
+    bool two_pass_fill_;
     // A number of processes
     int process_num_;
     // A current process
@@ -30,6 +32,12 @@ public:
     bool isDebugPrint(){
         return debug_print_;
     }
+    void setTwoPassFill( bool two_pass_fill){
+        two_pass_fill_ = two_pass_fill;
+    }
+    bool isTwoPassFill(){
+        return two_pass_fill_;
+    }
     void setProcessNum( int process_num){
         process_num_ = process_num;
     }
@@ -70,6 +78,7 @@ public:
     std::vector<int>& getParts(){
         return parts_;
     }
-    ProgramEnv(): debug_print_( false), process_num_(1), process_rank_(0) {}
+    ProgramEnv(): debug_print_( false), two_pass_fill_( false),
+        process_num_(1), process_rank_(0) {}
 };
 #endif
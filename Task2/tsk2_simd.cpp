@@ -0,0 +1,351 @@
+/**
+ * The vectorized kernels of the basic operations
+ */
+#include "tsk2_simd.h"
+#if defined( __GNUC__) && ( defined( __x86_64__) || defined( __i386__))
+    #define SIMD_X86
+    #include <immintrin.h>
+#endif
+/**
+ * The instruction set of the kernels.
+ * It is selected once, when the program starts.
+ */
+static SimdIsa_t current_isa = detectSimdIsa();
+/**
+ * Find the best instruction set, that the processor supports
+ */
+SimdIsa_t detectSimdIsa(){
+    if( isSimdIsaSupported( SIMD_AVX512) ){
+        return SIMD_AVX512;
+    }
+    if( isSimdIsaSupported( SIMD_AVX2) ){
+        return SIMD_AVX2;
+    }
+    return SIMD_SCALAR;
+}
+bool isSimdIsaSupported( SimdIsa_t isa){
+#ifdef SIMD_X86
+    // The detection may run before main, in a static initialization
+    __builtin_cpu_init();
+#endif
+    switch( isa ){
+    case SIMD_SCALAR:
+        return true;
+#ifdef SIMD_X86
+    case SIMD_AVX2:
+        return __builtin_cpu_supports( "avx2") && __builtin_cpu_supports( "fma");
+    case SIMD_AVX512:
+        return __builtin_cpu_supports( "avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+SimdIsa_t getSimdIsa(){
+    return current_isa;
+}
+/**
+ * Select the instruction set of the kernels
+ * An unsupported instruction set is replaced by the scalar kernels
+ */
+void setSimdIsa( SimdIsa_t isa){
+    current_isa = isSimdIsaSupported( isa) ? isa : SIMD_SCALAR;
+}
+const char* getSimdIsaName( SimdIsa_t isa){
+    switch( isa ){
+    case SIMD_AVX2:
+        return "AVX2";
+    case SIMD_AVX512:
+        return "AVX-512";
+    default:
+        return "Scalar";
+    }
+}
+/**
+ * The scalar kernels
+ */
+static double dotProductScalar( const double* vec_a, const double* vec_b,
+                                size_t vec_len){
+    double sum = 0;
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        sum += vec_a[vec_idx] * vec_b[vec_idx];
+    }
+    return sum;
+}
+static void linearCombinationScalar( const double* vec_a, const double* vec_b,
+                                     double alpha_coeff, double beta_coeff,
+                                     double* result, size_t vec_len){
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        result[vec_idx] = alpha_coeff * vec_a[vec_idx] +
+            beta_coeff * vec_b[vec_idx];
+    }
+}
+static double sparseMVDotScalar( const int* IA, const int* JA, const double* A,
+                                 const double* vec, const double* halo,
+                                 int local_count, double* result,
+                                 size_t start_row, size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        double row_product = 0;
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
+            int column_idx = JA[edge_idx];
+            double column_value = column_idx < local_count ? vec[column_idx] :
+                halo[column_idx - local_count];
+            row_product += column_value * A[edge_idx];
+        }
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+#ifdef SIMD_X86
+/**
+ * The AVX2 kernels.
+ * A row of the matrix has 3-7 not-null cells, so it is multiplied
+ * by the gather of 4 elements, the rest is masked.
+ */
+__attribute__(( target( "avx2,fma")))
+static double horizontalSumAvx2( __m256d vec){
+    __m128d low = _mm256_castpd256_pd128( vec);
+    __m128d high = _mm256_extractf128_pd( vec, 1);
+    low = _mm_add_pd( low, high);
+    return _mm_cvtsd_f64( _mm_add_sd( low, _mm_unpackhi_pd( low, low)));
+}
+__attribute__(( target( "avx2,fma")))
+static double dotProductAvx2( const double* vec_a, const double* vec_b,
+                              size_t vec_len){
+    __m256d first_sum = _mm256_setzero_pd();
+    __m256d second_sum = _mm256_setzero_pd();
+    size_t vec_idx = 0;
+    for( ; vec_idx + 8 <= vec_len; vec_idx += 8){
+        first_sum = _mm256_fmadd_pd( _mm256_loadu_pd( vec_a + vec_idx),
+            _mm256_loadu_pd( vec_b + vec_idx), first_sum);
+        second_sum = _mm256_fmadd_pd( _mm256_loadu_pd( vec_a + vec_idx + 4),
+            _mm256_loadu_pd( vec_b + vec_idx + 4), second_sum);
+    }
+    double sum = horizontalSumAvx2( _mm256_add_pd( first_sum, second_sum));
+    for( ; vec_idx < vec_len; ++vec_idx){
+        sum += vec_a[vec_idx] * vec_b[vec_idx];
+    }
+    return sum;
+}
+__attribute__(( target( "avx2,fma")))
+static void linearCombinationAvx2( const double* vec_a, const double* vec_b,
+                                   double alpha_coeff, double beta_coeff,
+                                   double* result, size_t vec_len){
+    __m256d alpha_vec = _mm256_set1_pd( alpha_coeff);
+    __m256d beta_vec = _mm256_set1_pd( beta_coeff);
+    size_t vec_idx = 0;
+    for( ; vec_idx + 4 <= vec_len; vec_idx += 4){
+        __m256d b_part = _mm256_mul_pd( beta_vec,
+            _mm256_loadu_pd( vec_b + vec_idx));
+        _mm256_storeu_pd( result + vec_idx, _mm256_fmadd_pd( alpha_vec,
+            _mm256_loadu_pd( vec_a + vec_idx), b_part));
+    }
+    for( ; vec_idx < vec_len; ++vec_idx){
+        result[vec_idx] = alpha_coeff * vec_a[vec_idx] +
+            beta_coeff * vec_b[vec_idx];
+    }
+}
+/**
+ * Gather the values of the columns in the lanes of the mask.
+ * The columns from local_count are taken from the halo,
+ * the second gather is made only if there are such columns.
+ */
+__attribute__(( target( "avx2,fma")))
+static __m256d gatherColumnsAvx2( const double* vec, const double* halo,
+                                  int local_count, __m128i columns,
+                                  __m256i mask_64){
+    __m128i halo_32 = _mm_cmpgt_epi32( columns,
+        _mm_set1_epi32( local_count - 1));
+    __m256i halo_64 = _mm256_cvtepi32_epi64( halo_32);
+    __m256d elems = _mm256_mask_i32gather_pd( _mm256_setzero_pd(), vec,
+        columns, _mm256_castsi256_pd( _mm256_andnot_si256( halo_64, mask_64)),
+        8);
+    if( _mm_testz_si128( halo_32, halo_32) ){
+        return elems;
+    }
+    return _mm256_mask_i32gather_pd( elems, halo, _mm_sub_epi32( columns,
+        _mm_set1_epi32( local_count)), _mm256_castsi256_pd(
+        _mm256_and_si256( halo_64, mask_64)), 8);
+}
+__attribute__(( target( "avx2,fma")))
+static double sparseMVDotAvx2( const int* IA, const int* JA, const double* A,
+                               const double* vec, const double* halo,
+                               int local_count, double* result,
+                               size_t start_row, size_t end_row){
+    const __m128i lanes_32 = _mm_setr_epi32( 0, 1, 2, 3);
+    const __m256i lanes_64 = _mm256_setr_epi64x( 0, 1, 2, 3);
+    const __m256i all_lanes = _mm256_set1_epi64x( -1);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        size_t edge_idx = IA[node_idx];
+        __m256d row_sum = _mm256_setzero_pd();
+        for( ; edge_idx + 4 <= end_idx; edge_idx += 4){
+            __m128i columns = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>( JA + edge_idx));
+            row_sum = _mm256_fmadd_pd( _mm256_loadu_pd( A + edge_idx),
+                gatherColumnsAvx2( vec, halo, local_count, columns, all_lanes),
+                row_sum);
+        }
+        if( edge_idx < end_idx ){
+            // Mask the cells after the end of the row
+            int rest = end_idx - edge_idx;
+            __m128i mask_32 = _mm_cmpgt_epi32( _mm_set1_epi32( rest), lanes_32);
+            __m256i mask_64 = _mm256_cmpgt_epi64( _mm256_set1_epi64x( rest),
+                lanes_64);
+            __m128i columns = _mm_maskload_epi32( JA + edge_idx, mask_32);
+            __m256d cells = _mm256_maskload_pd( A + edge_idx, mask_64);
+            __m256d elems = gatherColumnsAvx2( vec, halo, local_count,
+                columns, mask_64);
+            row_sum = _mm256_fmadd_pd( cells, elems, row_sum);
+        }
+        double row_product = horizontalSumAvx2( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * The AVX-512 kernels.
+ * A row of the matrix fits into a single gather of 8 elements.
+ */
+__attribute__(( target( "avx512f")))
+static double dotProductAvx512( const double* vec_a, const double* vec_b,
+                                size_t vec_len){
+    __m512d first_sum = _mm512_setzero_pd();
+    __m512d second_sum = _mm512_setzero_pd();
+    size_t vec_idx = 0;
+    for( ; vec_idx + 16 <= vec_len; vec_idx += 16){
+        first_sum = _mm512_fmadd_pd( _mm512_loadu_pd( vec_a + vec_idx),
+            _mm512_loadu_pd( vec_b + vec_idx), first_sum);
+        second_sum = _mm512_fmadd_pd( _mm512_loadu_pd( vec_a + vec_idx + 8),
+            _mm512_loadu_pd( vec_b + vec_idx + 8), second_sum);
+    }
+    for( ; vec_idx < vec_len; vec_idx += 8){
+        __mmask8 mask = vec_len - vec_idx >= 8 ? 0xFF :
+            ( 1 << ( vec_len - vec_idx)) - 1;
+        first_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+            vec_a + vec_idx), _mm512_maskz_loadu_pd( mask, vec_b + vec_idx),
+            first_sum);
+    }
+    return _mm512_reduce_add_pd( _mm512_add_pd( first_sum, second_sum));
+}
+__attribute__(( target( "avx512f")))
+static void linearCombinationAvx512( const double* vec_a, const double* vec_b,
+                                     double alpha_coeff, double beta_coeff,
+                                     double* result, size_t vec_len){
+    __m512d alpha_vec = _mm512_set1_pd( alpha_coeff);
+    __m512d beta_vec = _mm512_set1_pd( beta_coeff);
+    for( size_t vec_idx = 0; vec_idx < vec_len; vec_idx += 8){
+        __mmask8 mask = vec_len - vec_idx >= 8 ? 0xFF :
+            ( 1 << ( vec_len - vec_idx)) - 1;
+        __m512d b_part = _mm512_mul_pd( beta_vec,
+            _mm512_maskz_loadu_pd( mask, vec_b + vec_idx));
+        _mm512_mask_storeu_pd( result + vec_idx, mask, _mm512_fmadd_pd(
+            alpha_vec, _mm512_maskz_loadu_pd( mask, vec_a + vec_idx), b_part));
+    }
+}
+__attribute__(( target( "avx512f")))
+static double sparseMVDotAvx512( const int* IA, const int* JA, const double* A,
+                                 const double* vec, const double* halo,
+                                 int local_count, double* result,
+                                 size_t start_row, size_t end_row){
+    const __m512i local_vec = _mm512_set1_epi32( local_count);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        __m512d row_sum = _mm512_setzero_pd();
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             edge_idx += 8){
+            __mmask8 mask = end_idx - edge_idx >= 8 ? 0xFF :
+                ( 1 << ( end_idx - edge_idx)) - 1;
+            __m512i wide_columns = _mm512_maskz_loadu_epi32( mask,
+                JA + edge_idx);
+            // The columns from local_count are taken from the halo
+            __mmask8 halo_mask = _mm512_mask_cmpge_epi32_mask( mask,
+                wide_columns, local_vec);
+            __m512d elems = _mm512_mask_i32gather_pd( _mm512_setzero_pd(),
+                mask & ~halo_mask, _mm512_castsi512_si256( wide_columns), vec,
+                8);
+            if( halo_mask ){
+                elems = _mm512_mask_i32gather_pd( elems, halo_mask,
+                    _mm512_castsi512_si256( _mm512_sub_epi32( wide_columns,
+                    local_vec)), halo, 8);
+            }
+            row_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+                A + edge_idx), elems, row_sum);
+        }
+        double row_product = _mm512_reduce_add_pd( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+#endif
+/**
+ * Calculate a dot product of the two arrays
+ */
+double dotProductKernel( const double* vec_a, const double* vec_b,
+                         size_t vec_len){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        return dotProductAvx512( vec_a, vec_b, vec_len);
+    case SIMD_AVX2:
+        return dotProductAvx2( vec_a, vec_b, vec_len);
+#endif
+    default:
+        return dotProductScalar( vec_a, vec_b, vec_len);
+    }
+}
+/**
+ * Calculate a linear combination of the two arrays
+ * The result may be one of the arrays
+ */
+void linearCombinationKernel( const double* vec_a, const double* vec_b,
+                              double alpha_coeff, double beta_coeff,
+                              double* result, size_t vec_len){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        linearCombinationAvx512( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+        break;
+    case SIMD_AVX2:
+        linearCombinationAvx2( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+        break;
+#endif
+    default:
+        linearCombinationScalar( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+    }
+}
+/**
+ * Multiply the rows [start_row; end_row) of a CSR matrix to the vector
+ * The columns below local_count index the vector, the others index
+ * the halo from local_count, so the local values aren't copied
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+double sparseMVDotKernel( const int* IA, const int* JA, const double* A,
+                          const double* vec, const double* halo,
+                          int local_count, double* result,
+                          size_t start_row, size_t end_row){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        return sparseMVDotAvx512( IA, JA, A, vec, halo, local_count, result,
+            start_row, end_row);
+    case SIMD_AVX2:
+        return sparseMVDotAvx2( IA, JA, A, vec, halo, local_count, result,
+            start_row, end_row);
+#endif
+    default:
+        return sparseMVDotScalar( IA, JA, A, vec, halo, local_count, result,
+            start_row, end_row);
+    }
+}
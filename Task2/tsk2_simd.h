@@ -0,0 +1,31 @@
+#ifndef SIMD_H
+    #define SIMD_H
+#include <cstddef>
+/**
+ * The vectorized kernels of the basic operations.
+ * The kernels work on the raw arrays and on a range of the elements,
+ * every process calls them on its local part of the vectors.
+ * The instruction set is detected by CPUID at the start of the program,
+ * the kernels without the explicit vectorization are the fallback.
+ */
+typedef enum{
+    SIMD_SCALAR = 0,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_ISA_COUNT
+} SimdIsa_t;
+SimdIsa_t detectSimdIsa();
+bool isSimdIsaSupported( SimdIsa_t isa);
+SimdIsa_t getSimdIsa();
+void setSimdIsa( SimdIsa_t isa);
+const char* getSimdIsaName( SimdIsa_t isa);
+double dotProductKernel( const double* vec_a, const double* vec_b,
+                         size_t vec_len);
+void linearCombinationKernel( const double* vec_a, const double* vec_b,
+                              double alpha_coeff, double beta_coeff,
+                              double* result, size_t vec_len);
+double sparseMVDotKernel( const int* IA, const int* JA, const double* A,
+                          const double* vec, const double* halo,
+                          int local_count, double* result,
+                          size_t start_row, size_t end_row);
+#endif
@@ -4,10 +4,37 @@
 enum { MAX_ITERATIONS = 10000 };
 /**
  * A CG solver for a matrix
+ * Allocate the solver vectors for a single solve
  */
 SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
                double convergence_accuracy,  // The convergence accuracy
                ProgramEnv* env_p){
+    SolverWorkspace workspace( matrix.getNodesCount(), env_p);
+    return solverCG( matrix, right_part, print_debug, convergence_accuracy,
+        env_p, workspace);
+}
+/**
+ * A CG solver for a matrix with the Jacobi preconditioner
+ */
+SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, // The convergence accuracy
+               ProgramEnv* env_p,
+               SolverWorkspace& workspace){ // Preallocated solver vectors
+    JacobiPreconditioner preconditioner( env_p);
+    preconditioner.setup( matrix);
+    return solverCG( matrix, right_part, print_debug, convergence_accuracy,
+        preconditioner, workspace);
+}
+/**
+ * A CG solver for a matrix
+ * The vectors are taken from the workspace, so after the workspace is
+ * prepared the iterations don't allocate memory
+ * The preconditioner must be set up for the matrix.
+ */
+SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy,     // The convergence accuracy
+               Preconditioner& preconditioner,  // z = M^-1 * r
+               SolverWorkspace& workspace){     // Preallocated solver vectors
 	/**
 	 * The variables for time measurement
 	 * Matter only if the time of the basic operations is measure.
@@ -15,33 +42,30 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
     double dotproduct_time = 0;
     double linearcombination_time = 0;
     double sparsemv_time = 0;
-    double start_measurement = 0;
-    double end_measurement = 0;
+    double preconditioner_time = 0;
 	// Matrix information
     size_t row_count = matrix.getNodesCount();
-    size_t not_null_cells = matrix.getEdgesCount();
+    workspace.prepare( row_count);
+    MathVector& initial_guess = workspace.getApproximation();
+    MathVector& r_iter = workspace.getR();
+    MathVector& z_iter = workspace.getZ();
+    MathVector& p_iter = workspace.getP();
+    MathVector& q_iter = workspace.getQ();
     // Generate an initial guess vector
-    MathVector initial_guess( row_count, env_p);
     for( size_t vec_idx = 0; vec_idx < row_count; ++vec_idx){
         initial_guess[vec_idx] = 0;
     }
     bool has_converged = false;
     size_t iteration_num = 1;
-    /** 
-     * Create a preconditioner matrix from a matrix,
-     * borrowing only a diagonal
-     */
-    NetGraph reverse_preconditioner = matrix.makeDiagonalMatrix( true);
-    MathVector current_approximation = sparseMVWithMeasure( matrix, initial_guess,
-    sparsemv_time);
-    MathVector r_iter = linearCombinationWithMeasure( right_part, current_approximation, 1,
-    -1, linearcombination_time);
+    // The current approximation is stored in the q vector
+    sparseMVWithMeasure( matrix, initial_guess, q_iter, sparsemv_time);
+    linearCombinationWithMeasure( right_part, q_iter, 1, -1, r_iter,
+    linearcombination_time);
     double rho_prev = 0, rho_iter = 0;
-    MathVector p_iter( r_iter.getVecLen(), env_p);
     // A conjugate gradient algorithm
     while( !has_converged ){
-        MathVector z_iter = sparseMVWithMeasure( reverse_preconditioner, r_iter,
-        sparsemv_time);
+        applyWithMeasure( preconditioner, r_iter, z_iter,
+        preconditioner_time);
         rho_prev = rho_iter;
         rho_iter = dotProductWithMeasure( r_iter, z_iter, dotproduct_time);
         if( iteration_num == 1 ){
@@ -52,9 +76,10 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
                 break;
             }
             double b_iter = rho_iter / rho_prev;
-            p_iter.copyValues( linearCombinationWithMeasure( z_iter, p_iter, 1, b_iter, linearcombination_time));
+            linearCombinationWithMeasure( z_iter, p_iter, 1, b_iter, p_iter,
+            linearcombination_time);
         }
-        MathVector q_iter = sparseMVWithMeasure( matrix, p_iter, sparsemv_time);
+        sparseMVWithMeasure( matrix, p_iter, q_iter, sparsemv_time);
         double pq_product = dotProductWithMeasure( p_iter, q_iter,
         dotproduct_time);
         if( !pq_product ){
@@ -62,10 +87,10 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
             break;
         }
         double alpha_iter = rho_iter / pq_product;
-        initial_guess.copyValues( linearCombinationWithMeasure( initial_guess, p_iter, 1,
-        alpha_iter, linearcombination_time));   
-        r_iter.copyValues( linearCombinationWithMeasure( r_iter, q_iter, 
-        1, -alpha_iter, linearcombination_time));
+        linearCombinationWithMeasure( initial_guess, p_iter, 1, alpha_iter,
+        initial_guess, linearcombination_time);
+        linearCombinationWithMeasure( r_iter, q_iter, 1, -alpha_iter, r_iter,
+        linearcombination_time);
         if( print_debug ){
             std::cout << "Iterations:" << iteration_num << " " << rho_iter << std::endl;
         }
@@ -85,6 +110,7 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
     std::cout << "Linear combination time: " << linearcombination_time <<
     std::endl;
     std::cout << "Sparse multiplication time: " << sparsemv_time << std::endl;
+    std::cout << "Preconditioner time: " << preconditioner_time << std::endl;
 #endif
     return SolverSolution( initial_guess, iteration_num, r_iter.calculateL2());
 }
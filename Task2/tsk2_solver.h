@@ -1,11 +1,16 @@
+#include <utility>
 #include "tsk2_vector.h"
+#include "tsk2_preconditioner.h"
 // A solver result
 class SolverSolution{
 public:
-    SolverSolution( MathVector approximate_solution, int iterations_number,
+    SolverSolution( MathVector&& approximate_solution, int iterations_number,
+        double solution_l2): approximate_solution_( std::move( approximate_solution)),
+        iterations_number_(iterations_number), solution_l2_(solution_l2) {}
+    SolverSolution( const MathVector& approximate_solution, int iterations_number,
         double solution_l2): approximate_solution_( approximate_solution),
         iterations_number_(iterations_number), solution_l2_(solution_l2) {}
-    MathVector getApproximateSolution(){
+    MathVector& getApproximateSolution(){
         return approximate_solution_;
     }
     int getIterationsNumber(){
@@ -22,6 +27,63 @@ private:
     // An l2 norm of the solution
     double solution_l2_;
 };
+/**
+ * The vectors used by the solver on every iteration.
+ * Allocate them once and reuse between the solves,
+ * so the solver loop doesn't allocate memory.
+ */
+class SolverWorkspace{
+public:
+    SolverWorkspace( size_t vec_len, ProgramEnv* env_p):
+        approximation_( vec_len, env_p), r_iter_( vec_len, env_p),
+        z_iter_( vec_len, env_p), p_iter_( vec_len, env_p),
+        q_iter_( vec_len, env_p) {}
+    /**
+     * Reallocate the vectors only if the system size has changed
+     */
+    void prepare( size_t vec_len){
+        if( approximation_.getVecLen() != vec_len ){
+            ProgramEnv* env_p = approximation_.getEnv();
+            approximation_ = MathVector( vec_len, env_p);
+            r_iter_ = MathVector( vec_len, env_p);
+            z_iter_ = MathVector( vec_len, env_p);
+            p_iter_ = MathVector( vec_len, env_p);
+            q_iter_ = MathVector( vec_len, env_p);
+        }
+    }
+    MathVector& getApproximation(){
+        return approximation_;
+    }
+    MathVector& getR(){
+        return r_iter_;
+    }
+    MathVector& getZ(){
+        return z_iter_;
+    }
+    MathVector& getP(){
+        return p_iter_;
+    }
+    MathVector& getQ(){
+        return q_iter_;
+    }
+private:
+    // The current approximation x_{k}
+    MathVector approximation_;
+    // A residual r_{k}
+    MathVector r_iter_;
+    // A preconditioned residual z_{k}
+    MathVector z_iter_;
+    // A search direction p_{k}
+    MathVector p_iter_;
+    // A product of the matrix and the search direction q_{k}
+    MathVector q_iter_;
+};
 
 SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
                double convergence_accuracy, ProgramEnv* env_p);
+SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, ProgramEnv* env_p,
+               SolverWorkspace& workspace);
+SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, Preconditioner& preconditioner,
+               SolverWorkspace& workspace);
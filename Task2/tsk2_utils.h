@@ -27,6 +27,7 @@ void printHelp(){
     std::cout << "File must be put at the same directory" << std::endl;
     std::cout << "-d enables a debug print" << std::endl;
     std::cout << "-t (--threads) specify a number of threads" << std::endl;
+    std::cout << "-g (--two-pass) generates the graph and fills it in two passes" << std::endl;
 }
 /**
  * Read the parameters from the file
@@ -86,6 +87,10 @@ int parseCMDArguments( int argc, char** argv,
         if( !strcmp( "-d", argv[arg_idx]) ){
             program_env_p->setDebugPrint( true);
         }
+        if( !strcmp( "--two-pass", argv[arg_idx]) || 
+            !strcmp( "-g", argv[arg_idx]) ){
+            program_env_p->setTwoPassFill( true);
+        }
     }
     return 0;
 }
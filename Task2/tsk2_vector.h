@@ -1,6 +1,7 @@
 #pragma once
 #ifndef MATHVECTOR_H
     #define MATHVECTOR_H
+#include <atomic>
 #include <cmath>
 #include <cassert>
 #include <iostream>
@@ -15,21 +16,52 @@ class MathVector{
 public:
 MathVector( size_t vec_len, ProgramEnv* env_p){
     values_ = new double[vec_len];
+    ++getAllocationsCount();
     vec_len_ = vec_len;
     env_p_ = env_p;
 }
 ~MathVector(){
-    delete values_;
+    delete[] values_;
 }
 MathVector( const MathVector& source){
     vec_len_ = source.getVecLen();
     values_ = new double[vec_len_];
+    ++getAllocationsCount();
     double* source_values = source.getValues();
     for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx ){
         values_[vec_idx] = source_values[vec_idx];
     }
     env_p_ = source.getEnv();
 }
+/**
+ * Take the values of a temporary vector without copying them
+ */
+MathVector( MathVector&& source){
+    vec_len_ = source.vec_len_;
+    values_ = source.values_;
+    env_p_ = source.env_p_;
+    source.vec_len_ = 0;
+    source.values_ = nullptr;
+}
+MathVector& operator=( MathVector&& source){
+    if( this != &source ){
+        delete[] values_;
+        vec_len_ = source.vec_len_;
+        values_ = source.values_;
+        env_p_ = source.env_p_;
+        source.vec_len_ = 0;
+        source.values_ = nullptr;
+    }
+    return *this;
+}
+/**
+ * A number of the arrays, that the vectors have taken.
+ * The solver tests check, that the iterations don't allocate vectors.
+ */
+static std::atomic<size_t>& getAllocationsCount(){
+    static std::atomic<size_t> allocations_count( 0);
+    return allocations_count;
+}
 /**
  * Access the values array through the subscript operator.
  */
@@ -107,6 +139,13 @@ double dotProduct( MathVector& vec_a, MathVector& vec_b);
 MathVector linearCombination( MathVector& vec_a, MathVector& vec_b, 
                    double alpha_coeff, double beta_coeff);
 MathVector sparseMV( NetGraph& graph, MathVector& vec);
+/**
+ * The variants of the operations, that write into the preallocated vector.
+ * They don't allocate memory, so they are used inside the solver loop.
+ */
+void linearCombination( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, MathVector& result);
+void sparseMV( NetGraph& graph, MathVector& vec, MathVector& result);
 /**
  * The wrappers over the basic operations.
  * Calculate the time of the basic operations and append it to the time.
@@ -116,4 +155,9 @@ time);
 MathVector linearCombinationWithMeasure( MathVector& vec_a, MathVector& vec_b, 
                    double alpha_coeff, double beta_coeff, double& time);
 MathVector sparseMVWithMeasure( NetGraph& graph, MathVector& vec, double& time);
+void linearCombinationWithMeasure( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, MathVector& result,
+                   double& time);
+void sparseMVWithMeasure( NetGraph& graph, MathVector& vec, MathVector& result,
+                   double& time);
 #endif
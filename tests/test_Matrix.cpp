@@ -0,0 +1,715 @@
+#include "../tsk1_dia.h"
+#include "../tsk1_sell.h"
+#include "../tsk1_stencil.h"
+#include "../tsk1_symmetric.h"
+#include "../tsk1_compressed.h"
+#include "../tsk1_reorder.h"
+#include "../tsk1_simd.h"
+#include "../tsk1_solver.h"
+/**
+ * A module for testing the storage formats of the matrix.
+ * Every format must give the same products, as the CSR graph.
+ */
+const double DOUBLE_COMPARISON_ACCURACY = 0.00001;
+/**
+ * Multiply the matrix in the diagonal format and the CSR graph
+ * of the same parameters to the vector
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testDiaMultiply( size_t row_len, size_t column_len,
+                               size_t not_divided, size_t divided){
+    MatrixParameters matrix_param( row_len, column_len, not_divided, divided);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    DiaMatrix dia_matrix( &matrix_param);
+    dia_matrix.generate( &matrix_param);
+    dia_matrix.fillMatrix();
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               dia_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    double dia_product = dia_matrix.multiplyDot( vec, dia_result);
+    bool has_failed = dia_matrix.getNodesCount() != nodes_count ||
+        fabs( graph_product - dia_product) >= DOUBLE_COMPARISON_ACCURACY;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_result[node_idx] - dia_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A DIA multiplication test failed" << std::endl;
+    }
+    return dia_product;
+}
+/**
+ * Solve the system with the matrix of a storage format and with the CSR
+ * graph, the solutions must be the same. The format is solved
+ * in the persistent region, if is_persistent is set. If the ordering is
+ * given, the matrix is the permuted graph: its right part is permuted and
+ * its solution is restored to the grid order. Its iterations aren't compared
+ * then, the sums of the permuted rows are rounded in another order.
+ * Results:
+ *      A number of iterations of the format
+ */
+static int checkFormatSolve( NetGraph& graph, MatrixOperator& matrix,
+                             const char* format_name, bool is_persistent,
+                             NodeOrdering* ordering_p = NULL){
+    size_t nodes_count = graph.getNodesCount();
+    MathVector b_vec( nodes_count);
+    b_vec.fillVector();
+    MathVector format_b( b_vec);
+    if( ordering_p ){
+        ordering_p->permuteVector( b_vec, format_b);
+    }
+    SolverSolution graph_solution = solverCG( graph, b_vec, false, 1e-10);
+    SolverSolution format_solution = is_persistent ?
+        solverCGPersistent( matrix, format_b, false, 1e-10) :
+        solverCG( matrix, format_b, false, 1e-10);
+    MathVector& graph_x = graph_solution.getApproximateSolution();
+    MathVector format_x( format_solution.getApproximateSolution());
+    if( ordering_p ){
+        ordering_p->restoreVector( format_solution.getApproximateSolution(),
+            format_x);
+    }
+    bool has_failed = !ordering_p && graph_solution.getIterationsNumber() !=
+        format_solution.getIterationsNumber();
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_x[node_idx] - format_x[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A " << format_name << " solver test failed" << std::endl;
+    }
+    return format_solution.getIterationsNumber();
+}
+/**
+ * Solve the system with the matrix in the diagonal format and in CSR
+ * Results:
+ *      A number of iterations
+ */
+static int testDiaSolver(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    DiaMatrix dia_matrix( &matrix_param);
+    dia_matrix.generate( &matrix_param);
+    dia_matrix.fillMatrix();
+    return checkFormatSolve( graph, dia_matrix, "DIA", false);
+}
+/**
+ * Multiply the matrix in the sliced ELLPACK format and the CSR graph
+ * to the vector with every supported instruction set.
+ * The graph has 3-7 cells in a row, so the chunks are padded.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testSellMultiply( size_t chunk_height, size_t sort_window){
+    MatrixParameters matrix_param( 13, 9, 2, 3);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    SellMatrix sell_matrix( graph, chunk_height, sort_window);
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               sell_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    MathVector graph_diagonal( nodes_count), sell_diagonal( nodes_count);
+    graph.copyDiagonal( graph_diagonal);
+    sell_matrix.copyDiagonal( sell_diagonal);
+    bool has_failed = sell_matrix.getCellsCount() < graph.getEdgesCount();
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( graph_diagonal[node_idx] != sell_diagonal[node_idx] ){
+            has_failed = true;
+        }
+    }
+    SimdIsa_t detected_isa = getSimdIsa();
+    double sell_product = 0;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        sell_product = sell_matrix.multiplyDot( vec, sell_result);
+        if( fabs( graph_product - sell_product) >= DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            if( fabs( graph_result[node_idx] - sell_result[node_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ){
+                has_failed = true;
+            }
+        }
+    }
+    setSimdIsa( detected_isa);
+    if( has_failed ){
+        std::cout << "A SELL multiplication test failed" << std::endl;
+    }
+    return sell_product;
+}
+/**
+ * Solve the system with the matrix in the sliced ELLPACK format and in CSR
+ * Results:
+ *      A number of iterations
+ */
+static int testSellSolver(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    SellMatrix sell_matrix( graph, getSimdWidth( getSimdIsa()), 64);
+    return checkFormatSolve( graph, sell_matrix, "SELL", true);
+}
+/**
+ * Multiply the matrix calculated on the fly and the CSR graph
+ * of the same parameters to the vector
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testStencilMultiply( size_t row_len, size_t column_len,
+                                   size_t not_divided, size_t divided){
+    MatrixParameters matrix_param( row_len, column_len, not_divided, divided);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    StencilMatrix stencil_matrix( &matrix_param);
+    stencil_matrix.fillDiagonal();
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               stencil_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    double stencil_product = stencil_matrix.multiplyDot( vec, stencil_result);
+    MathVector graph_diagonal( nodes_count), stencil_diagonal( nodes_count);
+    graph.copyDiagonal( graph_diagonal);
+    stencil_matrix.copyDiagonal( stencil_diagonal);
+    bool has_failed = stencil_matrix.getNodesCount() != nodes_count ||
+        fabs( graph_product - stencil_product) >= DOUBLE_COMPARISON_ACCURACY;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_result[node_idx] - stencil_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ||
+            graph_diagonal[node_idx] != stencil_diagonal[node_idx] ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A stencil multiplication test failed" << std::endl;
+    }
+    return stencil_product;
+}
+/**
+ * Multiply the upper triangle of the graph and the whole graph to the vector.
+ * The parts of the threads are shorter, than the bandwidth, if there are
+ * many threads, so the halo covers several parts.
+ * Then multiply the parts in the region of team_size threads, a team
+ * smaller than the parts takes several parts per thread.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testSymmetricMultiply( int threads_num, int team_size){
+    MatrixParameters matrix_param( 6, 11, 2, 3);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    SymmetricGraph symmetric_graph( graph);
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               symmetric_result( nodes_count), team_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads( threads_num);
+    double symmetric_product = symmetric_graph.multiplyDot( vec,
+        symmetric_result);
+    omp_set_num_threads( max_threads);
+    double team_product = 0;
+    #pragma omp parallel num_threads( team_size) reduction( +:team_product)
+    {
+        team_product += symmetric_graph.multiplyDotInRegion( vec, team_result);
+    }
+    bool has_failed = symmetric_graph.getEdgesCount() * 2 !=
+        graph.getEdgesCount() + nodes_count ||
+        fabs( graph_product - symmetric_product) >= DOUBLE_COMPARISON_ACCURACY ||
+        fabs( graph_product - team_product) >= DOUBLE_COMPARISON_ACCURACY;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_result[node_idx] - symmetric_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ||
+            fabs( graph_result[node_idx] - team_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A symmetric multiplication test failed" << std::endl;
+    }
+    return symmetric_product;
+}
+/**
+ * Solve the system with the upper triangle of the graph in the persistent
+ * region and with the whole graph
+ * Results:
+ *      A number of iterations
+ */
+static int testSymmetricSolver(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    SymmetricGraph symmetric_graph( graph);
+    return checkFormatSolve( graph, symmetric_graph, "symmetric", true);
+}
+/**
+ * Multiply the graphs with the 64-bit indices and with the float cells
+ * and the graph with the 32-bit indices to the vector
+ * with every supported instruction set. The float graph is multiplied
+ * to the float vector too, as the mixed precision solver does.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testWideMultiply( size_t row_len, size_t column_len,
+                                size_t not_divided, size_t divided){
+    const double FLOAT_COMPARISON_ACCURACY = 0.001;
+    MatrixParameters matrix_param( row_len, column_len, not_divided, divided);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    NetGraph64 wide_graph( &matrix_param);
+    wide_graph.generate( &matrix_param);
+    wide_graph.fillMatrix();
+    NetGraphT<int, float> float_graph( &matrix_param);
+    float_graph.generate( &matrix_param);
+    float_graph.fillMatrix();
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               wide_result( nodes_count), float_result( nodes_count);
+    vec.fillVector();
+    MathVectorFloat float_vec( nodes_count), float_vec_result( nodes_count);
+    float_vec.convertValues( vec);
+    bool has_failed = wide_graph.getEdgesCount() != graph.getEdgesCount();
+    for( size_t edge_idx = 0; edge_idx < graph.getEdgesCount(); ++edge_idx ){
+        if( wide_graph.getJA()[edge_idx] != graph.getJA()[edge_idx] ){
+            has_failed = true;
+        }
+    }
+    SimdIsa_t detected_isa = getSimdIsa();
+    setSimdIsa( SIMD_SCALAR);
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    double wide_product = 0;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        wide_product = wide_graph.multiplyDot( vec, wide_result);
+        double float_product = float_graph.multiplyDot( vec, float_result);
+        double float_vec_product = sparseMVDot( float_graph, float_vec,
+            float_vec_result);
+        if( fabs( graph_product - wide_product) >= DOUBLE_COMPARISON_ACCURACY ||
+            fabs( graph_product - float_product) >= FLOAT_COMPARISON_ACCURACY *
+            fabs( graph_product) ||
+            fabs( graph_product - float_vec_product) >=
+            FLOAT_COMPARISON_ACCURACY * fabs( graph_product) ){
+            has_failed = true;
+        }
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            if( fabs( graph_result[node_idx] - wide_result[node_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ||
+                fabs( graph_result[node_idx] - float_result[node_idx]) >=
+                FLOAT_COMPARISON_ACCURACY ||
+                fabs( graph_result[node_idx] - float_vec_result[node_idx]) >=
+                FLOAT_COMPARISON_ACCURACY ){
+                has_failed = true;
+            }
+        }
+    }
+    setSimdIsa( detected_isa);
+    if( has_failed ){
+        std::cout << "A wide index multiplication test failed" << std::endl;
+    }
+    return wide_product;
+}
+/**
+ * Solve the system with the graph with the 64-bit indices
+ * and with the 32-bit ones
+ * Results:
+ *      A number of iterations
+ */
+static int testWideSolver(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    NetGraph64 wide_graph( &matrix_param);
+    wide_graph.generate( &matrix_param);
+    wide_graph.fillMatrix();
+    return checkFormatSolve( graph, wide_graph, "wide index", true);
+}
+/**
+ * The largest grid has more cells, than int can index,
+ * but its nodes fit into int
+ * Results:
+ *      A number of the cells
+ */
+static size_t testWideIndexLimits(){
+    size_t max_dimension = MatrixParameters::MAX_MATRIX_DIMENSION;
+    MatrixParameters matrix_param( max_dimension, max_dimension, 1, 1);
+    size_t edges_count = NetGraph::countEdges( &matrix_param);
+    size_t nodes_count = (max_dimension + 1) * (max_dimension + 1);
+    if( NetGraph::isIndexFitting( edges_count) ||
+        !NetGraph64::isIndexFitting( edges_count) ||
+        !NetGraph::isIndexFitting( nodes_count) ){
+        std::cout << "A wide index limits test failed" << std::endl;
+    }
+    return edges_count;
+}
+/**
+ * Multiply the graph with the compressed columns and the graph
+ * to the vector with every supported instruction set
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testCompressedMultiply( size_t row_len, size_t column_len,
+                                      size_t delta_size){
+    MatrixParameters matrix_param( row_len, column_len, 2, 3);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    CompressedGraph compressed_graph( graph);
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               compressed_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    MathVector graph_diagonal( nodes_count),
+               compressed_diagonal( nodes_count);
+    graph.copyDiagonal( graph_diagonal);
+    compressed_graph.copyDiagonal( compressed_diagonal);
+    bool has_failed = compressed_graph.getDeltaSize() != delta_size ||
+        compressed_graph.getFallbackRowsCount() != 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( graph_diagonal[node_idx] != compressed_diagonal[node_idx] ){
+            has_failed = true;
+        }
+    }
+    SimdIsa_t detected_isa = getSimdIsa();
+    double compressed_product = 0;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        compressed_product = compressed_graph.multiplyDot( vec,
+            compressed_result);
+        if( fabs( graph_product - compressed_product) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            if( fabs( graph_result[node_idx] - compressed_result[node_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ){
+                has_failed = true;
+            }
+        }
+    }
+    setSimdIsa( detected_isa);
+    if( has_failed ){
+        std::cout << "A compressed multiplication test failed" << std::endl;
+    }
+    return compressed_product;
+}
+/**
+ * Multiply a tridiagonal graph, where the first and the last rows have
+ * the cells too far for the 16-bit deltas. The threads split the rows
+ * between the fallback rows.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testCompressedFallback( int threads_num){
+    const size_t nodes_count = 40000;
+    int* IA = allocateArray<int>( nodes_count + 1);
+    int* JA = allocateArray<int>( 3 * nodes_count);
+    double* A = allocateArray<double>( 3 * nodes_count);
+    size_t edge_idx = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        IA[node_idx] = edge_idx;
+        if( node_idx == nodes_count - 1 ){
+            JA[edge_idx++] = 0;
+        }
+        if( node_idx > 0 ){
+            JA[edge_idx++] = node_idx - 1;
+        }
+        JA[edge_idx++] = node_idx;
+        if( node_idx + 1 < nodes_count ){
+            JA[edge_idx++] = node_idx + 1;
+        }
+        if( node_idx == 0 ){
+            JA[edge_idx++] = nodes_count - 1;
+        }
+    }
+    IA[nodes_count] = edge_idx;
+    for( size_t cell_idx = 0; cell_idx < edge_idx; ++cell_idx ){
+        A[cell_idx] = cos( cell_idx);
+    }
+    NetGraph graph( nodes_count, edge_idx, IA, JA, A);
+    CompressedGraph compressed_graph( graph);
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               compressed_result( nodes_count);
+    vec.fillVector();
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads( threads_num);
+    double compressed_product = compressed_graph.multiplyDot( vec,
+        compressed_result);
+    omp_set_num_threads( max_threads);
+    bool has_failed = compressed_graph.getFallbackRowsCount() != 2 ||
+        compressed_graph.getDeltaSize() != sizeof( int16_t) ||
+        fabs( graph_product - compressed_product) >= DOUBLE_COMPARISON_ACCURACY;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_result[node_idx] - compressed_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A compressed fallback test failed" << std::endl;
+    }
+    return compressed_product;
+}
+/**
+ * Solve the system with the compressed columns in the persistent region
+ * and with the graph
+ * Results:
+ *      A number of iterations
+ */
+static int testCompressedSolver(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    CompressedGraph compressed_graph( graph);
+    return checkFormatSolve( graph, compressed_graph, "compressed", true);
+}
+/**
+ * Multiply the permuted graph to the permuted vector, the product
+ * restored to the grid order must be the product of the graph
+ * Results:
+ *      A bandwidth of the permuted graph
+ */
+static size_t testReorderedMultiply( size_t row_len, size_t column_len,
+                                     bool is_rcm){
+    MatrixParameters matrix_param( row_len, column_len, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    NodeOrdering ordering = is_rcm ?
+        makeRCMOrdering( graph) : makeMortonOrdering( &matrix_param);
+    NetGraph reordered_graph = ordering.permuteGraph( graph);
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), graph_result( nodes_count),
+               reordered_vec( nodes_count), reordered_result( nodes_count),
+               restored_result( nodes_count);
+    vec.fillVector();
+    ordering.permuteVector( vec, reordered_vec);
+    double graph_product = sparseMVDot( graph, vec, graph_result);
+    double reordered_product = sparseMVDot( reordered_graph, reordered_vec,
+        reordered_result);
+    ordering.restoreVector( reordered_result, restored_result);
+    bool has_failed = fabs( graph_product - reordered_product) >=
+        DOUBLE_COMPARISON_ACCURACY;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( fabs( graph_result[node_idx] - restored_result[node_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+        // The columns of a row stay sorted
+        int* IA = reordered_graph.getIA();
+        for( int edge_idx = IA[node_idx] + 1; edge_idx < IA[node_idx + 1];
+             ++edge_idx ){
+            if( reordered_graph.getJA()[edge_idx - 1] >=
+                reordered_graph.getJA()[edge_idx] ){
+                has_failed = true;
+            }
+        }
+    }
+    size_t bandwidth = calculateBandwidth( reordered_graph);
+    // The rows of the wide grid are longer, than the levels of RCM
+    if( is_rcm && row_len < column_len &&
+        bandwidth >= calculateBandwidth( graph) ){
+        has_failed = true;
+    }
+    if( has_failed ){
+        std::cout << "A reordered multiplication test failed" << std::endl;
+    }
+    return bandwidth;
+}
+/**
+ * Solve the system in the order of RCM, the solution restored
+ * to the grid order must be the solution of the graph
+ * Results:
+ *      A number of iterations
+ */
+static int testReorderedSolver(){
+    MatrixParameters matrix_param( 5, 60, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    NodeOrdering ordering = makeRCMOrdering( graph);
+    NetGraph reordered_graph = ordering.permuteGraph( graph);
+    return checkFormatSolve( graph, reordered_graph, "reordered", false,
+        &ordering);
+}
+/**
+ * Generate the graph with the coefficients in one pass and in two passes.
+ * The structure must be the same to the bit, the coefficients differ
+ * by the cosines of the vectorized kernel, by 1 ulp at most
+ * Results:
+ *      A number of the different cells
+ */
+template <typename Index_t, typename Value_t>
+static size_t testFilledGeneration( size_t row_len, size_t column_len,
+                                    size_t not_divided, size_t divided){
+    MatrixParameters matrix_param( row_len, column_len, not_divided, divided);
+    NetGraphT<Index_t, Value_t> graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    NetGraphT<Index_t, Value_t> filled_graph( &matrix_param);
+    filled_graph.generateFilled( &matrix_param);
+    size_t different_cells = 0;
+    for( size_t node_idx = 0; node_idx <= graph.getNodesCount(); ++node_idx ){
+        if( graph.getIA()[node_idx] != filled_graph.getIA()[node_idx] ){
+            ++different_cells;
+        }
+    }
+    for( size_t edge_idx = 0; edge_idx < graph.getEdgesCount(); ++edge_idx ){
+        double cell = graph.getA()[edge_idx];
+        // The diagonal sums the differences of the row
+        if( graph.getJA()[edge_idx] != filled_graph.getJA()[edge_idx] ||
+            fabs( cell - filled_graph.getA()[edge_idx]) > ( 1 + fabs( cell)) *
+            4 * std::numeric_limits<Value_t>::epsilon() ){
+            ++different_cells;
+        }
+    }
+    if( different_cells != 0 ){
+        std::cout << "A filled generation test failed" << std::endl;
+    }
+    return different_cells;
+}
+/**
+ * Generate the filled graph and multiply the stencil matrix
+ * by the generator of the pattern and by the generic one.
+ * The generators take the same cells in the same order,
+ * so the graphs and the results must be the same to the bit
+ * Results:
+ *      A number of the different cells
+ */
+static size_t testPatternGeneration( size_t row_len, size_t column_len,
+                                     size_t not_divided, size_t divided){
+    MatrixParameters matrix_param( row_len, column_len, not_divided, divided);
+    MatrixParameters generic_param( row_len, column_len, not_divided, divided);
+    generic_param.setGenericPattern( true);
+    NetGraph graph( &matrix_param);
+    graph.generateFilled( &matrix_param);
+    NetGraph generic_graph( &generic_param);
+    generic_graph.generateFilled( &generic_param);
+    size_t different_cells = 0;
+    for( size_t node_idx = 0; node_idx <= graph.getNodesCount(); ++node_idx ){
+        if( graph.getIA()[node_idx] != generic_graph.getIA()[node_idx] ){
+            ++different_cells;
+        }
+    }
+    for( size_t edge_idx = 0; edge_idx < graph.getEdgesCount(); ++edge_idx ){
+        if( graph.getJA()[edge_idx] != generic_graph.getJA()[edge_idx] ||
+            graph.getA()[edge_idx] != generic_graph.getA()[edge_idx] ){
+            ++different_cells;
+        }
+    }
+    StencilMatrix stencil_matrix( &matrix_param);
+    stencil_matrix.fillDiagonal();
+    StencilMatrix generic_matrix( &generic_param);
+    generic_matrix.fillDiagonal();
+    size_t nodes_count = graph.getNodesCount();
+    MathVector vec( nodes_count), stencil_result( nodes_count),
+               generic_result( nodes_count);
+    vec.fillVector();
+    double stencil_product = stencil_matrix.multiplyDot( vec, stencil_result);
+    double generic_product = generic_matrix.multiplyDot( vec, generic_result);
+    // The threads sum the dot product in any order
+    if( fabs( stencil_product - generic_product) >= DOUBLE_COMPARISON_ACCURACY ){
+        ++different_cells;
+    }
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( stencil_result[node_idx] != generic_result[node_idx] ){
+            ++different_cells;
+        }
+    }
+    if( different_cells != 0 ){
+        std::cout << "A pattern generation test failed" << std::endl;
+    }
+    return different_cells;
+}
+/**
+ * Launch all tests
+ */
+void launchMatrixTests(){
+    // All divided, none divided, alternating, and a single row or column
+    testPatternGeneration( 7, 9, 0, 1);
+    testPatternGeneration( 9, 7, 1, 0);
+    testPatternGeneration( 8, 11, 1, 1);
+    testPatternGeneration( 0, 5, 1, 1);
+    testPatternGeneration( 5, 0, 0, 2);
+    testPatternGeneration( 0, 0, 1, 0);
+    testFilledGeneration<int, double>( 7, 9, 3, 2);
+    testFilledGeneration<int, double>( 1, 2, 1, 1);
+    testFilledGeneration<int64_t, double>( 40, 30, 0, 1);
+    testFilledGeneration<int, float>( 30, 40, 1, 0);
+    // The arguments of the slow reduction of libm
+    testFilledGeneration<int, double>( 300, 2000, 3, 2);
+    testDiaMultiply( 7, 9, 3, 2);
+    // The grid is smaller, than the diagonals offsets
+    testDiaMultiply( 1, 2, 1, 1);
+    // The rows of several blocks
+    testDiaMultiply( 150, 70, 5, 7);
+    testDiaSolver();
+    // The rows keep the order, the chunk of the last rows is partial
+    testSellMultiply( 4, 1);
+    testSellMultiply( 8, 32);
+    // The chunks are narrower, than the AVX-512 register
+    testSellMultiply( 12, 1000);
+    testSellSolver();
+    testStencilMultiply( 7, 9, 3, 2);
+    testStencilMultiply( 1, 2, 1, 1);
+    testStencilMultiply( 40, 30, 4, 5);
+    testSymmetricMultiply( 1, 1);
+    testSymmetricMultiply( 3, 3);
+    testSymmetricMultiply( 16, 16);
+    // The teams smaller than the parts
+    testSymmetricMultiply( 3, 2);
+    testSymmetricMultiply( 16, 3);
+    testSymmetricSolver();
+    testWideMultiply( 7, 9, 3, 2);
+    // The rows are longer, than the gather of AVX2
+    testWideMultiply( 40, 30, 1, 1);
+    testWideSolver();
+    testWideIndexLimits();
+    // The 8-bit deltas, the 16-bit deltas
+    testCompressedMultiply( 7, 9, sizeof( int8_t));
+    testCompressedMultiply( 30, 200, sizeof( int16_t));
+    testCompressedFallback( 1);
+    testCompressedFallback( 4);
+    testCompressedSolver();
+    // RCM of the wide grid, the tall grid, the grid of one node
+    testReorderedMultiply( 5, 60, true);
+    testReorderedMultiply( 60, 5, true);
+    testReorderedMultiply( 0, 0, true);
+    // The Morton curve
+    testReorderedMultiply( 7, 9, false);
+    testReorderedMultiply( 0, 0, false);
+    testReorderedSolver();
+}
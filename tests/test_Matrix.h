@@ -0,0 +1,4 @@
+/**
+ * A header file for the matrix formats tests
+ */
+void launchMatrixTests();
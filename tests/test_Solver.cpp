@@ -0,0 +1,511 @@
+#include <algorithm>
+#include "../tsk1_solver.h"
+#include "../tsk1_simd.h"
+#include "../tsk1_multigrid.h"
+/**
+ * A module for testing the solver
+ */
+const double DOUBLE_COMPARISON_ACCURACY = 0.00001;
+/**
+ * Count the arrays, that the program has taken.
+ * The solver tests check, that the iterations don't allocate memory:
+ * the vectors and the matrices take their arrays by allocateArray().
+ */
+static size_t countArrayAllocations(){
+    const ArenaStatistics& statistics =
+        MemoryArena::getArena().getStatistics();
+    return statistics.arena_allocations_ + statistics.heap_allocations_;
+}
+/**
+ * Solve the same system twice with the different accuracy.
+ * The number of iterations differs, but the number of allocations must not.
+ * Results:
+ *      A number of allocations per solve
+ */
+static size_t testSolverAllocations(){
+    MatrixParameters matrix_param( 20, 20, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverWorkspace workspace( graph.getNodesCount());
+    // Warm up the workspace
+    solverCG( graph, b_vec, false, 1e-2, workspace);
+    size_t start_count = countArrayAllocations();
+    SolverSolution coarse_solution = solverCG( graph, b_vec, false, 1e-2,
+        workspace);
+    size_t coarse_count = countArrayAllocations() - start_count;
+    start_count = countArrayAllocations();
+    SolverSolution fine_solution = solverCG( graph, b_vec, false, 1e-12,
+        workspace);
+    size_t fine_count = countArrayAllocations() - start_count;
+    if( coarse_solution.getIterationsNumber() >=
+        fine_solution.getIterationsNumber() || coarse_count != fine_count ){
+        std::cout << "A solver allocation test failed" << std::endl;
+    }
+    return fine_count;
+}
+/**
+ * Compare the solver in one parallel region with the default solver
+ * Results:
+ *      A control value( the difference between the solutions)
+ */
+static double testSolverPersistent(){
+    MatrixParameters matrix_param( 20, 30, 1, 1);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverSolution solution = solverCG( graph, b_vec, false, 1e-10);
+    SolverSolution persistent_solution = solverCGPersistent( graph, b_vec,
+        false, 1e-10);
+    MathVector& approximation = solution.getApproximateSolution();
+    MathVector& persistent_approximation =
+        persistent_solution.getApproximateSolution();
+    double max_difference = 0;
+    for( size_t vec_idx = 0; vec_idx < approximation.getVecLen(); ++vec_idx ){
+        max_difference = std::max( max_difference,
+            fabs( approximation[vec_idx] - persistent_approximation[vec_idx]));
+    }
+    if( max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A persistent region solver test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Run the solver in one parallel region with a team, that has less threads
+ * than the parts of the rows. The partition is made for omp_get_max_threads()
+ * parts, but the region is nested in an outer one, so it gets one thread.
+ * Results:
+ *      A control value( the difference from the default solution)
+ */
+static double testSolverReducedTeam(){
+    MatrixParameters matrix_param( 20, 30, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverSolution solution = solverCG( graph, b_vec, false, 1e-10);
+    MathVector& approximation = solution.getApproximateSolution();
+    int max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels( 1);
+    double max_difference = 0;
+    bool has_failed = false;
+    #pragma omp parallel num_threads( 2)
+    {
+        #pragma omp single
+        {
+            omp_set_num_threads( 4);
+            SolverSolution reduced_solution = solverCGPersistent( graph,
+                b_vec, false, 1e-10);
+            MathVector& reduced_approximation =
+                reduced_solution.getApproximateSolution();
+            for( size_t vec_idx = 0; vec_idx < approximation.getVecLen();
+                 ++vec_idx ){
+                max_difference = std::max( max_difference,
+                    fabs( approximation[vec_idx] -
+                    reduced_approximation[vec_idx]));
+            }
+            has_failed = reduced_solution.getIterationsNumber() !=
+                solution.getIterationsNumber();
+        }
+    }
+    omp_set_max_active_levels( max_active_levels);
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A reduced team solver test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Solve the system with the mixed precision solver to the accuracy,
+ * that the float iterations alone don't reach, with the kernels
+ * of every supported instruction set
+ * Results:
+ *      A control value( the maximum difference from the double solution)
+ */
+static double testSolverMixed(){
+    MatrixParameters matrix_param( 20, 30, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverSolution solution = solverCG( graph, b_vec, false, 1e-14);
+    MathVector& approximation = solution.getApproximateSolution();
+    SimdIsa_t detected_isa = getSimdIsa();
+    double max_difference = 0;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        SolverSolution mixed_solution = solverCGMixed( graph, b_vec, false,
+            1e-14);
+        MathVector& mixed_approximation = mixed_solution.getApproximateSolution();
+        double isa_difference = 0;
+        for( size_t vec_idx = 0; vec_idx < approximation.getVecLen();
+             ++vec_idx ){
+            isa_difference = std::max( isa_difference,
+                fabs( approximation[vec_idx] - mixed_approximation[vec_idx]));
+        }
+        if( isa_difference >= 1e-6 ){
+            std::cout << "A mixed precision solver test failed on " <<
+            getSimdIsaName( static_cast<SimdIsa_t>( isa)) << std::endl;
+        }
+        max_difference = std::max( max_difference, isa_difference);
+    }
+    setSimdIsa( detected_isa);
+    return max_difference;
+}
+/**
+ * The Jacobi preconditioner, that implements only the apply,
+ * so the solver takes the default operations of the interface
+ */
+class ApplyOnlyJacobi: public Preconditioner{
+public:
+    ApplyOnlyJacobi(): diagonal_( 0) {}
+    void setup( MatrixOperator& matrix){
+        diagonal_ = MathVector( matrix.getNodesCount());
+        matrix.copyDiagonal( diagonal_);
+    }
+    void apply( MathVector& residual, MathVector& result){
+        for( size_t vec_idx = 0; vec_idx < residual.getVecLen(); ++vec_idx ){
+            result[vec_idx] = residual[vec_idx] / diagonal_[vec_idx];
+        }
+    }
+private:
+    MathVector diagonal_;
+};
+/**
+ * Solve the system with the fused Jacobi preconditioner and with
+ * the one, that only applies, in the default and the persistent solvers
+ * Results:
+ *      A control value( the maximum difference between the solutions)
+ */
+static double testSolverPreconditioner(){
+    MatrixParameters matrix_param( 20, 30, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverWorkspace workspace( graph.getNodesCount());
+    JacobiPreconditioner jacobi;
+    jacobi.setup( graph);
+    ApplyOnlyJacobi apply_only;
+    apply_only.setup( graph);
+    SolverSolution solution = solverCG( graph, b_vec, false, 1e-10, jacobi,
+        workspace);
+    SolverSolution solutions[] = {
+        solverCG( graph, b_vec, false, 1e-10, apply_only, workspace),
+        solverCG( graph, b_vec, false, 1e-10, apply_only, workspace, false),
+        solverCGPersistent( graph, b_vec, false, 1e-10, jacobi, workspace),
+        solverCGPersistent( graph, b_vec, false, 1e-10, apply_only, workspace)
+    };
+    MathVector& approximation = solution.getApproximateSolution();
+    double max_difference = 0;
+    bool has_failed = false;
+    for( size_t solution_idx = 0; solution_idx < 4; ++solution_idx ){
+        MathVector& other_approximation =
+            solutions[solution_idx].getApproximateSolution();
+        for( size_t vec_idx = 0; vec_idx < approximation.getVecLen();
+             ++vec_idx ){
+            max_difference = std::max( max_difference,
+                fabs( approximation[vec_idx] - other_approximation[vec_idx]));
+        }
+        if( solutions[solution_idx].getIterationsNumber() !=
+            solution.getIterationsNumber() ){
+            has_failed = true;
+        }
+    }
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A preconditioner solver test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Solve the graph with the right part of fillVector() by the Jacobi solver
+ * Results:
+ *      A number of iterations, the bound of the stronger preconditioners
+ */
+static int countJacobiIterations( NetGraph& graph){
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    return solverCG( graph, b_vec, false, 1e-10).getIterationsNumber();
+}
+/**
+ * Solve the graph with the preconditioner, that is set up for it,
+ * in the default and the persistent solvers. They must give the same
+ * solution in the same number of iterations, and the number must not exceed
+ * max_iterations. max_difference is raised to the difference of the solutions.
+ * Results:
+ *      true, if the solve failed
+ */
+static bool checkPreconditionedSolve( NetGraph& graph,
+                                      Preconditioner& preconditioner,
+                                      int max_iterations,
+                                      double& max_difference){
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+    SolverWorkspace workspace( graph.getNodesCount());
+    SolverSolution solution = solverCG( graph, b_vec, false, 1e-10,
+        preconditioner, workspace);
+    SolverSolution persistent_solution = solverCGPersistent( graph, b_vec,
+        false, 1e-10, preconditioner, workspace);
+    MathVector& approximation = solution.getApproximateSolution();
+    MathVector& persistent_approximation =
+        persistent_solution.getApproximateSolution();
+    for( size_t vec_idx = 0; vec_idx < approximation.getVecLen(); ++vec_idx ){
+        max_difference = std::max( max_difference,
+            fabs( approximation[vec_idx] - persistent_approximation[vec_idx]));
+    }
+    return solution.getIterationsNumber() !=
+        persistent_solution.getIterationsNumber() ||
+        solution.getIterationsNumber() > max_iterations;
+}
+/**
+ * Factorize the graph of one row of the grid: its matrix is tridiagonal,
+ * IC(0) drops no cells, so the preconditioner is the inverse matrix.
+ * Then solve the grid with IC(0) in the default and the persistent solvers,
+ * they must take no more iterations, than the Jacobi solver.
+ * Results:
+ *      A control value( the maximum difference from the exact solution)
+ */
+static double testIncompleteCholesky(){
+    MatrixParameters line_param( 0, 40, 1, 0);
+    NetGraph line_graph( &line_param);
+    line_graph.generate( &line_param);
+    line_graph.fillMatrix();
+    MathVector x_vec( line_graph.getNodesCount());
+    x_vec.fillVector();
+    MathVector line_b( line_graph.getNodesCount());
+    line_graph.multiply( x_vec, line_b);
+    IncompleteCholeskyPreconditioner line_cholesky( line_graph);
+    line_cholesky.setup( line_graph);
+    MathVector line_result( line_graph.getNodesCount());
+    line_cholesky.apply( line_b, line_result);
+    double max_difference = 0;
+    for( size_t vec_idx = 0; vec_idx < x_vec.getVecLen(); ++vec_idx ){
+        max_difference = std::max( max_difference,
+            fabs( x_vec[vec_idx] - line_result[vec_idx]));
+    }
+    bool has_failed = max_difference >= DOUBLE_COMPARISON_ACCURACY ||
+        line_cholesky.getLevelsCount() != line_graph.getNodesCount();
+    MatrixParameters matrix_param( 20, 30, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    IncompleteCholeskyPreconditioner cholesky( graph);
+    cholesky.setup( graph);
+    has_failed = checkPreconditionedSolve( graph, cholesky,
+        countJacobiIterations( graph), max_difference) || has_failed;
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "An incomplete Cholesky test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Color the grid, the neighbors must have the different colors.
+ * Apply SSOR and multiply the result by
+ *      M = ( D / w + L) * ( D / w)^-1 * ( D / w + U) / ( 2 - w),
+ * L and U are taken by the colors, it must be the residual.
+ * Then solve the grid with SSOR in the default and the persistent solvers,
+ * they must take no more iterations, than the Jacobi solver.
+ * Results:
+ *      A control value( the maximum difference from the residual)
+ */
+static double testMulticolorSSOR(){
+    const double relaxation = 1.3;
+    MatrixParameters matrix_param( 20, 30, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    size_t nodes_count = graph.getNodesCount();
+    MulticolorSSORPreconditioner ssor( graph, relaxation);
+    ssor.setup( graph);
+    MathVector b_vec( nodes_count);
+    b_vec.fillVector();
+    MathVector result( nodes_count);
+    ssor.apply( b_vec, result);
+    int* IA = graph.getIA();
+    int* JA = graph.getJA();
+    double* A = graph.getA();
+    bool has_failed = ssor.getColorsCount() > 5;
+    // The products by the triangles go in the both directions
+    MathVector diagonal( nodes_count);
+    graph.copyDiagonal( diagonal);
+    MathVector upper_product( nodes_count);
+    MathVector lower_product( nodes_count);
+    for( size_t direction = 0; direction < 2; ++direction ){
+        MathVector& source = direction == 0 ? result : upper_product;
+        MathVector& product = direction == 0 ? upper_product : lower_product;
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            int node_color = ssor.getNodeColor( node_idx);
+            double row_sum = diagonal[node_idx] / relaxation *
+                source[node_idx];
+            size_t end_idx = IA[node_idx + 1];
+            for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+                 ++edge_idx ){
+                int column_color = ssor.getNodeColor( JA[edge_idx]);
+                if( JA[edge_idx] != static_cast<int>( node_idx) &&
+                    column_color == node_color ){
+                    has_failed = true;
+                }
+                if( ( direction == 0 && column_color > node_color) ||
+                    ( direction == 1 && column_color < node_color) ){
+                    row_sum += A[edge_idx] * source[JA[edge_idx]];
+                }
+            }
+            product[node_idx] = row_sum;
+        }
+        // ( D / w)^-1 is between the triangles
+        if( direction == 0 ){
+            for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+                upper_product[node_idx] *= relaxation / diagonal[node_idx];
+            }
+        }
+    }
+    double max_difference = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        max_difference = std::max( max_difference, fabs( b_vec[node_idx] -
+            lower_product[node_idx] / ( 2 - relaxation)));
+    }
+    has_failed = checkPreconditionedSolve( graph, ssor,
+        countJacobiIterations( graph), max_difference) || has_failed;
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A multicolor SSOR test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Test the multigrid: the sparse product matches the products
+ * by a vector, the multigrid of one level is the exact solve,
+ * and CG with the V-cycle takes no more iterations, than with Jacobi
+ */
+static double testGeometricMultigrid(){
+    MatrixParameters small_param( 10, 12, 3, 2);
+    NetGraph small_graph( &small_param);
+    small_graph.generate( &small_param);
+    small_graph.fillMatrix();
+    size_t small_count = small_graph.getNodesCount();
+    SparseMatrix small_matrix( small_graph);
+    SparseMatrix* transposed_p = transposeSparse( small_matrix);
+    SparseMatrix* product_p = multiplySparse( small_matrix, *transposed_p);
+    MathVector x_vec( small_count);
+    x_vec.fillVector();
+    MathVector transposed_x( small_count);
+    MathVector twice_x( small_count);
+    MathVector product_x( small_count);
+    #pragma omp parallel
+    {
+        transposed_p->multiplyInRegion( x_vec.getValues(),
+            transposed_x.getValues());
+        small_matrix.multiplyInRegion( transposed_x.getValues(),
+            twice_x.getValues());
+        product_p->multiplyInRegion( x_vec.getValues(),
+            product_x.getValues());
+    }
+    double max_difference = 0;
+    for( size_t node_idx = 0; node_idx < small_count; ++node_idx ){
+        max_difference = std::max( max_difference, fabs( twice_x[node_idx] -
+            product_x[node_idx]) / ( 1 + fabs( twice_x[node_idx])));
+    }
+    delete product_p;
+    delete transposed_p;
+    // The small grid is the coarsest level
+    GeometricMultigridPreconditioner small_multigrid( small_graph,
+        &small_param);
+    small_multigrid.setup( small_graph);
+    MathVector exact_result( small_count);
+    small_multigrid.apply( x_vec, exact_result);
+    small_graph.multiply( exact_result, product_x);
+    for( size_t node_idx = 0; node_idx < small_count; ++node_idx ){
+        max_difference = std::max( max_difference, fabs( x_vec[node_idx] -
+            product_x[node_idx]));
+    }
+    bool has_failed = small_multigrid.getLevelsCount() != 1;
+    MatrixParameters matrix_param( 40, 50, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    GeometricMultigridPreconditioner multigrid( graph, &matrix_param);
+    multigrid.setup( graph);
+    has_failed = has_failed || multigrid.getLevelsCount() < 3;
+    has_failed = checkPreconditionedSolve( graph, multigrid,
+        countJacobiIterations( graph), max_difference) || has_failed;
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A geometric multigrid test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Test the smoothed aggregation: the levels don't depend on the number
+ * of the threads, CG with the V-cycle takes no more iterations, than
+ * with Jacobi, and a graph without the strong connections isn't coarsened,
+ * its one level is smoothed
+ */
+static double testSmoothedAggregation(){
+    MatrixParameters matrix_param( 40, 50, 3, 2);
+    NetGraph graph( &matrix_param);
+    graph.generate( &matrix_param);
+    graph.fillMatrix();
+    SmoothedAggregationPreconditioner aggregation( graph);
+    int max_threads = omp_get_max_threads();
+    omp_set_num_threads( 3);
+    aggregation.setup( graph);
+    size_t threads_levels = aggregation.getLevelsCount();
+    double threads_complexity = aggregation.getOperatorComplexity();
+    omp_set_num_threads( 1);
+    aggregation.setup( graph);
+    omp_set_num_threads( max_threads);
+    bool has_failed = aggregation.getLevelsCount() < 2 ||
+        aggregation.getLevelsCount() != threads_levels ||
+        aggregation.getOperatorComplexity() != threads_complexity;
+    double max_difference = 0;
+    has_failed = checkPreconditionedSolve( graph, aggregation,
+        countJacobiIterations( graph), max_difference) || has_failed;
+    // The Jacobi sweep of the diagonal matrix is the exact solve
+    const size_t diagonal_count = 1000;
+    int* IA = allocateArray<int>( diagonal_count + 1);
+    int* JA = allocateArray<int>( diagonal_count);
+    double* A = allocateArray<double>( diagonal_count);
+    for( size_t node_idx = 0; node_idx < diagonal_count; ++node_idx ){
+        IA[node_idx] = node_idx;
+        JA[node_idx] = node_idx;
+        A[node_idx] = node_idx + 1;
+    }
+    IA[diagonal_count] = diagonal_count;
+    NetGraph diagonal_graph( diagonal_count, diagonal_count, IA, JA, A);
+    SmoothedAggregationPreconditioner diagonal_aggregation( diagonal_graph);
+    diagonal_aggregation.setup( diagonal_graph);
+    MathVector diagonal_b( diagonal_count);
+    diagonal_b.fillVector();
+    MathVector diagonal_result( diagonal_count);
+    diagonal_aggregation.apply( diagonal_b, diagonal_result);
+    for( size_t node_idx = 0; node_idx < diagonal_count; ++node_idx ){
+        max_difference = std::max( max_difference, fabs( diagonal_b[node_idx] -
+            A[node_idx] * diagonal_result[node_idx]));
+    }
+    has_failed = has_failed || diagonal_aggregation.getLevelsCount() != 1;
+    if( has_failed || max_difference >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A smoothed aggregation test failed" << std::endl;
+    }
+    return max_difference;
+}
+/**
+ * Launch all tests
+ */
+void launchSolverTests(){
+    testSolverAllocations();
+    testSolverPersistent();
+    testSolverReducedTeam();
+    testSolverMixed();
+    testSolverPreconditioner();
+    testIncompleteCholesky();
+    testMulticolorSSOR();
+    testGeometricMultigrid();
+    testSmoothedAggregation();
+}
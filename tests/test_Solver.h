@@ -0,0 +1,4 @@
+/**
+ * A header file for the solver tests
+ */
+void launchSolverTests();
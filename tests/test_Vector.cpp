@@ -1,4 +1,11 @@
+#include <stdint.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
 #include "../tsk1_vector.h"
+#include "../tsk1_preconditioner.h"
+#include "../tsk1_simd.h"
+#include "../tsk1_memory.h"
 /**
  * A module for testing the vector
  */
@@ -55,15 +62,16 @@ static double testSparseMV(){
      * Matrix: [0 3] * [5]
      *         [2 0]   [6]
      */
-    int* IA = new int[3];
-    int* JA = new int[3];
-    double* A = new double[3];
+    int* IA = allocateArray<int>( 3);
+    int* JA = allocateArray<int>( 3);
+    double* A = allocateArray<double>( 3);
     IA[0] = 0;
     IA[1] = 1;
     JA[0] = 1;
     JA[1] = 0;
     A[0] = 3.0;
     A[1] = 2.0;
+    IA[2] = 2;
     NetGraph graph( 2, 2, IA, JA, A);
     MathVector vec_mult(2);
     vec_mult[0] = 5;
@@ -81,6 +89,317 @@ static double testSparseMV(){
     }
     return sparse_mult[0] + sparse_mult[1];
 }
+/**
+ * A test of the sparse multiplication fused with a dot product
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testSparseMVDot(){
+    /**
+     * Matrix: [0 3] * [5]
+     *         [2 0]   [6]
+     */
+    int* IA = allocateArray<int>( 3);
+    int* JA = allocateArray<int>( 3);
+    double* A = allocateArray<double>( 3);
+    IA[0] = 0;
+    IA[1] = 1;
+    JA[0] = 1;
+    JA[1] = 0;
+    A[0] = 3.0;
+    A[1] = 2.0;
+    IA[2] = 2;
+    NetGraph graph( 2, 2, IA, JA, A);
+    MathVector vec_mult(2), sparse_mult(2);
+    vec_mult[0] = 5;
+    vec_mult[1] = 6;
+    double res_product = 5 * 18 + 6 * 10;
+    double dot_product = sparseMVDot( graph, vec_mult, sparse_mult);
+    if ( fabs( dot_product - res_product) >= DOUBLE_COMPARISON_ACCURACY ||
+         fabs( sparse_mult[0] - 18) >= DOUBLE_COMPARISON_ACCURACY ||
+         fabs( sparse_mult[1] - 10) >= DOUBLE_COMPARISON_ACCURACY ){
+        std::cout << "A fused sparse MV test failed" << std::endl;
+    }
+    return dot_product;
+}
+/**
+ * A test of the fused solver vectors update of the Jacobi preconditioner,
+ * in one call and in a persistent parallel region
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testUpdateApplyDot(){
+    // Matrix: diag( 2, 4)
+    int* IA = allocateArray<int>( 3);
+    int* JA = allocateArray<int>( 2);
+    double* A = allocateArray<double>( 2);
+    IA[0] = 0;
+    IA[1] = 1;
+    IA[2] = 2;
+    JA[0] = 0;
+    JA[1] = 1;
+    A[0] = 2.0;
+    A[1] = 4.0;
+    NetGraph graph( 2, 2, IA, JA, A);
+    JacobiPreconditioner preconditioner;
+    preconditioner.setup( graph);
+    double alpha_coeff = 0.5;
+    // r = (-0.5, 0), z = (-0.25, 0)
+    double res_product = 0.125;
+    double dot_product = 0;
+    bool has_failed = false;
+    for( int is_region = 0; is_region < 2; ++is_region ){
+        MathVector approximation(2), residual(2), direction(2),
+                   matrix_direction(2), preconditioned_residual(2);
+        approximation[0] = 1;
+        approximation[1] = 2;
+        residual[0] = 3;
+        residual[1] = 4;
+        direction[0] = 5;
+        direction[1] = 6;
+        matrix_direction[0] = 7;
+        matrix_direction[1] = 8;
+        if( is_region ){
+            dot_product = 0;
+            #pragma omp parallel reduction( +:dot_product)
+            dot_product += preconditioner.updateApplyDotInRegion(
+                approximation, residual, direction, matrix_direction,
+                alpha_coeff, preconditioned_residual);
+        } else{
+            dot_product = preconditioner.updateApplyDot( approximation,
+                residual, direction, matrix_direction, alpha_coeff,
+                preconditioned_residual);
+        }
+        if ( fabs( dot_product - res_product) >= DOUBLE_COMPARISON_ACCURACY ||
+             fabs( approximation[0] - 3.5) >= DOUBLE_COMPARISON_ACCURACY ||
+             fabs( approximation[1] - 5) >= DOUBLE_COMPARISON_ACCURACY ||
+             fabs( preconditioned_residual[0] + 0.25) >=
+             DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A fused update test failed" << std::endl;
+    }
+    return dot_product;
+}
+/**
+ * Evaluate the expressions of the solver and compare them
+ * with the basic operations. The assigned vectors are in the expressions.
+ * Results:
+ *      A control value( the fused dot product)
+ */
+static double testVectorExpressions(){
+    const size_t vec_len = 1003;
+    MathVector approximation( vec_len), residual( vec_len),
+               direction( vec_len), matrix_direction( vec_len),
+               preconditioned_residual( vec_len), diagonal( vec_len),
+               res_direction( vec_len);
+    MathVectorFloat float_vec( vec_len), float_result( vec_len);
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        approximation[vec_idx] = sin( vec_idx);
+        residual[vec_idx] = cos( vec_idx);
+        direction[vec_idx] = sin( 2 * vec_idx);
+        matrix_direction[vec_idx] = cos( 3 * vec_idx);
+        diagonal[vec_idx] = 1.0 / ( vec_idx % 5 + 1);
+    }
+    float_vec.convertValues( residual);
+    linearCombination( residual, direction, 1, 0.5, res_direction);
+    // p = z + b*p
+    direction = residual + 0.5 * direction;
+    double alpha_coeff = 0.25;
+    MathVector res_approximation( approximation), res_residual( residual);
+    linearCombination( approximation, direction, 1, alpha_coeff,
+        res_approximation);
+    linearCombination( residual, matrix_direction, 1, -alpha_coeff,
+        res_residual);
+    double res_product = 0;
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        res_product += res_residual[vec_idx] * res_residual[vec_idx] *
+            diagonal[vec_idx];
+    }
+    double dot_product = evaluateDot( residual, preconditioned_residual,
+        assign( approximation, approximation + alpha_coeff * direction),
+        assign( residual, residual - alpha_coeff * matrix_direction),
+        assign( preconditioned_residual, diagonal * residual));
+    // The same in float, then the separate statements
+    float_result = float_vec - alpha_coeff * float_vec;
+    float_result += 2 * float_vec;
+    float_result -= float_vec;
+    bool has_failed = fabs( dot_product - res_product) >=
+        DOUBLE_COMPARISON_ACCURACY || fabs( dot( residual,
+        preconditioned_residual) - res_product) >= DOUBLE_COMPARISON_ACCURACY;
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        if( fabs( direction[vec_idx] - res_direction[vec_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ||
+            fabs( approximation[vec_idx] - res_approximation[vec_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ||
+            fabs( residual[vec_idx] - res_residual[vec_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ||
+            fabs( preconditioned_residual[vec_idx] - res_residual[vec_idx] *
+            diagonal[vec_idx]) >= DOUBLE_COMPARISON_ACCURACY ||
+            fabs( float_result[vec_idx] - 1.75 * float_vec[vec_idx]) >=
+            DOUBLE_COMPARISON_ACCURACY ){
+            has_failed = true;
+        }
+    }
+    if( has_failed ){
+        std::cout << "A vector expression test failed" << std::endl;
+    }
+    return dot_product;
+}
+/**
+ * Does the array start at the alignment of the arena
+ */
+static bool isAligned( const void* memory_p){
+    return reinterpret_cast<uintptr_t>( memory_p) % MEMORY_ALIGNMENT == 0;
+}
+/**
+ * Take the arrays from an arena of a megabyte: the reset must give
+ * the same memory again, and the array, that doesn't fit, must be
+ * taken from the heap
+ * Results:
+ *      A control value( the peak bytes of the arena)
+ */
+static double testMemoryArena(){
+    MemoryArena arena;
+    bool has_failed = false;
+    MathVector vec( 3);
+    has_failed = has_failed || !isAligned( vec.getValues());
+    if( arena.reserve( 1 << 20, MemoryArena::PAGES_SMALL) ){
+        void* first_p = arena.allocate( 3);
+        size_t mark = arena.getMark();
+        void* second_p = arena.allocate( 128 * sizeof( double));
+        arena.reset( mark);
+        void* reset_p = arena.allocate( 10 * sizeof( double));
+        void* heap_p = arena.allocate( 2 << 20);
+        has_failed = has_failed || !isAligned( first_p) ||
+            !isAligned( second_p) || second_p == first_p ||
+            reset_p != second_p || !arena.isInArena( first_p) ||
+            arena.isInArena( heap_p) || !isAligned( heap_p) ||
+            arena.getStatistics().arena_allocations_ != 3 ||
+            arena.getStatistics().heap_allocations_ != 1 ||
+            arena.getStatistics().peak_bytes_ != MEMORY_ALIGNMENT +
+            128 * sizeof( double);
+        // The memory of the arena is written as the heap one
+        static_cast<double*>( reset_p)[9] = 1;
+        arena.deallocate( heap_p);
+        arena.deallocate( reset_p);
+    }
+    if( has_failed ){
+        std::cout << "A memory arena test failed" << std::endl;
+    }
+    return arena.getStatistics().peak_bytes_;
+}
+/**
+ * Compare the vectorized kernels with the scalar kernels.
+ * The lengths of the vectors and the rows aren't multiples of the vector
+ * register, so the remainder handling is tested too.
+ * Results:
+ *      A control value( the dot product)
+ */
+static double testSimdKernels(){
+    const size_t vec_len = 1003;
+    const size_t max_row_len = 9;
+    int* IA = allocateArray<int>( vec_len + 1);
+    int* JA = allocateArray<int>( vec_len * max_row_len);
+    double* A = allocateArray<double>( vec_len * max_row_len);
+    size_t edges_count = 0;
+    for( size_t row_idx = 0; row_idx < vec_len; ++row_idx ){
+        IA[row_idx] = edges_count;
+        size_t row_len = row_idx % max_row_len + 1;
+        for( size_t entry_idx = 0; entry_idx < row_len; ++entry_idx ){
+            JA[edges_count] = ( row_idx * 7 + entry_idx * 13) % vec_len;
+            A[edges_count] = 1.0 / ( entry_idx + 1);
+            ++edges_count;
+        }
+    }
+    IA[vec_len] = edges_count;
+    NetGraph graph( vec_len, edges_count, IA, JA, A);
+    MathVector vec_a( vec_len), vec_b( vec_len);
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        vec_a[vec_idx] = sin( vec_idx);
+        vec_b[vec_idx] = cos( vec_idx);
+    }
+    SimdIsa_t detected_isa = getSimdIsa();
+    setSimdIsa( SIMD_SCALAR);
+    double res_product = dotProduct( vec_a, vec_b);
+    MathVector res_comb( vec_len), res_mult( vec_len);
+    linearCombination( vec_a, vec_b, 0.5, -2, res_comb);
+    double res_mult_product = sparseMVDot( graph, vec_a, res_mult);
+    for( int isa = SIMD_SCALAR + 1; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        MathVector comb( vec_len), mult( vec_len);
+        bool has_failed = fabs( dotProduct( vec_a, vec_b) - res_product) >=
+            DOUBLE_COMPARISON_ACCURACY;
+        linearCombination( vec_a, vec_b, 0.5, -2, comb);
+        has_failed = has_failed || fabs( sparseMVDot( graph, vec_a, mult) -
+            res_mult_product) >= DOUBLE_COMPARISON_ACCURACY;
+        for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+            if( fabs( comb[vec_idx] - res_comb[vec_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ||
+                fabs( mult[vec_idx] - res_mult[vec_idx]) >=
+                DOUBLE_COMPARISON_ACCURACY ){
+                has_failed = true;
+            }
+        }
+        if( has_failed ){
+            std::cout << "A SIMD kernel test failed: " <<
+            getSimdIsaName( static_cast<SimdIsa_t>( isa)) << std::endl;
+        }
+    }
+    setSimdIsa( detected_isa);
+    return res_product;
+}
+/**
+ * Compare the cosines of the kernels with the ones of libm on the arguments
+ * of the graph: the small ones, the ones of the slow reduction of libm,
+ * the negative ones and the ones, that the kernels leave to libm.
+ * The count isn't a multiple of a register.
+ * Results:
+ *      The maximum difference from libm
+ */
+static double testCosineKernel(){
+    const size_t args_count = 2003;
+    std::vector<double> args( args_count), result( args_count);
+    for( size_t arg_idx = 0; arg_idx < args_count; ++arg_idx ){
+        size_t node_idx = arg_idx * 2477 + arg_idx % 3;
+        size_t neighbor_idx = node_idx + 1 + arg_idx % 5 * 2001;
+        args[arg_idx] = node_idx + neighbor_idx + node_idx * neighbor_idx;
+    }
+    args[1] = 0;
+    args[2] = -args[2];
+    args[3] = 0.7853981633974483;
+    args[4] = 3.0e18;
+    args[5] = -1.0e17;
+    SimdIsa_t detected_isa = getSimdIsa();
+    double max_difference = 0;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        cosineKernel( args.data(), result.data(), args_count);
+        bool has_failed = false;
+        for( size_t arg_idx = 0; arg_idx < args_count; ++arg_idx ){
+            double difference = fabs( result[arg_idx] - cos( args[arg_idx]));
+            max_difference = std::max( max_difference, difference);
+            // 1 ulp of the cosines from 0.5 to 1
+            if( difference > std::numeric_limits<double>::epsilon() / 2 ){
+                has_failed = true;
+            }
+        }
+        if( has_failed ){
+            std::cout << "A cosine kernel test failed: " <<
+            getSimdIsaName( static_cast<SimdIsa_t>( isa)) << std::endl;
+        }
+    }
+    setSimdIsa( detected_isa);
+    return max_difference;
+}
 /**
  * Launch all tests
  */
@@ -88,4 +407,10 @@ void launchTests(){
     testDotProduct();
     testLinearCombination();
     testSparseMV();
+    testSparseMVDot();
+    testUpdateApplyDot();
+    testVectorExpressions();
+    testMemoryArena();
+    testSimdKernels();
+    testCosineKernel();
 }
@@ -0,0 +1,239 @@
+/**
+ * The graph matrix with the compressed columns
+ */
+#include <algorithm>
+#include <limits>
+#include <omp.h>
+#include "tsk1_compressed.h"
+#include "tsk1_simd.h"
+/**
+ * Does the delta fit into the type
+ */
+template <typename Delta_t>
+static bool isDeltaFitting( long long delta){
+    return delta >= std::numeric_limits<Delta_t>::min() &&
+        delta <= std::numeric_limits<Delta_t>::max();
+}
+/**
+ * Write the deltas of the rows, that aren't in the fallback arrays.
+ * The threads write the rows of their parts, as the multiplication reads them.
+ * Results:
+ *      The deltas of the cells, the deltas of the fallback rows are zero
+ */
+template <typename Delta_t>
+static Delta_t* fillDeltas( const int* IA, const int* JA,
+                            const std::vector<bool>& is_fallback,
+                            const std::vector<size_t>& row_partition,
+                            size_t edges_count){
+    Delta_t* deltas = allocateArray<Delta_t>( edges_count +
+        SIMD_DELTAS_PADDING);
+    size_t parts_count = row_partition.size() - 1;
+    #pragma omp parallel for schedule( static, 1)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        for( size_t node_idx = row_partition[part_idx];
+             node_idx < row_partition[part_idx + 1]; ++node_idx ){
+            size_t end_idx = IA[node_idx + 1];
+            for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+                 ++edge_idx ){
+                deltas[edge_idx] = is_fallback[node_idx] ? 0 :
+                    static_cast<long long>( JA[edge_idx]) -
+                    static_cast<long long>( node_idx);
+            }
+        }
+    }
+    for( size_t edge_idx = edges_count;
+         edge_idx < edges_count + SIMD_DELTAS_PADDING; ++edge_idx ){
+        deltas[edge_idx] = 0;
+    }
+    return deltas;
+}
+/**
+ * Take the cells of the graph and replace the columns by the deltas
+ */
+CompressedGraph::CompressedGraph( NetGraph& graph){
+    nodes_count_ = graph.getNodesCount();
+    edges_count_ = graph.getEdgesCount();
+    int* graph_IA = graph.getIA();
+    int* graph_JA = graph.getJA();
+    double* graph_A = graph.getA();
+    deltas8_ = NULL;
+    deltas16_ = NULL;
+    IA = allocateArray<int>( nodes_count_ + 1);
+    A = allocateArray<double>( edges_count_);
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx <= nodes_count_; ++node_idx ){
+        IA[node_idx] = graph_IA[node_idx];
+    }
+    // The cells are written with the split of the multiplication
+    prepareThreads( omp_get_max_threads());
+    size_t parts_count = row_partition_.size() - 1;
+    #pragma omp parallel for schedule( static, 1)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        for( size_t edge_idx = IA[row_partition_[part_idx]];
+             edge_idx < static_cast<size_t>( IA[row_partition_[part_idx + 1]]);
+             ++edge_idx ){
+            A[edge_idx] = graph_A[edge_idx];
+        }
+    }
+    // Find the widest delta of every row
+    std::vector<bool> is_fallback( nodes_count_, false);
+    bool is_8bit = true;
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx ){
+            long long delta = static_cast<long long>( graph_JA[edge_idx]) -
+                static_cast<long long>( node_idx);
+            is_8bit = is_8bit && isDeltaFitting<int8_t>( delta);
+            if( !isDeltaFitting<int16_t>( delta) ){
+                is_fallback[node_idx] = true;
+            }
+        }
+        if( is_fallback[node_idx] ){
+            fallback_rows_.push_back( node_idx);
+            fallback_IA_.push_back( fallback_JA_.size());
+            fallback_JA_.insert( fallback_JA_.end(), graph_JA + IA[node_idx],
+                graph_JA + IA[node_idx + 1]);
+        }
+    }
+    fallback_IA_.push_back( fallback_JA_.size());
+    if( is_8bit ){
+        delta_size_ = sizeof( int8_t);
+        deltas8_ = fillDeltas<int8_t>( IA, graph_JA, is_fallback,
+            row_partition_, edges_count_);
+    } else{
+        delta_size_ = sizeof( int16_t);
+        deltas16_ = fillDeltas<int16_t>( IA, graph_JA, is_fallback,
+            row_partition_, edges_count_);
+    }
+}
+/**
+ * Split the rows between the threads by the number of cells
+ */
+void CompressedGraph::prepareThreads( size_t threads_num){
+    if( row_partition_.size() == threads_num + 1 ){
+        return;
+    }
+    row_partition_.assign( threads_num + 1, nodes_count_);
+    row_partition_[0] = 0;
+    for( size_t part_idx = 1; part_idx < threads_num; ++part_idx ){
+        size_t edges_bound = edges_count_ * part_idx / threads_num;
+        row_partition_[part_idx] = std::lower_bound( IA, IA + nodes_count_,
+            edges_bound) - IA;
+    }
+}
+/**
+ * Multiply a row with the columns in the fallback arrays
+ * Results:
+ *      The dot product of the vector and the result on the row
+ */
+double CompressedGraph::multiplyFallbackRow( const double* vec, double* result,
+                                             size_t node_idx,
+                                             size_t fallback_idx){
+    double row_product = 0;
+    size_t fallback_cell = fallback_IA_[fallback_idx];
+    size_t end_idx = IA[node_idx + 1];
+    for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+         ++edge_idx ){
+        row_product += A[edge_idx] * vec[fallback_JA_[fallback_cell]];
+        ++fallback_cell;
+    }
+    result[node_idx] = row_product;
+    return vec[node_idx] * row_product;
+}
+/**
+ * Multiply the rows [start_row; end_row) to the vector.
+ * The rows between the fallback rows are multiplied by the kernel.
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+double CompressedGraph::multiplyRows( const double* vec, double* result,
+                                      size_t start_row, size_t end_row){
+    size_t fallback_idx = std::lower_bound( fallback_rows_.begin(),
+        fallback_rows_.end(), start_row) - fallback_rows_.begin();
+    double sum = 0;
+    size_t row_idx = start_row;
+    while( row_idx < end_row ){
+        size_t fallback_row = fallback_idx < fallback_rows_.size() ?
+            std::min<size_t>( fallback_rows_[fallback_idx], end_row) : end_row;
+        if( delta_size_ == sizeof( int8_t) ){
+            sum += compressedMVDotKernel( IA, deltas8_, A, vec, result,
+                row_idx, fallback_row);
+        } else{
+            sum += compressedMVDotKernel( IA, deltas16_, A, vec, result,
+                row_idx, fallback_row);
+        }
+        if( fallback_row < end_row ){
+            sum += multiplyFallbackRow( vec, result, fallback_row,
+                fallback_idx);
+            ++fallback_idx;
+            ++fallback_row;
+        }
+        row_idx = fallback_row;
+    }
+    return sum;
+}
+void CompressedGraph::multiply( MathVector& vec, MathVector& result){
+    multiplyDot( vec, result);
+}
+double CompressedGraph::multiplyDot( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    assert( &result != &vec);
+    prepareThreads( omp_get_max_threads());
+    size_t parts_count = row_partition_.size() - 1;
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel for schedule( static, 1) reduction( +:sum)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sum += multiplyRows( vec_values, result_values,
+            row_partition_[part_idx], row_partition_[part_idx + 1]);
+    }
+    return sum;
+}
+double CompressedGraph::multiplyDotInRegion( MathVector& vec,
+                                             MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    // The partition is prepared before the region
+    size_t parts_count = row_partition_.size() - 1;
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp for schedule( static, 1) nowait
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sum += multiplyRows( vec_values, result_values,
+            row_partition_[part_idx], row_partition_[part_idx + 1]);
+    }
+    return sum;
+}
+/**
+ * Copy the diagonal from the cells with the zero delta
+ */
+void CompressedGraph::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        size_t fallback_idx = std::lower_bound( fallback_rows_.begin(),
+            fallback_rows_.end(), node_idx) - fallback_rows_.begin();
+        bool is_fallback = fallback_idx < fallback_rows_.size() &&
+            fallback_rows_[fallback_idx] == static_cast<int>( node_idx);
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx ){
+            bool is_diagonal = false;
+            if( is_fallback ){
+                is_diagonal = fallback_JA_[fallback_IA_[fallback_idx] +
+                    edge_idx - IA[node_idx]] == static_cast<int>( node_idx);
+            } else if( delta_size_ == sizeof( int8_t) ){
+                is_diagonal = deltas8_[edge_idx] == 0;
+            } else{
+                is_diagonal = deltas16_[edge_idx] == 0;
+            }
+            if( is_diagonal ){
+                diagonal[node_idx] = A[edge_idx];
+            }
+        }
+    }
+}
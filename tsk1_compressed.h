@@ -0,0 +1,78 @@
+#ifndef COMPRESSED_H
+    #define COMPRESSED_H
+#include <vector>
+#include <stdint.h>
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A matrix of the graph in CSR, where the columns are stored as the deltas
+ * from the row. The columns of a grid row are the row plus a few offsets,
+ * so a delta takes 8 or 16 bits instead of 32 bits of JA.
+ * The 8-bit deltas are taken, if the cells of every row fit into them,
+ * otherwise the 16-bit ones. The rows with a delta, that doesn't fit
+ * into 16 bits, keep their columns in the fallback arrays, and their
+ * deltas are zero.
+ */
+class CompressedGraph: public MatrixOperator{
+public:
+CompressedGraph( NetGraph& graph);
+CompressedGraph( const CompressedGraph&) = delete;
+~CompressedGraph(){
+    freeArray( IA);
+    freeArray( A);
+    freeArray( deltas8_);
+    freeArray( deltas16_);
+}
+size_t getNodesCount(){
+    return nodes_count_;
+}
+size_t getEdgesCount(){
+    return edges_count_;
+}
+// A number of bytes of a delta, 1 or 2
+size_t getDeltaSize(){
+    return delta_size_;
+}
+size_t getFallbackRowsCount(){
+    return fallback_rows_.size();
+}
+/**
+ * Get the memory of the matrix arrays in bytes
+ */
+size_t getMemorySize(){
+    return ( nodes_count_ + 1) * sizeof( int) + edges_count_ *
+        ( delta_size_ + sizeof( double)) + ( fallback_rows_.size() +
+        fallback_IA_.size() + fallback_JA_.size()) * sizeof( int);
+}
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void prepareThreads( size_t threads_num);
+void copyDiagonal( MathVector& diagonal);
+private:
+    double multiplyRows( const double* vec, double* result, size_t start_row,
+                         size_t end_row);
+    double multiplyFallbackRow( const double* vec, double* result,
+                                size_t node_idx, size_t fallback_idx);
+    int* IA;
+    double* A;
+    /**
+     * The column of the cell edge_idx of the row node_idx is
+     * node_idx + deltas[edge_idx]. Only the deltas of the selected size
+     * are stored, the other array is NULL. The arrays are padded by the width
+     * of a vector register, so the kernels load the deltas after the last row.
+     */
+    int8_t* deltas8_;
+    int16_t* deltas16_;
+    size_t delta_size_;
+    // The sorted rows with the columns in fallback_JA_
+    std::vector<int> fallback_rows_;
+    // The first cell of a fallback row in fallback_JA_
+    std::vector<int> fallback_IA_;
+    std::vector<int> fallback_JA_;
+    size_t nodes_count_;
+    size_t edges_count_;
+    // The rows of the threads with almost the same number of cells
+    std::vector<size_t> row_partition_;
+};
+#endif
@@ -0,0 +1,179 @@
+/**
+ * The graph matrix in the diagonal format
+ */
+#include <algorithm>
+#include <omp.h>
+#include "tsk1_dia.h"
+/**
+ * Generate the diagonals from the matrix parameters.
+ * The edges are the same, as NetGraph::generate makes:
+ * the cell of an edge is 1, the cell without an edge is 0.
+ */
+void DiaMatrix::generate( MatrixParameters *params_p){
+    size_t not_divided = params_p->getNotDivided();
+    size_t divided = params_p->getDivided();
+    double* upper = getDiagonal( DIA_UPPER);
+    double* upper_divided = getDiagonal( DIA_UPPER_DIVIDED);
+    double* left = getDiagonal( DIA_LEFT);
+    double* main_diagonal = getDiagonal( DIA_MAIN);
+    double* right = getDiagonal( DIA_RIGHT);
+    double* lower_divided = getDiagonal( DIA_LOWER_DIVIDED);
+    double* lower = getDiagonal( DIA_LOWER);
+    #pragma omp parallel for
+    for( size_t row_idx = 0; row_idx <= row_len_; ++row_idx ){
+        for( size_t column_idx = 0; column_idx <= column_len_; ++column_idx ){
+            size_t node_idx = row_idx * (column_len_ + 1) + column_idx;
+            upper[node_idx] = row_idx > 0;
+            upper_divided[node_idx] = 0;
+            if( row_idx > 0 && column_idx < column_len_ ){
+                size_t upper_cell_idx = (row_idx - 1) * column_len_ + column_idx;
+                upper_divided[node_idx] = upper_cell_idx %
+                    (divided + not_divided) >= not_divided;
+            }
+            left[node_idx] = column_idx > 0;
+            main_diagonal[node_idx] = 1;
+            right[node_idx] = column_idx < column_len_;
+            lower_divided[node_idx] = 0;
+            if( row_idx < row_len_ && column_idx > 0 ){
+                size_t below_cell_idx = row_idx * column_len_ + column_idx - 1;
+                lower_divided[node_idx] = below_cell_idx %
+                    (divided + not_divided) >= not_divided;
+            }
+            lower[node_idx] = row_idx < row_len_;
+        }
+    }
+}
+/**
+ * Fill the matrix
+ * Make it diagonally dominant, as NetGraph::fillMatrix does
+ */
+void DiaMatrix::fillMatrix(){
+    const double DOMINANCE_COEFF = 2;
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        // A sum of all matrix cells on the row, except for the diagonal
+        double row_sum = 0;
+        for( size_t diagonal_idx = 0; diagonal_idx < DIA_DIAGONALS_COUNT;
+             ++diagonal_idx ){
+            double& cell = getDiagonal( diagonal_idx)[node_idx];
+            // The padding cells stay zero
+            if( diagonal_idx == DIA_MAIN || !cell ){
+                continue;
+            }
+            size_t neighbor_idx = node_idx + offsets_[diagonal_idx];
+            cell = cos( node_idx + neighbor_idx + node_idx * neighbor_idx);
+            row_sum += fabs( cell);
+        }
+        getDiagonal( DIA_MAIN)[node_idx] = DOMINANCE_COEFF * row_sum;
+    }
+}
+/**
+ * Multiply the rows near the first and the last rows of the matrix.
+ * Some diagonals are outside of the matrix there, skip them.
+ * Results:
+ *      The dot product of the vector and the result on the rows
+ */
+double DiaMatrix::multiplyBoundaryRows( const double* vec, double* result,
+                                        size_t start_row, size_t end_row){
+    ptrdiff_t nodes_count = nodes_count_;
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx ){
+        double row_product = 0;
+        for( size_t diagonal_idx = 0; diagonal_idx < DIA_DIAGONALS_COUNT;
+             ++diagonal_idx ){
+            ptrdiff_t column_idx = node_idx + offsets_[diagonal_idx];
+            if( column_idx >= 0 && column_idx < nodes_count ){
+                row_product += getDiagonal( diagonal_idx)[node_idx] *
+                    vec[column_idx];
+            }
+        }
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * Multiply the rows [start_row; end_row) to the vector
+ * On the inner rows all diagonals are inside the matrix, so the loop over
+ * the rows reads every diagonal and the shifted vector with the unit stride.
+ * Results:
+ *      The dot product of the vector and the result on the rows
+ */
+double DiaMatrix::multiplyRows( const double* vec, double* result,
+                                size_t start_row, size_t end_row){
+    size_t max_offset = offsets_[DIA_DIAGONALS_COUNT - 1];
+    size_t inner_start = std::min( std::max( start_row, max_offset), end_row);
+    size_t inner_end = nodes_count_ > max_offset ? nodes_count_ - max_offset : 0;
+    inner_end = std::min( std::max( inner_end, inner_start), end_row);
+    double sum = multiplyBoundaryRows( vec, result, start_row, inner_start);
+    if( inner_start < inner_end ){
+        const double* diagonals[DIA_DIAGONALS_COUNT];
+        const double* shifted_vec[DIA_DIAGONALS_COUNT];
+        for( size_t diagonal_idx = 0; diagonal_idx < DIA_DIAGONALS_COUNT;
+             ++diagonal_idx ){
+            diagonals[diagonal_idx] = getDiagonal( diagonal_idx) + inner_start;
+            shifted_vec[diagonal_idx] = vec + inner_start + offsets_[diagonal_idx];
+        }
+        const double* inner_vec = vec + inner_start;
+        double* inner_result = result + inner_start;
+        size_t inner_len = inner_end - inner_start;
+        #pragma omp simd reduction( +:sum)
+        for( size_t row_idx = 0; row_idx < inner_len; ++row_idx ){
+            double row_product = 0;
+            for( size_t diagonal_idx = 0; diagonal_idx < DIA_DIAGONALS_COUNT;
+                 ++diagonal_idx ){
+                row_product += diagonals[diagonal_idx][row_idx] *
+                    shifted_vec[diagonal_idx][row_idx];
+            }
+            inner_result[row_idx] = row_product;
+            sum += inner_vec[row_idx] * row_product;
+        }
+    }
+    sum += multiplyBoundaryRows( vec, result, inner_end, end_row);
+    return sum;
+}
+void DiaMatrix::multiply( MathVector& vec, MathVector& result){
+    multiplyDot( vec, result);
+}
+double DiaMatrix::multiplyDot( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    assert( &result != &vec);
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    size_t blocks_count = (nodes_count_ + DIA_BLOCK_ROWS - 1) / DIA_BLOCK_ROWS;
+    double sum = 0;
+    #pragma omp parallel for schedule( static) reduction( +:sum)
+    for( size_t block_idx = 0; block_idx < blocks_count; ++block_idx ){
+        size_t start_row = block_idx * DIA_BLOCK_ROWS;
+        size_t end_row = std::min( start_row + DIA_BLOCK_ROWS, nodes_count_);
+        sum += multiplyRows( vec_values, result_values, start_row, end_row);
+    }
+    return sum;
+}
+double DiaMatrix::multiplyDotInRegion( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    size_t blocks_count = (nodes_count_ + DIA_BLOCK_ROWS - 1) / DIA_BLOCK_ROWS;
+    double sum = 0;
+    #pragma omp for schedule( static) nowait
+    for( size_t block_idx = 0; block_idx < blocks_count; ++block_idx ){
+        size_t start_row = block_idx * DIA_BLOCK_ROWS;
+        size_t end_row = std::min( start_row + DIA_BLOCK_ROWS, nodes_count_);
+        sum += multiplyRows( vec_values, result_values, start_row, end_row);
+    }
+    return sum;
+}
+/**
+ * Copy the main diagonal
+ */
+void DiaMatrix::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    double* main_diagonal = getDiagonal( DIA_MAIN);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        diagonal[node_idx] = main_diagonal[node_idx];
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef DIA_H
+    #define DIA_H
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * The diagonals of the graph matrix.
+ * The node (row_idx; column_idx) has the index row_idx * (column_len + 1) +
+ * column_idx, so every edge of the graph is on one of the seven diagonals.
+ * The diagonals are in the order of the offsets, the same order as the
+ * edges of a row in IA/JA.
+ */
+enum {
+    // Offset -(column_len + 1), the node above
+    DIA_UPPER = 0,
+    // Offset -column_len, the division of the upper cell
+    DIA_UPPER_DIVIDED,
+    // Offset -1, the node on the left
+    DIA_LEFT,
+    // Offset 0, the node to itself
+    DIA_MAIN,
+    // Offset 1, the node on the right
+    DIA_RIGHT,
+    // Offset column_len, the division of the cell below
+    DIA_LOWER_DIVIDED,
+    // Offset column_len + 1, the node below
+    DIA_LOWER,
+    DIA_DIAGONALS_COUNT
+};
+enum {
+    // The rows of the matrix, that a thread multiplies at once
+    DIA_BLOCK_ROWS = 4096
+};
+/**
+ * A matrix of the graph in the diagonal (DIA) format.
+ * Every diagonal is stored for all rows, the cells without an edge are
+ * zero. The multiplication reads the diagonals and the vector with the
+ * unit stride and doesn't read the column indexes.
+ */
+class DiaMatrix: public MatrixOperator{
+public:
+DiaMatrix( MatrixParameters *params_p){
+    row_len_ = params_p->getRowLen();
+    column_len_ = params_p->getColumnLen();
+    nodes_count_ = (row_len_ + 1) * (column_len_ + 1);
+    ptrdiff_t column_len = column_len_;
+    ptrdiff_t offsets[DIA_DIAGONALS_COUNT] = { -(column_len + 1), -column_len,
+        -1, 0, 1, column_len, column_len + 1 };
+    for( size_t diagonal_idx = 0; diagonal_idx < DIA_DIAGONALS_COUNT;
+         ++diagonal_idx ){
+        offsets_[diagonal_idx] = offsets[diagonal_idx];
+    }
+    values_ = allocateArray<double>( DIA_DIAGONALS_COUNT * nodes_count_);
+}
+DiaMatrix( const DiaMatrix&) = delete;
+~DiaMatrix(){
+    freeArray( values_);
+}
+size_t getNodesCount(){
+    return nodes_count_;
+}
+ptrdiff_t getOffset( size_t diagonal_idx){
+    return offsets_[diagonal_idx];
+}
+/**
+ * Get a diagonal: the element of the row node_idx is
+ * at the column node_idx + offset
+ */
+double* getDiagonal( size_t diagonal_idx){
+    return values_ + diagonal_idx * nodes_count_;
+}
+void generate( MatrixParameters *params_p);
+void fillMatrix();
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void copyDiagonal( MathVector& diagonal);
+private:
+    double multiplyRows( const double* vec, double* result, size_t start_row,
+                         size_t end_row);
+    double multiplyBoundaryRows( const double* vec, double* result,
+                                 size_t start_row, size_t end_row);
+    size_t row_len_;
+    size_t column_len_;
+    size_t nodes_count_;
+    // The column of the diagonal element minus the row
+    ptrdiff_t offsets_[DIA_DIAGONALS_COUNT];
+    // The diagonals one after another, nodes_count_ elements each
+    double* values_;
+};
+#endif
@@ -0,0 +1,330 @@
+#ifndef EXPRESSION_H
+    #define EXPRESSION_H
+#include <cassert>
+#include <cstddef>
+#include "omp.h"
+#include "tsk1_operator.h"
+/**
+ * The expression templates of the vector arithmetic.
+ * An expression like z + b*p isn't calculated, when it is written:
+ * it is a tree of the light objects, that reference the vectors.
+ * The element of the expression is calculated, when the expression is
+ * assigned to a vector, so the assignment is one loop over the elements
+ * without the temporary vectors. The assignment is elementwise, so
+ * the assigned vector may be in the expression, e.g. p = z + b*p.
+ */
+template <typename Expression_t>
+class VectorExpression{
+public:
+    const Expression_t& self() const{
+        return static_cast<const Expression_t&>( *this);
+    }
+};
+/**
+ * A leaf of the expression: the values of a vector.
+ * The values are read without the bound check, so the loop is vectorized.
+ */
+template <typename Value_t>
+class VectorReference: public VectorExpression<VectorReference<Value_t> >{
+public:
+    typedef Value_t ValueType;
+    VectorReference( const Value_t* values, size_t vec_len): values_( values),
+        vec_len_( vec_len) {}
+    Value_t operator[]( size_t vec_idx) const{
+        return values_[vec_idx];
+    }
+    size_t getVecLen() const{
+        return vec_len_;
+    }
+private:
+    const Value_t* values_;
+    size_t vec_len_;
+};
+/**
+ * An expression keeps the nodes by value, and the vectors
+ * by the references to their values
+ */
+template <typename Expression_t>
+class ExpressionStorage{
+public:
+    typedef Expression_t Type;
+    static Type make( const Expression_t& expression){
+        return expression;
+    }
+};
+template <typename Value_t>
+class ExpressionStorage<MathVectorT<Value_t> >{
+public:
+    typedef VectorReference<Value_t> Type;
+    static Type make( const MathVectorT<Value_t>& vec){
+        return Type( vec.getValues(), vec.getVecLen());
+    }
+};
+/**
+ * A binary node: the sum, the difference or the elementwise product
+ * of the two expressions of the same length
+ */
+template <typename Left_t, typename Right_t, typename Operation_t>
+class VectorBinary: public VectorExpression<VectorBinary<Left_t, Right_t,
+    Operation_t> >{
+public:
+    typedef typename ExpressionStorage<Left_t>::Type LeftStorage;
+    typedef typename ExpressionStorage<Right_t>::Type RightStorage;
+    typedef typename LeftStorage::ValueType ValueType;
+    VectorBinary( const Left_t& left, const Right_t& right):
+        left_( ExpressionStorage<Left_t>::make( left)),
+        right_( ExpressionStorage<Right_t>::make( right)){
+        assert( left_.getVecLen() == right_.getVecLen());
+    }
+    ValueType operator[]( size_t vec_idx) const{
+        return Operation_t::apply( left_[vec_idx], right_[vec_idx]);
+    }
+    size_t getVecLen() const{
+        return left_.getVecLen();
+    }
+private:
+    LeftStorage left_;
+    RightStorage right_;
+};
+class AddOperation{
+public:
+    template <typename Value_t>
+    static Value_t apply( Value_t left, Value_t right){
+        return left + right;
+    }
+};
+class SubtractOperation{
+public:
+    template <typename Value_t>
+    static Value_t apply( Value_t left, Value_t right){
+        return left - right;
+    }
+};
+class MultiplyOperation{
+public:
+    template <typename Value_t>
+    static Value_t apply( Value_t left, Value_t right){
+        return left * right;
+    }
+};
+/**
+ * An expression multiplied by a scalar.
+ * The scalar is rounded to the value type of the expression,
+ * so the float vectors are calculated in float.
+ */
+template <typename Expression_t>
+class VectorScaled: public VectorExpression<VectorScaled<Expression_t> >{
+public:
+    typedef typename ExpressionStorage<Expression_t>::Type Storage;
+    typedef typename Storage::ValueType ValueType;
+    VectorScaled( double coeff, const Expression_t& expression):
+        coeff_( coeff),
+        expression_( ExpressionStorage<Expression_t>::make( expression)) {}
+    ValueType operator[]( size_t vec_idx) const{
+        return coeff_ * expression_[vec_idx];
+    }
+    size_t getVecLen() const{
+        return expression_.getVecLen();
+    }
+private:
+    ValueType coeff_;
+    Storage expression_;
+};
+template <typename Left_t, typename Right_t>
+VectorBinary<Left_t, Right_t, AddOperation> operator+(
+    const VectorExpression<Left_t>& left,
+    const VectorExpression<Right_t>& right){
+    return VectorBinary<Left_t, Right_t, AddOperation>( left.self(),
+        right.self());
+}
+template <typename Left_t, typename Right_t>
+VectorBinary<Left_t, Right_t, SubtractOperation> operator-(
+    const VectorExpression<Left_t>& left,
+    const VectorExpression<Right_t>& right){
+    return VectorBinary<Left_t, Right_t, SubtractOperation>( left.self(),
+        right.self());
+}
+// The elementwise product, e.g. the diagonal preconditioner D^-1 * r
+template <typename Left_t, typename Right_t>
+VectorBinary<Left_t, Right_t, MultiplyOperation> operator*(
+    const VectorExpression<Left_t>& left,
+    const VectorExpression<Right_t>& right){
+    return VectorBinary<Left_t, Right_t, MultiplyOperation>( left.self(),
+        right.self());
+}
+template <typename Expression_t>
+VectorScaled<Expression_t> operator*( double coeff,
+    const VectorExpression<Expression_t>& expression){
+    return VectorScaled<Expression_t>( coeff, expression.self());
+}
+/**
+ * An assignment of an expression to the values of a vector.
+ * It is made by assign() and evaluated by evaluate() or evaluateDot()
+ * together with the other assignments.
+ */
+template <typename Value_t, typename Expression_t>
+class VectorAssignment{
+public:
+    VectorAssignment( Value_t* values, size_t vec_len,
+                      const Expression_t& expression): values_( values),
+        vec_len_( vec_len),
+        expression_( ExpressionStorage<Expression_t>::make( expression)) {}
+    void assignElement( size_t vec_idx) const{
+        values_[vec_idx] = expression_[vec_idx];
+    }
+    size_t getVecLen() const{
+        return vec_len_;
+    }
+private:
+    Value_t* values_;
+    size_t vec_len_;
+    typename ExpressionStorage<Expression_t>::Type expression_;
+};
+template <typename Value_t, typename Expression_t>
+VectorAssignment<Value_t, Expression_t> assign( MathVectorT<Value_t>& vec,
+    const VectorExpression<Expression_t>& expression){
+    assert( vec.getVecLen() == expression.self().getVecLen());
+    return VectorAssignment<Value_t, Expression_t>( vec.getValues(),
+        vec.getVecLen(), expression.self());
+}
+/**
+ * Assign the element of every assignment in the order of the arguments
+ */
+inline void assignElements( size_t){}
+template <typename First_t, typename... Rest_t>
+inline void assignElements( size_t vec_idx, const First_t& first,
+                            const Rest_t&... rest){
+    first.assignElement( vec_idx);
+    assignElements( vec_idx, rest...);
+}
+/**
+ * Get the part of the vector elements of the current thread.
+ * The vector is split into the contiguous parts, as the static schedule
+ * splits it.
+ */
+inline void getThreadRange( size_t vec_len, size_t& start_idx, size_t& end_idx){
+    size_t threads_num = omp_get_num_threads();
+    size_t thread_idx = omp_get_thread_num();
+    size_t part_len = vec_len / threads_num;
+    size_t rest = vec_len % threads_num;
+    if( thread_idx < rest ){
+        ++part_len;
+        start_idx = thread_idx * part_len;
+    } else{
+        start_idx = thread_idx * part_len + rest;
+    }
+    end_idx = start_idx + part_len;
+}
+/**
+ * Evaluate the assignments and the dot product on the elements
+ * [start_idx; end_idx). The expressions are passed by value, so their
+ * pointers are the local variables, and the loop is vectorized.
+ * Results:
+ *      The dot product on these elements
+ */
+template <typename Left_t, typename Right_t, typename... Assignment_t>
+inline double evaluateRange( size_t start_idx, size_t end_idx, Left_t left,
+                             Right_t right, Assignment_t... assignments){
+    double sum = 0;
+    #pragma omp simd reduction( +:sum)
+    for( size_t vec_idx = start_idx; vec_idx < end_idx; ++vec_idx){
+        assignElements( vec_idx, assignments...);
+        sum += static_cast<double>( left[vec_idx]) * right[vec_idx];
+    }
+    return sum;
+}
+/**
+ * Evaluate the assignments and calculate the dot product (a, b)
+ * in one parallel loop over the elements. An element is assigned
+ * in the order of the arguments, so an assignment may read the vector
+ * assigned before it, and the dot product takes the elements after
+ * the assignments, e.g. rho = (r, z) of the updated r and z:
+ *      evaluateDot( r, z, assign( r, r - alpha*q), assign( z, d*r))
+ * The products are summed in double.
+ * Results:
+ *      The dot product
+ */
+template <typename Left_t, typename Right_t, typename... Assignment_t>
+double evaluateDot( const VectorExpression<Left_t>& vec_a,
+                    const VectorExpression<Right_t>& vec_b,
+                    const Assignment_t&... assignments){
+    typename ExpressionStorage<Left_t>::Type left =
+        ExpressionStorage<Left_t>::make( vec_a.self());
+    typename ExpressionStorage<Right_t>::Type right =
+        ExpressionStorage<Right_t>::make( vec_b.self());
+    assert( left.getVecLen() == right.getVecLen());
+    size_t vec_len = left.getVecLen();
+    double sum = 0;
+    #pragma omp parallel reduction( +:sum)
+    {
+        size_t start_idx = 0, end_idx = 0;
+        getThreadRange( vec_len, start_idx, end_idx);
+        sum += evaluateRange( start_idx, end_idx, left, right,
+            assignments...);
+    }
+    return sum;
+}
+/**
+ * The same for a persistent parallel region.
+ * Must be called by every thread of the region. The part of a thread is
+ * its part of the static schedule, and the threads don't wait for each other.
+ * Results:
+ *      The partial dot product of the thread
+ */
+template <typename Left_t, typename Right_t, typename... Assignment_t>
+double evaluateDotInRegion( const VectorExpression<Left_t>& vec_a,
+                            const VectorExpression<Right_t>& vec_b,
+                            const Assignment_t&... assignments){
+    typename ExpressionStorage<Left_t>::Type left =
+        ExpressionStorage<Left_t>::make( vec_a.self());
+    typename ExpressionStorage<Right_t>::Type right =
+        ExpressionStorage<Right_t>::make( vec_b.self());
+    assert( left.getVecLen() == right.getVecLen());
+    size_t start_idx = 0, end_idx = 0;
+    getThreadRange( left.getVecLen(), start_idx, end_idx);
+    return evaluateRange( start_idx, end_idx, left, right, assignments...);
+}
+/**
+ * Evaluate the assignments on the elements [start_idx; end_idx)
+ */
+template <typename... Assignment_t>
+inline void assignRange( size_t start_idx, size_t end_idx,
+                         Assignment_t... assignments){
+    #pragma omp simd
+    for( size_t vec_idx = start_idx; vec_idx < end_idx; ++vec_idx){
+        assignElements( vec_idx, assignments...);
+    }
+}
+/**
+ * Evaluate the assignments in one parallel loop over the elements
+ */
+template <typename First_t, typename... Rest_t>
+void evaluate( const First_t& first, const Rest_t&... rest){
+    size_t vec_len = first.getVecLen();
+    #pragma omp parallel
+    {
+        size_t start_idx = 0, end_idx = 0;
+        getThreadRange( vec_len, start_idx, end_idx);
+        assignRange( start_idx, end_idx, first, rest...);
+    }
+}
+/**
+ * The same for a persistent parallel region.
+ * Must be called by every thread of the region, the threads don't wait
+ * for each other.
+ */
+template <typename First_t, typename... Rest_t>
+void evaluateInRegion( const First_t& first, const Rest_t&... rest){
+    size_t start_idx = 0, end_idx = 0;
+    getThreadRange( first.getVecLen(), start_idx, end_idx);
+    assignRange( start_idx, end_idx, first, rest...);
+}
+/**
+ * A dot product of the two expressions in one loop
+ */
+template <typename Left_t, typename Right_t>
+double dot( const VectorExpression<Left_t>& vec_a,
+            const VectorExpression<Right_t>& vec_b){
+    return evaluateDot( vec_a, vec_b);
+}
+#endif
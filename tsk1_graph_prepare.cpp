@@ -2,29 +2,260 @@
  * Generate a graph 
  */ 
 #include <iostream>
+#include <algorithm>
+#include <cassert>
 #include <omp.h>
 #include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+#include "tsk1_simd.h"
+// The diagonal is this times the sum of the other cells of the row
+static const double DOMINANCE_COEFF = 2;
+/**
+ * The coefficients of the edges around a row of the grid.
+ * An edge has the same coefficient in both of its cells, so every edge
+ * is evaluated once by the vectorized cosine, and both rows of the grid
+ * take its value. The edges between the rows link_idx - 1 and link_idx
+ * are the link link_idx, it is kept for the next row of the thread.
+ * The graph, that isn't filled, takes 1 for every edge.
+ */
+template <bool is_filled>
+class RowCoefficients{
+public:
+    RowCoefficients( MatrixParameters* params_p): params_p_( params_p),
+        column_len_( params_p->getColumnLen()), upper_link_idx_( 0),
+        lower_link_idx_( 0){}
+    /**
+     * Evaluate the edges of the row and of the links to the rows
+     * above and below it
+     */
+    template <MatrixParameters::DividePattern_t pattern>
+    void evaluate( size_t row_idx){
+        if( row_idx > 0 && upper_link_idx_ != row_idx ){
+            if( lower_link_idx_ == row_idx ){
+                upper_vertical_.swap( lower_vertical_);
+                upper_divided_.swap( lower_divided_);
+                upper_link_idx_ = row_idx;
+            } else{
+                evaluateLink<pattern>( row_idx, upper_vertical_, upper_divided_);
+                upper_link_idx_ = row_idx;
+            }
+        }
+        if( row_idx < params_p_->getRowLen() ){
+            evaluateLink<pattern>( row_idx + 1, lower_vertical_, lower_divided_);
+            lower_link_idx_ = row_idx + 1;
+        }
+        // The edges ( column_idx; column_idx + 1) of the row
+        size_t first_node = row_idx * ( column_len_ + 1);
+        arguments_.resize( column_len_);
+        for( size_t column_idx = 0; column_idx < column_len_; ++column_idx ){
+            arguments_[column_idx] = getArgument( first_node + column_idx,
+                first_node + column_idx + 1);
+        }
+        horizontal_.resize( column_len_);
+        cosineKernel( arguments_.data(), horizontal_.data(), column_len_);
+    }
+    // The edge to ( row_idx - 1; column_idx)
+    double getUpper( size_t column_idx) const{
+        return upper_vertical_[column_idx];
+    }
+    // The edge to ( row_idx - 1; column_idx + 1)
+    double getUpperDivided( size_t column_idx) const{
+        return upper_divided_[column_idx];
+    }
+    // The edge to ( row_idx; column_idx - 1)
+    double getLeft( size_t column_idx) const{
+        return horizontal_[column_idx - 1];
+    }
+    // The edge to ( row_idx; column_idx + 1)
+    double getRight( size_t column_idx) const{
+        return horizontal_[column_idx];
+    }
+    // The edge to ( row_idx + 1; column_idx - 1)
+    double getLowerDivided( size_t column_idx) const{
+        return lower_divided_[column_idx - 1];
+    }
+    // The edge to ( row_idx + 1; column_idx)
+    double getLower( size_t column_idx) const{
+        return lower_vertical_[column_idx];
+    }
+private:
+    /**
+     * The argument of the cosine of the edge,
+     * it is the same for both nodes of the edge
+     */
+    static double getArgument( size_t node_idx, size_t neighbor_idx){
+        return node_idx + neighbor_idx + node_idx * neighbor_idx;
+    }
+    /**
+     * Evaluate the vertical edges by the columns and the edges
+     * of the divided cells by the cells. The cells, that aren't divided,
+     * aren't evaluated.
+     */
+    template <MatrixParameters::DividePattern_t pattern>
+    void evaluateLink( size_t link_idx, std::vector<double>& vertical,
+                       std::vector<double>& divided){
+        size_t not_divided = params_p_->getNotDivided();
+        size_t divided_cells = params_p_->getDivided();
+        size_t upper_node = ( link_idx - 1) * ( column_len_ + 1);
+        size_t lower_node = upper_node + column_len_ + 1;
+        size_t upper_cell = ( link_idx - 1) * column_len_;
+        arguments_.clear();
+        for( size_t column_idx = 0; column_idx <= column_len_; ++column_idx ){
+            arguments_.push_back( getArgument( upper_node + column_idx,
+                lower_node + column_idx));
+        }
+        for( size_t column_idx = 0; column_idx < column_len_; ++column_idx ){
+            if( MatrixParameters::isCellDivided<pattern>(
+                    upper_cell + column_idx, not_divided, divided_cells) ){
+                arguments_.push_back( getArgument( upper_node + column_idx + 1,
+                    lower_node + column_idx));
+            }
+        }
+        values_.resize( arguments_.size());
+        cosineKernel( arguments_.data(), values_.data(), arguments_.size());
+        vertical.assign( values_.begin(), values_.begin() + column_len_ + 1);
+        divided.resize( column_len_);
+        size_t value_idx = column_len_ + 1;
+        for( size_t column_idx = 0; column_idx < column_len_; ++column_idx ){
+            if( MatrixParameters::isCellDivided<pattern>(
+                    upper_cell + column_idx, not_divided, divided_cells) ){
+                divided[column_idx] = values_[value_idx++];
+            }
+        }
+    }
+    MatrixParameters* params_p_;
+    size_t column_len_;
+    // The links, that the edges above and below the row are evaluated for
+    size_t upper_link_idx_;
+    size_t lower_link_idx_;
+    std::vector<double> upper_vertical_;
+    std::vector<double> upper_divided_;
+    std::vector<double> horizontal_;
+    std::vector<double> lower_vertical_;
+    std::vector<double> lower_divided_;
+    std::vector<double> arguments_;
+    std::vector<double> values_;
+};
+/**
+ * The coefficients of the graph, that isn't filled
+ */
+template <>
+class RowCoefficients<false>{
+public:
+    RowCoefficients( MatrixParameters*){}
+    template <MatrixParameters::DividePattern_t pattern>
+    void evaluate( size_t){}
+    double getUpper( size_t) const{
+        return 1;
+    }
+    double getUpperDivided( size_t) const{
+        return 1;
+    }
+    double getLeft( size_t) const{
+        return 1;
+    }
+    double getRight( size_t) const{
+        return 1;
+    }
+    double getLowerDivided( size_t) const{
+        return 1;
+    }
+    double getLower( size_t) const{
+        return 1;
+    }
+};
 /**
  * Generate a graph of a network from a matrix
  * of a pre-set parameters.
+ * The cells are 1, fillMatrix() sets the coefficients
+ */
+template <typename Index_t, typename Value_t>
+void
+NetGraphT<Index_t, Value_t>::generate( MatrixParameters *params_p){
+    generateRows<false>( params_p);
+}
+/**
+ * Generate a graph and set its coefficients in one pass:
+ * a row is written with the coefficients of its cells,
+ * and its diagonal is set, when the row ends.
+ * The coefficients are the cosines of the vectorized kernel, they differ
+ * from the ones of fillMatrix() by 1 ulp at most.
+ */
+template <typename Index_t, typename Value_t>
+void
+NetGraphT<Index_t, Value_t>::generateFilled( MatrixParameters *params_p){
+    generateRows<true>( params_p);
+}
+/**
+ * Write an edge from the node to the neighbor with its coefficient.
+ * The coefficients of the filled graph are summed for the diagonal.
+ */
+template <typename Index_t, typename Value_t>
+template <bool is_filled>
+inline void
+NetGraphT<Index_t, Value_t>::addEdge( size_t& edge_idx, size_t neighbor_idx,
+                                      double coefficient, double& row_sum){
+    JA[edge_idx] = neighbor_idx;
+    A[edge_idx] = coefficient;
+    if( is_filled ){
+        row_sum += fabs( A[edge_idx]);
+    }
+    ++edge_idx;
+}
+/**
+ * Generate the rows of the graph by the generator of the pattern
+ * of the divided cells.
+ * If is_filled = true, then set the coefficients of the cells too
  */
+template <typename Index_t, typename Value_t>
+template <bool is_filled>
 void
-NetGraph::generate( MatrixParameters *params_p, 
-                    int threads_num = 1){  // A number of threads
+NetGraphT<Index_t, Value_t>::generateRows( MatrixParameters *params_p){
+    switch( params_p->getDividePattern() ){
+    case MatrixParameters::PATTERN_ALL_DIVIDED:
+        generatePatternRows<is_filled,
+            MatrixParameters::PATTERN_ALL_DIVIDED>( params_p);
+        break;
+    case MatrixParameters::PATTERN_NONE_DIVIDED:
+        generatePatternRows<is_filled,
+            MatrixParameters::PATTERN_NONE_DIVIDED>( params_p);
+        break;
+    case MatrixParameters::PATTERN_ALTERNATING:
+        generatePatternRows<is_filled,
+            MatrixParameters::PATTERN_ALTERNATING>( params_p);
+        break;
+    default:
+        generatePatternRows<is_filled,
+            MatrixParameters::PATTERN_GENERIC>( params_p);
+        break;
+    }
+}
+/**
+ * Generate the rows of the graph for a pattern of the divided cells.
+ * The first and the last rows of the grid don't have the neighbors
+ * above and below, so they are taken by their own generators,
+ * and the inner rows don't check the borders
+ */
+template <typename Index_t, typename Value_t>
+template <bool is_filled, MatrixParameters::DividePattern_t pattern>
+void
+NetGraphT<Index_t, Value_t>::generatePatternRows( MatrixParameters *params_p){
     size_t row_len = params_p->getRowLen();
     size_t column_len = params_p->getColumnLen();
-    size_t not_divided = params_p->getNotDivided();
-    size_t divided = params_p->getDivided();
     /**
      * An edge index in a simple case is a data dependency
      * Can't sum all the edges from the previous rows — a formula is required.
      * Calculate the indexes for the rows independently
      */
-    //omp_set_num_threads( threads_num);
-    #pragma omp parallel for
+    #pragma omp parallel
+    {
+    // A thread takes the neighbor rows, so a link is evaluated once
+    RowCoefficients<is_filled> coefficients( params_p);
+    #pragma omp for schedule( static)
     for( size_t row_idx = 0; row_idx <= row_len; ++row_idx )
     {            
-        std::pair<int, int> cells = countDividedCells( row_idx, params_p);
+        coefficients.template evaluate<pattern>( row_idx);
+        std::pair<size_t, size_t> cells = countDividedCells( row_idx, params_p);
         size_t row_not_divided_nodes = cells.first;
         size_t row_divided_nodes = cells.second;
         /**
@@ -58,75 +289,133 @@ NetGraph::generate( MatrixParameters *params_p,
         }
 		// Add edges from the node to itself
 		edge_idx += row_idx * (column_len + 1);
-        for( size_t column_idx = 0; column_idx <= column_len; ++column_idx )
-        { 
-            size_t node_idx = row_idx * (column_len + 1) + column_idx;
-            IA[node_idx] = edge_idx;
-            if( row_idx > 0 ){
-                // Edge from (row_idx; column_idx) to (row_idx - 1; column_idx)
-                JA[edge_idx] = node_idx - (column_len + 1); 
-                A[edge_idx] = 1;
-                ++edge_idx;
-            }
-            if( row_idx > 0 && column_idx < column_len ){
-                // Include an edge from a cell division
-                size_t upper_cell_idx = (row_idx - 1) * column_len + column_idx;
-                if( upper_cell_idx % (divided + not_divided) >= not_divided ){
-                    // An edge from (row_idx; column_idx) to (row_idx - 1; column_idx + 1)
-                    JA[edge_idx] = node_idx - column_len;
-                    A[edge_idx] = 1;
-                    ++edge_idx;
-                }
-            }
-            // Edge from (row_idx; column_idx) to (row_idx; column_idx - 1)
-            if( column_idx > 0 ){
-                JA[edge_idx] = node_idx - 1;
-                A[edge_idx] = 1;
-                ++edge_idx;
-            }
-			// Edge from a node to itself
-			JA[edge_idx] = node_idx;
-			A[edge_idx] = 1;
-			++edge_idx;
-            // Edge from (row_idx; column_idx) to (row_idx; column_idx + 1)
-            if( column_idx < column_len ){
-                JA[edge_idx] = node_idx + 1;
-                A[edge_idx] = 1;
-                ++edge_idx;
-            }
-            // Look at the cell below
-            if( row_idx < row_len && column_idx > 0 ){
-                size_t below_cell_idx = row_idx * column_len + column_idx - 1;
-                if( below_cell_idx % (divided + not_divided) >= not_divided ){
-                    // An edge from (row_idx; column_idx) to (row_idx + 1; column_idx - 1)
-                    JA[edge_idx] = node_idx + column_len;
-                    A[edge_idx] = 1;
-                    ++edge_idx;
-                }
-            }
-            if( row_idx < row_len ){
-                // Edge from (row_idx; column_idx) to (row_idx + 1; column_idx)
-                JA[edge_idx] = node_idx + (column_len + 1);
-                A[edge_idx] = 1;
-                ++edge_idx;
-            }
+        if( row_idx > 0 && row_idx < row_len ){
+            edge_idx = generateGridRow<is_filled, pattern, true, true>(
+                row_idx, edge_idx, params_p, coefficients);
+        } else if( row_len == 0 ){
+            edge_idx = generateGridRow<is_filled, pattern, false, false>(
+                row_idx, edge_idx, params_p, coefficients);
+        } else if( row_idx == 0 ){
+            edge_idx = generateGridRow<is_filled, pattern, false, true>(
+                row_idx, edge_idx, params_p, coefficients);
+        } else{
+            edge_idx = generateGridRow<is_filled, pattern, true, false>(
+                row_idx, edge_idx, params_p, coefficients);
         }
-        // On the last row write the total number of edges
+        // The arrays were allocated for the calculated number of edges
         if( row_idx == row_len ){
-            edges_count_ = edge_idx;
+            assert( edge_idx == edges_count_);
         }
+    }
     }
 	IA[nodes_count_] = edges_count_;
 }
+/**
+ * Generate a row of the grid from the edge edge_idx.
+ * The first and the last nodes of the row are taken out of the loop,
+ * so the loop over the inner nodes doesn't check the borders.
+ * Results:
+ *      The edge index after the row
+ */
+template <typename Index_t, typename Value_t>
+template <bool is_filled, MatrixParameters::DividePattern_t pattern,
+          bool has_upper, bool has_lower, typename Coefficients_t>
+size_t
+NetGraphT<Index_t, Value_t>::generateGridRow( size_t row_idx, size_t edge_idx,
+                                              MatrixParameters *params_p,
+                                              const Coefficients_t& coefficients){
+    size_t column_len = params_p->getColumnLen();
+    if( column_len == 0 ){
+        generateNode<is_filled, pattern, has_upper, has_lower, false, false>(
+            row_idx, 0, edge_idx, params_p, coefficients);
+        return edge_idx;
+    }
+    generateNode<is_filled, pattern, has_upper, has_lower, false, true>(
+        row_idx, 0, edge_idx, params_p, coefficients);
+    for( size_t column_idx = 1; column_idx < column_len; ++column_idx ){
+        generateNode<is_filled, pattern, has_upper, has_lower, true, true>(
+            row_idx, column_idx, edge_idx, params_p, coefficients);
+    }
+    generateNode<is_filled, pattern, has_upper, has_lower, true, false>(
+        row_idx, column_len, edge_idx, params_p, coefficients);
+    return edge_idx;
+}
+/**
+ * Generate the row of a node. The neighbors, that the node has,
+ * are the template parameters, so the generator of a part of the grid
+ * doesn't check them
+ */
+template <typename Index_t, typename Value_t>
+template <bool is_filled, MatrixParameters::DividePattern_t pattern,
+          bool has_upper, bool has_lower, bool has_left, bool has_right,
+          typename Coefficients_t>
+inline void
+NetGraphT<Index_t, Value_t>::generateNode( size_t row_idx, size_t column_idx,
+                                           size_t& edge_idx,
+                                           MatrixParameters *params_p,
+                                           const Coefficients_t& coefficients){
+    size_t column_len = params_p->getColumnLen();
+    size_t not_divided = params_p->getNotDivided();
+    size_t divided = params_p->getDivided();
+    size_t node_idx = row_idx * (column_len + 1) + column_idx;
+    IA[node_idx] = edge_idx;
+    // A sum of the cells on the row, except for the diagonal
+    double row_sum = 0;
+    if( has_upper ){
+        // Edge from (row_idx; column_idx) to (row_idx - 1; column_idx)
+        addEdge<is_filled>( edge_idx, node_idx - (column_len + 1),
+            coefficients.getUpper( column_idx), row_sum);
+    }
+    if( has_upper && has_right ){
+        // Include an edge from a cell division
+        size_t upper_cell_idx = (row_idx - 1) * column_len + column_idx;
+        if( MatrixParameters::isCellDivided<pattern>( upper_cell_idx,
+                not_divided, divided) ){
+            // An edge from (row_idx; column_idx) to (row_idx - 1; column_idx + 1)
+            addEdge<is_filled>( edge_idx, node_idx - column_len,
+                coefficients.getUpperDivided( column_idx), row_sum);
+        }
+    }
+    // Edge from (row_idx; column_idx) to (row_idx; column_idx - 1)
+    if( has_left ){
+        addEdge<is_filled>( edge_idx, node_idx - 1,
+            coefficients.getLeft( column_idx), row_sum);
+    }
+    // Edge from a node to itself, it is set after the other edges
+    size_t diagonal_idx = edge_idx;
+    JA[edge_idx] = node_idx;
+    ++edge_idx;
+    // Edge from (row_idx; column_idx) to (row_idx; column_idx + 1)
+    if( has_right ){
+        addEdge<is_filled>( edge_idx, node_idx + 1,
+            coefficients.getRight( column_idx), row_sum);
+    }
+    // Look at the cell below
+    if( has_lower && has_left ){
+        size_t below_cell_idx = row_idx * column_len + column_idx - 1;
+        if( MatrixParameters::isCellDivided<pattern>( below_cell_idx,
+                not_divided, divided) ){
+            // An edge from (row_idx; column_idx) to (row_idx + 1; column_idx - 1)
+            addEdge<is_filled>( edge_idx, node_idx + column_len,
+                coefficients.getLowerDivided( column_idx), row_sum);
+        }
+    }
+    if( has_lower ){
+        // Edge from (row_idx; column_idx) to (row_idx + 1; column_idx)
+        addEdge<is_filled>( edge_idx, node_idx + (column_len + 1),
+            coefficients.getLower( column_idx), row_sum);
+    }
+    A[diagonal_idx] = is_filled ? DOMINANCE_COEFF * row_sum : 1;
+}
 /**
  * Calculate a number of the not-divided and divided cells
  * on the rows [0; row_idx-2)
  * Results:
  *      A pair (not-divided, divided)
  */
-std::pair<int,int> 
-NetGraph::countDividedCells( size_t row_idx, MatrixParameters* params_p){
-    size_t row_len = params_p->getRowLen();
+template <typename Index_t, typename Value_t>
+std::pair<size_t, size_t>
+NetGraphT<Index_t, Value_t>::countDividedCells( size_t row_idx, MatrixParameters* params_p){
     size_t column_len = params_p->getColumnLen();
     size_t not_divided = params_p->getNotDivided();
     size_t divided = params_p->getDivided();
@@ -149,72 +438,166 @@ NetGraph::countDividedCells( size_t row_idx, MatrixParameters* params_p){
     size_t row_divided_nodes = row_cells - row_not_divided_nodes;
     return std::make_pair( row_not_divided_nodes, row_divided_nodes);
 }
+/**
+ * Calculate a number of the edges( not-null cells) of the graph.
+ * Every node has an edge to itself, every other edge is stored twice:
+ * the horizontal and the vertical edges of the grid
+ * and the edges of the divided cells.
+ */
+template <typename Index_t, typename Value_t>
+size_t
+NetGraphT<Index_t, Value_t>::countEdges( MatrixParameters* params_p){
+    size_t row_len = params_p->getRowLen();
+    size_t column_len = params_p->getColumnLen();
+    size_t nodes_count = (row_len + 1) * (column_len + 1);
+    // The cells on all rows [0; row_len)
+    size_t divided_cells = countDividedCells( row_len + 1, params_p).second;
+    size_t grid_edges = (row_len + 1) * column_len + row_len * (column_len + 1);
+    return nodes_count + 2 * (grid_edges + divided_cells);
+}
 /** 
  * Fill the matrix
  * Make it diagonally dominant
  */
-void NetGraph::fillMatrix( int threads_num ){ // A number of threads
-    const double DOMINANCE_COEFF = 2;
-    //omp_set_num_threads( threads_num);
-    //
-    #pragma omp parallel for
-    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx){
-        // A sum of all matrix cells on the row, except for the diagonal
-        double row_sum = 0;
-        /**
-         * For the rightmost node IA doesn't specify the edges index.
-         * Instead, get it from the graph
-         */
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
-        /** 
-         * A position of a diagonal element:
-         * of a node that has an edge to itself
-         */
-        size_t diagonal_idx = 0;
-        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
-            // An other node of the edge
-            size_t neighbor_idx = JA[edge_idx];
-            if( neighbor_idx == node_idx ){
-                diagonal_idx = edge_idx;
-            } else{
-                A[edge_idx] = cos( node_idx + neighbor_idx 
-                    + node_idx * neighbor_idx );
-                row_sum += fabs( A[edge_idx]);
+template <typename Index_t, typename Value_t>
+void NetGraphT<Index_t, Value_t>::fillMatrix(){
+    // The cost of a row is proportional to its edges
+    prepareThreads( omp_get_max_threads());
+    const std::vector<size_t>& partition = getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    #pragma omp parallel for schedule( static, 1)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        for( size_t node_idx = partition[part_idx];
+             node_idx < partition[part_idx + 1]; ++node_idx){
+            // A sum of all matrix cells on the row, except for the diagonal
+            double row_sum = 0;
+            size_t end_idx = IA[node_idx + 1];
+            /** 
+             * A position of a diagonal element:
+             * of a node that has an edge to itself
+             */
+            size_t diagonal_idx = 0;
+            for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
+                // An other node of the edge
+                size_t neighbor_idx = JA[edge_idx];
+                if( neighbor_idx == node_idx ){
+                    diagonal_idx = edge_idx;
+                } else{
+                    A[edge_idx] = cos( node_idx + neighbor_idx 
+                        + node_idx * neighbor_idx );
+                    row_sum += fabs( A[edge_idx]);
+                }
             }
+            A[diagonal_idx] = DOMINANCE_COEFF * row_sum;
         }
-        A[diagonal_idx] = DOMINANCE_COEFF * row_sum;
     }
 }
 /**
- * Make a diagonal matrix from the current graph
- * If is_reverse = true, then make it reversed
+ * Copy the diagonal of the current graph
  */
-NetGraph NetGraph::makeDiagonalMatrix( bool is_reverse){
-    int* diagonal_IA = new int[nodes_count_];
-    int* diagonal_JA = new int[nodes_count_];
-    double* diagonal_A = new double[nodes_count_];
-    #pragma omp parallel for
-    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
-        diagonal_IA[node_idx] = node_idx;
-        /**
-         * For the rightmost node IA doesn't specify the edges index.
-         * Instead, get it from the graph
-         */
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
-        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
-        ++edge_idx){
-            if(JA[edge_idx] == node_idx ){
-                diagonal_JA[node_idx] = node_idx;
-                if( is_reverse ){
-                    diagonal_A[node_idx] = 1.0 / A[edge_idx];
-                } else{
-                    diagonal_A[node_idx] = A[edge_idx];
+template <typename Index_t, typename Value_t>
+void NetGraphT<Index_t, Value_t>::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    prepareThreads( omp_get_max_threads());
+    const std::vector<size_t>& partition = getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    #pragma omp parallel for schedule( static, 1)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        for( size_t node_idx = partition[part_idx];
+             node_idx < partition[part_idx + 1]; ++node_idx ){
+            size_t end_idx = IA[node_idx + 1];
+            for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+            ++edge_idx){
+                if( static_cast<size_t>( JA[edge_idx]) == node_idx ){
+                    diagonal[node_idx] = A[edge_idx];
                 }
             }
         }
     }
-    return NetGraph( nodes_count_, nodes_count_, diagonal_IA, diagonal_JA,
-    diagonal_A);
 }
+/**
+ * Get the partition of the rows, that prepareThreads() made.
+ * The partition isn't changed here, so the threads of a region
+ * read it without a lock. A team may have less threads than the parts,
+ * so the parts are shared by the loops over them.
+ * Results:
+ *      The bounds of the parts: part part_idx has the rows
+ *      [partition[part_idx]; partition[part_idx + 1])
+ */
+template <typename Index_t, typename Value_t>
+const std::vector<size_t>& 
+NetGraphT<Index_t, Value_t>::getRowPartition(){
+    return row_partition_;
+}
+/**
+ * Get a partition with the same number of rows in the parts,
+ * as the static schedule makes it
+ */
+template <typename Index_t, typename Value_t>
+std::vector<size_t>
+NetGraphT<Index_t, Value_t>::makeUniformPartition( size_t parts_count){
+    std::vector<size_t> partition( parts_count + 1);
+    for( size_t part_idx = 0; part_idx <= parts_count; ++part_idx ){
+        partition[part_idx] = nodes_count_ * part_idx / parts_count;
+    }
+    return partition;
+}
+/**
+ * Calculate how unbalanced a partition is
+ * Results:
+ *      The maximum number of edges in a part to the average number
+ */
+template <typename Index_t, typename Value_t>
+double
+NetGraphT<Index_t, Value_t>::calculateImbalance( const std::vector<size_t>& partition){
+    size_t parts_count = partition.size() - 1;
+    size_t max_part_edges = 0;
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        size_t start_idx = IA[partition[part_idx]];
+        size_t end_idx = IA[partition[part_idx + 1]];
+        max_part_edges = std::max( max_part_edges, end_idx - start_idx);
+    }
+    return static_cast<double>( max_part_edges) * parts_count / edges_count_;
+}
+/**
+ * The operations of the CSR graph as a matrix of the solver
+ */
+template <typename Index_t, typename Value_t>
+void NetGraphT<Index_t, Value_t>::multiply( MathVector& vec, MathVector& result){
+    sparseMV( *this, vec, result);
+}
+template <typename Index_t, typename Value_t>
+double NetGraphT<Index_t, Value_t>::multiplyDot( MathVector& vec,
+                                                 MathVector& result){
+    return sparseMVDot( *this, vec, result);
+}
+template <typename Index_t, typename Value_t>
+double NetGraphT<Index_t, Value_t>::multiplyDotInRegion( MathVector& vec,
+                                                         MathVector& result){
+    return sparseMVDotInRegion( *this, vec, result);
+}
+/**
+ * Split the rows between the threads, so the parts have almost the same
+ * number of the edges. A loop over the parts with schedule( static, 1) gives
+ * every thread a single part. The partition is recalculated only
+ * if the number of the threads changes, it is called outside the regions.
+ */
+template <typename Index_t, typename Value_t>
+void NetGraphT<Index_t, Value_t>::prepareThreads( size_t threads_num){
+    if( row_partition_.size() == threads_num + 1 ){
+        return;
+    }
+    row_partition_.assign( threads_num + 1, nodes_count_);
+    row_partition_[0] = 0;
+    for( size_t part_idx = 1; part_idx < threads_num; ++part_idx ){
+        // The part begins at the first row with the edges after the bound
+        size_t edges_bound = edges_count_ * part_idx / threads_num;
+        row_partition_[part_idx] = std::lower_bound( IA, IA + nodes_count_,
+            edges_bound) - IA;
+    }
+}
+// The graphs with the 32-bit and the 64-bit indices, the double and float cells
+template class NetGraphT<int, double>;
+template class NetGraphT<int64_t, double>;
+template class NetGraphT<int, float>;
+template class NetGraphT<int64_t, float>;
@@ -1,20 +1,43 @@
 #ifndef GRAPH_PREPARE_H
     #define GRAPH_PREPARE_H
+#include <cassert>
 #include <iostream>
 #include <cstddef>
 #include <cmath>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <stdint.h>
+#include "tsk1_operator.h"
+#include "tsk1_memory.h"
 enum { 
-    NETGRAPH_MAX_EDGES_NODE = 6,
     NETGRAPH_NOT_DIVIDED_EDGES = 2,
     NETGRAPH_DIVIDED_EDGES = 3
 };
 class MatrixParameters{
 public:
     typedef enum{ 
-        // A number of columns and row can't exceed this
-        MAX_MATRIX_DIMENSION = 10000,
+        /**
+         * A number of columns and row can't exceed this.
+         * The nodes fit into int, the cells may need the 64-bit indices.
+         */
+        MAX_MATRIX_DIMENSION = 46000,
         MAX_CELLS = MAX_MATRIX_DIMENSION * MAX_MATRIX_DIMENSION
     } MatrixConstraints_t;
+    /**
+     * The patterns of the divided cells, that have the specialized
+     * generators. The other patterns are generic.
+     */
+    typedef enum{
+        // Any numbers of the not divided and divided cells
+        PATTERN_GENERIC = 0,
+        // Every cell is divided
+        PATTERN_ALL_DIVIDED,
+        // No cell is divided
+        PATTERN_NONE_DIVIDED,
+        // A not divided cell, then a divided one
+        PATTERN_ALTERNATING
+    } DividePattern_t;
     size_t getRowLen(){
         return row_len_;
     }
@@ -36,12 +59,57 @@ public:
         not_divided_ = not_divided;
         divided_ = divided;
     }
+    /**
+     * Get the pattern of the divided cells, that the generator
+     * is specialized for
+     */
+    DividePattern_t getDividePattern(){
+        if( generic_pattern_ ){
+            return PATTERN_GENERIC;
+        }
+        if( divided_ == 0 ){
+            return PATTERN_NONE_DIVIDED;
+        }
+        if( not_divided_ == 0 ){
+            return PATTERN_ALL_DIVIDED;
+        }
+        if( not_divided_ == 1 && divided_ == 1 ){
+            return PATTERN_ALTERNATING;
+        }
+        return PATTERN_GENERIC;
+    }
+    /**
+     * Take the generic generator for any pattern,
+     * the specialized ones are compared with it
+     */
+    void setGenericPattern( bool generic_pattern){
+        generic_pattern_ = generic_pattern;
+    }
+    /**
+     * Is the cell divided. The pattern is known at the compile time,
+     * so the specialized loops don't take the modulo
+     */
+    template <DividePattern_t pattern>
+    static bool isCellDivided( size_t cell_idx, size_t not_divided,
+                               size_t divided){
+        switch( pattern ){
+        case PATTERN_ALL_DIVIDED:
+            return true;
+        case PATTERN_NONE_DIVIDED:
+            return false;
+        case PATTERN_ALTERNATING:
+            return cell_idx % 2 == 1;
+        default:
+            return cell_idx % (divided + not_divided) >= not_divided;
+        }
+    }
     MatrixParameters( size_t row_len, size_t column_len, size_t not_divided, size_t divided): 
         row_len_( row_len), column_len_( column_len),
-        not_divided_( not_divided), divided_( divided) {}
+        not_divided_( not_divided), divided_( divided),
+        generic_pattern_( false) {}
     MatrixParameters(): 
         row_len_( 0), column_len_( 0),
-        not_divided_( 0), divided_( 0) {}
+        not_divided_( 0), divided_( 0), generic_pattern_( false) {}
 private:
     size_t row_len_;
     size_t column_len_;
@@ -56,50 +124,72 @@ private:
     size_t not_divided_;
     // A number of cut in half cells
     size_t divided_;
+    // Is the generic generator taken for the specialized patterns
+    bool generic_pattern_;
 };
-class NetGraph{
 /** 
  * A matrix describes the graph.
  * Matrix rows are the graph nodes.
+ * IA and JA are of the index type: the 32-bit indices move less bytes,
+ * the 64-bit ones are for the graphs with more than 2^31 cells.
+ * A is of the value type.
  */
+template <typename Index_t, typename Value_t>
+class NetGraphT: public MatrixOperator{
 public:
-NetGraph( MatrixParameters *params_p ){
+NetGraphT( MatrixParameters *params_p ){
     size_t row_len = params_p->getRowLen();
     size_t column_len = params_p->getColumnLen();
     nodes_count_ = (row_len + 1) * (column_len + 1);
-    size_t edges_count_max = nodes_count_ * NETGRAPH_MAX_EDGES_NODE;
-    IA = new int[nodes_count_ + 1];
-    JA = new int[2 * edges_count_max];
-    A = new double[2 * edges_count_max];
+    // The number of the edges follows from the parameters
+    edges_count_ = countEdges( params_p);
+    IA = allocateArray<Index_t>( nodes_count_ + 1);
+    JA = allocateArray<Index_t>( edges_count_);
+    A = allocateArray<Value_t>( edges_count_);
 }
 /** 
  * Not generate a graph(a matrix) conventional way
  * Instead, manually insert already prepared
+ * The graph takes the arrays, they must be taken by allocateArray(),
+ * IA has nodes_count + 1 entries and ends with edges_count
  */
-NetGraph( size_t nodes_count, size_t edges_count, int* IA, int *JA, double *A){
+NetGraphT( size_t nodes_count, size_t edges_count, Index_t* IA, Index_t *JA,
+           Value_t *A){
     nodes_count_ = nodes_count;
     edges_count_ = edges_count;
     this->IA = IA;
     this->JA = JA;
     this->A = A;
+    assert( static_cast<size_t>( IA[nodes_count]) == edges_count);
 }
-~NetGraph(){
-    delete IA;
+// The graph owns its arrays, so it is moved, not copied
+NetGraphT( const NetGraphT&) = delete;
+NetGraphT& operator=( const NetGraphT&) = delete;
+NetGraphT( NetGraphT&& graph): IA( graph.IA), JA( graph.JA), A( graph.A),
+    nodes_count_( graph.nodes_count_), edges_count_( graph.edges_count_),
+    row_partition_( std::move( graph.row_partition_)){
+    graph.IA = NULL;
+    graph.JA = NULL;
+    graph.A = NULL;
+    graph.nodes_count_ = 0;
+    graph.edges_count_ = 0;
+}
+~NetGraphT(){
+    freeArray( IA);
     // Not-null matrix columns
-    delete JA;
+    freeArray( JA);
     // An array that stores matrix coefficients
-    delete A;
+    freeArray( A);
 }
 void printGraph(){
-    for( int node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
         std::cout << "Node index: " << node_idx << std::endl << "Edges to: ";        
-        size_t end_idx = node_idx + 1 < nodes_count_ ? IA[node_idx + 1] :
-            edges_count_;
-        for( int edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
             std::cout << JA[edge_idx] << " ";
         }
         std::cout << std::endl << "Matrix elements: ";
-        for( int edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
             std::cout << A[edge_idx] << " ";
         }
         std::cout << std::endl;
@@ -111,31 +201,74 @@ size_t getNodesCount(){
 size_t getEdgesCount(){
     return edges_count_;
 }
-int* getIA(){
+Index_t* getIA(){
 	return IA;
 }
-int* getJA(){
+Index_t* getJA(){
 	return JA;
 }
-double* getA(){
+Value_t* getA(){
     return A;
 }
-void generate( MatrixParameters *params_p, int threads_num );
-void fillMatrix( int threads_num);
-std::pair<int, int> countDividedCells( size_t row_idx, MatrixParameters* params_p );
-NetGraph makeDiagonalMatrix( bool is_reverse);
+/**
+ * Can the index type address the cells of a graph
+ */
+static bool isIndexFitting( size_t edges_count){
+    return edges_count <= static_cast<size_t>(
+        std::numeric_limits<Index_t>::max());
+}
+void generate( MatrixParameters *params_p);
+void generateFilled( MatrixParameters *params_p);
+void fillMatrix();
+static std::pair<size_t, size_t> countDividedCells( size_t row_idx,
+    MatrixParameters* params_p );
+static size_t countEdges( MatrixParameters* params_p);
+void copyDiagonal( MathVector& diagonal);
+// The matrix operations of the solver, the CSR sparse multiplication
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void prepareThreads( size_t threads_num);
+const std::vector<size_t>& getRowPartition();
+std::vector<size_t> makeUniformPartition( size_t parts_count);
+double calculateImbalance( const std::vector<size_t>& partition);
 private:
+    template <bool is_filled>
+    void generateRows( MatrixParameters *params_p);
+    template <bool is_filled, MatrixParameters::DividePattern_t pattern>
+    void generatePatternRows( MatrixParameters *params_p);
+    template <bool is_filled, MatrixParameters::DividePattern_t pattern,
+              bool has_upper, bool has_lower, typename Coefficients_t>
+    size_t generateGridRow( size_t row_idx, size_t edge_idx,
+                            MatrixParameters *params_p,
+                            const Coefficients_t& coefficients);
+    template <bool is_filled, MatrixParameters::DividePattern_t pattern,
+              bool has_upper, bool has_lower, bool has_left, bool has_right,
+              typename Coefficients_t>
+    void generateNode( size_t row_idx, size_t column_idx, size_t& edge_idx,
+                       MatrixParameters *params_p,
+                       const Coefficients_t& coefficients);
+    template <bool is_filled>
+    void addEdge( size_t& edge_idx, size_t neighbor_idx, double coefficient,
+                  double& row_sum);
     /** 
      * JA and A stores information about all rows.
      * To get information about a single row,
      * you have to know the index, where
      * JA and A store it.
      */
-    int* IA;
-    int* JA;
-    double* A;
+    Index_t* IA;
+    Index_t* JA;
+    Value_t* A;
     size_t nodes_count_;
     // A number of the edges( not-null cells) in the graph
     size_t edges_count_;
+    /**
+     * The rows of the parts with almost the same number of edges.
+     * The part part_idx has the rows
+     * [row_partition_[part_idx]; row_partition_[part_idx + 1])
+     */
+    std::vector<size_t> row_partition_;
 };
+typedef NetGraphT<int64_t, double> NetGraph64;
 #endif
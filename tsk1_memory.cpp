@@ -0,0 +1,239 @@
+/**
+ * The arena of the matrix arrays and the vectors
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <new>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "tsk1_memory.h"
+/**
+ * Round the bytes up to a multiple of the alignment
+ */
+static size_t alignUp( size_t bytes, size_t alignment){
+    return ( bytes + alignment - 1) / alignment * alignment;
+}
+MemoryArena& MemoryArena::getArena(){
+    static MemoryArena program_arena;
+    return program_arena;
+}
+/**
+ * Map a region of the capacity bytes for the arena.
+ * The arrays of the previous region must be freed before.
+ * The memory is taken by the system, when it is written first,
+ * so the capacity may be larger than the arrays need.
+ * If the huge pages of hugetlbfs aren't available, the region is mapped
+ * with the transparent huge pages.
+ * Results:
+ *      true, if the region is mapped. Otherwise the arrays are taken
+ *      from the heap
+ */
+bool MemoryArena::reserve( size_t capacity, PageMode_t page_mode){
+    release();
+    // The statistics are counted from the reserve
+    statistics_ = ArenaStatistics();
+    if( page_mode == PAGES_NONE || capacity == 0 ){
+        return false;
+    }
+#ifdef __linux__
+    // A huge page must be mapped at its boundary
+    size_t mapped_size = alignUp( capacity, HUGE_PAGE_SIZE);
+    void* region_p = MAP_FAILED;
+    #ifdef MAP_HUGETLB
+    if( page_mode == PAGES_HUGE ){
+        // The pages are reserved now, so the region fails here, not on a write
+        region_p = mmap( NULL, mapped_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if( region_p == MAP_FAILED ){
+            std::cout << "Can't map the huge pages, the transparent huge "
+            "pages are used" << std::endl;
+        }
+    }
+    #endif
+    if( region_p == MAP_FAILED ){
+        if( page_mode == PAGES_HUGE ){
+            page_mode = PAGES_TRANSPARENT;
+        }
+        // Leave a huge page for the alignment of the region
+        mapped_size += HUGE_PAGE_SIZE;
+        region_p = mmap( NULL, mapped_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if( region_p == MAP_FAILED ){
+            return false;
+        }
+    }
+    char* region = static_cast<char*>( region_p);
+    char* aligned_region = region;
+    if( page_mode != PAGES_HUGE ){
+        aligned_region = reinterpret_cast<char*>( alignUp(
+            reinterpret_cast<uintptr_t>( region), HUGE_PAGE_SIZE));
+    }
+    #ifdef MADV_HUGEPAGE
+    if( page_mode == PAGES_TRANSPARENT ){
+        madvise( aligned_region, alignUp( capacity, HUGE_PAGE_SIZE),
+            MADV_HUGEPAGE);
+    }
+    #endif
+    // The region is unmapped from its start
+    mapped_region_ = region;
+    mapped_size_ = mapped_size;
+    region_ = aligned_region;
+    capacity_ = alignUp( capacity, HUGE_PAGE_SIZE);
+    page_mode_ = page_mode;
+    statistics_.used_bytes_ = 0;
+    return true;
+#else
+    // Only the heap is supported on the other systems
+    return false;
+#endif
+}
+/**
+ * Unmap the region. The arrays of the arena must be freed before.
+ */
+void MemoryArena::release(){
+#ifdef __linux__
+    if( mapped_region_ ){
+        munmap( mapped_region_, mapped_size_);
+    }
+#endif
+    mapped_region_ = NULL;
+    mapped_size_ = 0;
+    region_ = NULL;
+    capacity_ = 0;
+    page_mode_ = PAGES_NONE;
+    statistics_.used_bytes_ = 0;
+}
+/**
+ * Take an array from the heap. The pointer to the allocated memory
+ * is kept just before the aligned array.
+ */
+void* MemoryArena::allocateHeap( size_t bytes){
+    char* memory_p = static_cast<char*>( ::operator new( bytes +
+        MEMORY_ALIGNMENT + sizeof( void*)));
+    char* aligned_p = reinterpret_cast<char*>( alignUp(
+        reinterpret_cast<uintptr_t>( memory_p + sizeof( void*)),
+        MEMORY_ALIGNMENT));
+    reinterpret_cast<void**>( aligned_p)[-1] = memory_p;
+    return aligned_p;
+}
+/**
+ * Take the next aligned piece of the region
+ * Results:
+ *      The array aligned by MEMORY_ALIGNMENT
+ */
+void* MemoryArena::allocate( size_t bytes){
+    void* memory_p = NULL;
+    size_t aligned_bytes = alignUp( bytes ? bytes : 1, MEMORY_ALIGNMENT);
+    #pragma omp critical( memory_arena)
+    {
+        if( region_ && capacity_ - statistics_.used_bytes_ >= aligned_bytes ){
+            memory_p = region_ + statistics_.used_bytes_;
+            statistics_.used_bytes_ += aligned_bytes;
+            ++statistics_.arena_allocations_;
+            if( statistics_.used_bytes_ > statistics_.peak_bytes_ ){
+                statistics_.peak_bytes_ = statistics_.used_bytes_;
+            }
+        } else{
+            ++statistics_.heap_allocations_;
+            statistics_.heap_bytes_ += aligned_bytes;
+        }
+    }
+    if( !memory_p ){
+        memory_p = allocateHeap( aligned_bytes);
+    }
+    return memory_p;
+}
+/**
+ * Free an array. An array of the arena is released by the reset.
+ */
+void MemoryArena::deallocate( void* memory_p){
+    if( !memory_p || isInArena( memory_p) ){
+        return;
+    }
+    ::operator delete( reinterpret_cast<void**>( memory_p)[-1]);
+}
+/**
+ * Release the arrays, that were taken after the mark
+ */
+void MemoryArena::reset( size_t mark){
+    #pragma omp critical( memory_arena)
+    {
+        if( mark < statistics_.used_bytes_ ){
+            statistics_.used_bytes_ = mark;
+        }
+        ++statistics_.resets_count_;
+    }
+}
+/**
+ * Get the bytes of the region, that the system backs by the transparent
+ * huge pages
+ * Results:
+ *      The bytes from /proc/self/smaps, 0 on the other systems
+ */
+size_t MemoryArena::getHugePagesBytes() const{
+    size_t huge_bytes = 0;
+#ifdef __linux__
+    if( !region_ ){
+        return 0;
+    }
+    std::ifstream smaps_file( "/proc/self/smaps");
+    std::string line;
+    bool is_region = false;
+    uintptr_t region_start = reinterpret_cast<uintptr_t>( region_);
+    uintptr_t region_end = region_start + capacity_;
+    while( std::getline( smaps_file, line) ){
+        std::istringstream line_stream( line);
+        std::string field;
+        line_stream >> field;
+        // A mapping starts with its address range, e.g. 7f00-7f80
+        size_t dash_pos = field.find( '-');
+        if( dash_pos != std::string::npos && field[field.size() - 1] != ':' ){
+            uintptr_t mapping_start = 0, mapping_end = 0;
+            std::istringstream( field.substr( 0, dash_pos)) >> std::hex >>
+                mapping_start;
+            std::istringstream( field.substr( dash_pos + 1)) >> std::hex >>
+                mapping_end;
+            // madvise() may split the region into several mappings
+            is_region = mapping_start < region_end &&
+                mapping_end > region_start;
+        } else if( is_region && ( field == "AnonHugePages:" ||
+                   field == "Private_Hugetlb:") ){
+            size_t kbytes = 0;
+            line_stream >> kbytes;
+            huge_bytes += kbytes * 1024;
+        }
+    }
+#endif
+    return huge_bytes;
+}
+const char* MemoryArena::getPageModeName( PageMode_t page_mode){
+    switch( page_mode ){
+        case PAGES_SMALL:
+            return "small";
+        case PAGES_TRANSPARENT:
+            return "thp";
+        case PAGES_HUGE:
+            return "huge";
+        default:
+            return "none";
+    }
+}
+void MemoryArena::printStatistics() const{
+    std::cout << "Arena pages: " << getPageModeName( page_mode_) << std::endl;
+    std::cout << "Arena capacity MB: " << capacity_ / ( 1 << 20) << std::endl;
+    std::cout << "Arena peak MB: " << statistics_.peak_bytes_ / ( 1 << 20) <<
+    std::endl;
+    std::cout << "Arena huge pages MB: " << getHugePagesBytes() / ( 1 << 20) <<
+    std::endl;
+    std::cout << "Arena allocations: " << statistics_.arena_allocations_ <<
+    std::endl;
+    std::cout << "Heap allocations: " << statistics_.heap_allocations_ <<
+    std::endl;
+    std::cout << "Heap MB: " << statistics_.heap_bytes_ / ( 1 << 20) <<
+    std::endl;
+    std::cout << "Arena resets: " << statistics_.resets_count_ << std::endl;
+}
@@ -0,0 +1,134 @@
+#ifndef MEMORY_H
+    #define MEMORY_H
+#include <cstddef>
+enum {
+    // The arrays start at a cache line, so a vector load doesn't split lines
+    MEMORY_ALIGNMENT = 64,
+    // A transparent huge page and a huge page of hugetlbfs on x86-64
+    HUGE_PAGE_SIZE = 2 * 1024 * 1024
+};
+/**
+ * The statistics of the allocations, that the arena has made
+ */
+class ArenaStatistics{
+public:
+    ArenaStatistics(): arena_allocations_( 0), heap_allocations_( 0),
+        used_bytes_( 0), peak_bytes_( 0), heap_bytes_( 0), resets_count_( 0) {}
+    // A number of the arrays, that were taken from the arena
+    size_t arena_allocations_;
+    /**
+     * A number of the arrays, that were taken from the heap:
+     * the arena is not reserved or doesn't have the space
+     */
+    size_t heap_allocations_;
+    // The bytes taken from the arena after the last reset
+    size_t used_bytes_;
+    // The maximum of the used bytes
+    size_t peak_bytes_;
+    // The bytes of the arrays from the heap
+    size_t heap_bytes_;
+    size_t resets_count_;
+};
+/**
+ * An arena of the matrix arrays and the vectors.
+ * The arena maps one region of memory, and an array is the next
+ * 64-byte aligned piece of it. The arrays aren't freed one by one:
+ * the arena is reset to a mark, and every array taken after the mark
+ * is released at once. The solve is the unit: the graph and the right part
+ * are taken before the solve, the preconditioner and the solver vectors
+ * during it, and the arena is reset after the solve.
+ * The region may be backed by the huge pages, so a sweep over
+ * the arrays of hundreds of megabytes takes a few TLB entries
+ * instead of thousands.
+ * If the arena isn't reserved or is full, an array is taken
+ * from the heap with the same alignment.
+ */
+class MemoryArena{
+public:
+    typedef enum{
+        // The arena isn't used, every array is taken from the heap
+        PAGES_NONE = 0,
+        // The pages of the system size
+        PAGES_SMALL,
+        // The transparent huge pages, madvise( MADV_HUGEPAGE)
+        PAGES_TRANSPARENT,
+        // The huge pages of hugetlbfs, they must be reserved in the system
+        PAGES_HUGE
+    } PageMode_t;
+    MemoryArena(): mapped_region_( NULL), region_( NULL), capacity_( 0),
+        mapped_size_( 0), page_mode_( PAGES_NONE) {}
+    MemoryArena( const MemoryArena&) = delete;
+    ~MemoryArena(){
+        release();
+    }
+    /**
+     * The arena of the program arrays
+     */
+    static MemoryArena& getArena();
+    bool reserve( size_t capacity, PageMode_t page_mode);
+    void release();
+    void* allocate( size_t bytes);
+    void deallocate( void* memory_p);
+    bool isInArena( const void* memory_p) const{
+        return region_ && static_cast<const char*>( memory_p) >= region_ &&
+            static_cast<const char*>( memory_p) < region_ + capacity_;
+    }
+    /**
+     * Get the mark of the arena: the arrays, that are taken after it,
+     * are released by reset( mark)
+     */
+    size_t getMark() const{
+        return statistics_.used_bytes_;
+    }
+    void reset( size_t mark);
+    size_t getCapacity() const{
+        return capacity_;
+    }
+    // The page mode, that the region was mapped with
+    PageMode_t getPageMode() const{
+        return page_mode_;
+    }
+    const ArenaStatistics& getStatistics() const{
+        return statistics_;
+    }
+    size_t getHugePagesBytes() const;
+    void printStatistics() const;
+    static const char* getPageModeName( PageMode_t page_mode);
+private:
+    void* allocateHeap( size_t bytes);
+    // The mapped memory and its part aligned by a huge page
+    char* mapped_region_;
+    char* region_;
+    size_t capacity_;
+    size_t mapped_size_;
+    PageMode_t page_mode_;
+    ArenaStatistics statistics_;
+};
+/**
+ * Take an aligned array from the arena of the program.
+ * The array is freed by freeArray().
+ */
+template <typename Value_t>
+Value_t* allocateArray( size_t count){
+    return static_cast<Value_t*>( MemoryArena::getArena().allocate(
+        count * sizeof( Value_t)));
+}
+template <typename Value_t>
+void freeArray( Value_t* values){
+    MemoryArena::getArena().deallocate( values);
+}
+/**
+ * Reset the arena after a solve, when the scope ends.
+ * The arrays taken in the scope must not outlive it.
+ */
+class ArenaScope{
+public:
+    ArenaScope(): mark_( MemoryArena::getArena().getMark()) {}
+    ArenaScope( const ArenaScope&) = delete;
+    ~ArenaScope(){
+        MemoryArena::getArena().reset( mark_);
+    }
+private:
+    size_t mark_;
+};
+#endif
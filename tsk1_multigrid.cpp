@@ -0,0 +1,742 @@
+/**
+ * The multigrid preconditioners and the sparse matrices of their levels
+ */
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <omp.h>
+#include "tsk1_multigrid.h"
+// The coarsest level is solved by the dense factorization
+static const size_t MULTIGRID_COARSEST_NODES = 400;
+// The weight of the Jacobi smoother
+static const double MULTIGRID_SMOOTHER_WEIGHT = 1.0;
+// The sweeps of the coarsest level, that is too large for the factor
+static const int MULTIGRID_COARSEST_SWEEPS = 4;
+// The strength of a connection to the diagonal, theta
+static const double AGGREGATION_STRENGTH = 0.08;
+// The coarsening stalls, if the aggregates are more than this part of the nodes
+static const double AGGREGATION_MAX_RATIO = 0.8;
+SparseMatrix::SparseMatrix( size_t rows_count, size_t columns_count, int* IA,
+                            int* JA, double* A): IA( IA), JA( JA), A( A),
+    rows_count_( rows_count), columns_count_( columns_count),
+    is_owner_( true) {}
+SparseMatrix::SparseMatrix( NetGraph& graph): IA( graph.getIA()),
+    JA( graph.getJA()), A( graph.getA()),
+    rows_count_( graph.getNodesCount()),
+    columns_count_( graph.getNodesCount()), is_owner_( false) {}
+SparseMatrix::~SparseMatrix(){
+    if( is_owner_ ){
+        freeArray( IA);
+        freeArray( JA);
+        freeArray( A);
+    }
+}
+void SparseMatrix::copyDiagonal( double* diagonal){
+    #pragma omp parallel for schedule( static)
+    for( size_t row_idx = 0; row_idx < rows_count_; ++row_idx ){
+        diagonal[row_idx] = 0;
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            if( JA[cell_idx] == static_cast<int>( row_idx) ){
+                diagonal[row_idx] += A[cell_idx];
+            }
+        }
+    }
+}
+void SparseMatrix::multiplyInRegion( const double* vec, double* result){
+    #pragma omp for schedule( static)
+    for( size_t row_idx = 0; row_idx < rows_count_; ++row_idx ){
+        double row_sum = 0;
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            row_sum += A[cell_idx] * vec[JA[cell_idx]];
+        }
+        result[row_idx] = row_sum;
+    }
+}
+// result = result + A * vec
+void SparseMatrix::multiplyAddInRegion( const double* vec, double* result){
+    #pragma omp for schedule( static)
+    for( size_t row_idx = 0; row_idx < rows_count_; ++row_idx ){
+        double row_sum = 0;
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            row_sum += A[cell_idx] * vec[JA[cell_idx]];
+        }
+        result[row_idx] += row_sum;
+    }
+}
+// residual = right_part - A * vec
+void SparseMatrix::calculateResidualInRegion( const double* vec,
+                                              const double* right_part,
+                                              double* residual){
+    #pragma omp for schedule( static)
+    for( size_t row_idx = 0; row_idx < rows_count_; ++row_idx ){
+        double row_sum = right_part[row_idx];
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            row_sum -= A[cell_idx] * vec[JA[cell_idx]];
+        }
+        residual[row_idx] = row_sum;
+    }
+}
+/**
+ * Transpose the matrix: count the cells of the columns, then write
+ * the rows of the transposed matrix in the order of the rows of the matrix
+ */
+SparseMatrix* transposeSparse( SparseMatrix& matrix){
+    size_t rows_count = matrix.getColumnsCount();
+    size_t cells_count = matrix.getCellsCount();
+    int* matrix_IA = matrix.getIA();
+    int* matrix_JA = matrix.getJA();
+    double* matrix_A = matrix.getA();
+    int* IA = allocateArray<int>( rows_count + 1);
+    int* JA = allocateArray<int>( cells_count);
+    double* A = allocateArray<double>( cells_count);
+    std::fill( IA, IA + rows_count + 1, 0);
+    for( size_t cell_idx = 0; cell_idx < cells_count; ++cell_idx ){
+        ++IA[matrix_JA[cell_idx] + 1];
+    }
+    for( size_t row_idx = 0; row_idx < rows_count; ++row_idx ){
+        IA[row_idx + 1] += IA[row_idx];
+    }
+    std::vector<int> row_end( IA, IA + rows_count);
+    for( size_t column_idx = 0; column_idx < matrix.getRowsCount();
+         ++column_idx ){
+        for( int cell_idx = matrix_IA[column_idx];
+             cell_idx < matrix_IA[column_idx + 1]; ++cell_idx ){
+            int row_idx = matrix_JA[cell_idx];
+            JA[row_end[row_idx]] = column_idx;
+            A[row_end[row_idx]++] = matrix_A[cell_idx];
+        }
+    }
+    return new SparseMatrix( rows_count, matrix.getRowsCount(), IA, JA, A);
+}
+/**
+ * Multiply the sparse matrices. A row of the product is the sum
+ * of the rows of the right matrix, the cells of the row are gathered
+ * by the marks of the columns: the first pass counts the cells
+ * of the rows, the second one writes them. A thread keeps its own marks.
+ */
+SparseMatrix* multiplySparse( SparseMatrix& left, SparseMatrix& right){
+    assert( left.getColumnsCount() == right.getRowsCount());
+    size_t rows_count = left.getRowsCount();
+    size_t columns_count = right.getColumnsCount();
+    int* left_IA = left.getIA();
+    int* left_JA = left.getJA();
+    double* left_A = left.getA();
+    int* right_IA = right.getIA();
+    int* right_JA = right.getJA();
+    double* right_A = right.getA();
+    int* IA = allocateArray<int>( rows_count + 1);
+    IA[0] = 0;
+    #pragma omp parallel
+    {
+        std::vector<int> column_marks( columns_count, -1);
+        #pragma omp for schedule( static)
+        for( size_t row_idx = 0; row_idx < rows_count; ++row_idx ){
+            int row_cells = 0;
+            for( int left_idx = left_IA[row_idx];
+                 left_idx < left_IA[row_idx + 1]; ++left_idx ){
+                int middle_idx = left_JA[left_idx];
+                for( int right_idx = right_IA[middle_idx];
+                     right_idx < right_IA[middle_idx + 1]; ++right_idx ){
+                    if( column_marks[right_JA[right_idx]] !=
+                        static_cast<int>( row_idx) ){
+                        column_marks[right_JA[right_idx]] = row_idx;
+                        ++row_cells;
+                    }
+                }
+            }
+            IA[row_idx + 1] = row_cells;
+        }
+    }
+    for( size_t row_idx = 0; row_idx < rows_count; ++row_idx ){
+        IA[row_idx + 1] += IA[row_idx];
+    }
+    int* JA = allocateArray<int>( IA[rows_count]);
+    double* A = allocateArray<double>( IA[rows_count]);
+    #pragma omp parallel
+    {
+        // The mark of a column is its cell in the row
+        std::vector<int> column_cells( columns_count, -1);
+        #pragma omp for schedule( static)
+        for( size_t row_idx = 0; row_idx < rows_count; ++row_idx ){
+            int cell_idx = IA[row_idx];
+            for( int left_idx = left_IA[row_idx];
+                 left_idx < left_IA[row_idx + 1]; ++left_idx ){
+                int middle_idx = left_JA[left_idx];
+                for( int right_idx = right_IA[middle_idx];
+                     right_idx < right_IA[middle_idx + 1]; ++right_idx ){
+                    int column_idx = right_JA[right_idx];
+                    double product = left_A[left_idx] * right_A[right_idx];
+                    if( column_cells[column_idx] < IA[row_idx] ){
+                        column_cells[column_idx] = cell_idx;
+                        JA[cell_idx] = column_idx;
+                        A[cell_idx++] = product;
+                    } else{
+                        A[column_cells[column_idx]] += product;
+                    }
+                }
+            }
+        }
+    }
+    return new SparseMatrix( rows_count, columns_count, IA, JA, A);
+}
+MultigridLevel::MultigridLevel( SparseMatrix* matrix_p): matrix_p_( matrix_p),
+    prolongation_p_( NULL), restriction_p_( NULL){
+    size_t nodes_count = matrix_p->getRowsCount();
+    smoother_diagonal_ = allocateArray<double>( nodes_count);
+    right_part_ = allocateArray<double>( nodes_count);
+    solution_ = allocateArray<double>( nodes_count);
+    residual_ = allocateArray<double>( nodes_count);
+    matrix_p->copyDiagonal( smoother_diagonal_);
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        smoother_diagonal_[node_idx] = MULTIGRID_SMOOTHER_WEIGHT /
+            smoother_diagonal_[node_idx];
+    }
+}
+MultigridLevel::~MultigridLevel(){
+    delete matrix_p_;
+    delete prolongation_p_;
+    delete restriction_p_;
+    freeArray( smoother_diagonal_);
+    freeArray( right_part_);
+    freeArray( solution_);
+    freeArray( residual_);
+}
+MultigridPreconditioner::MultigridPreconditioner( NetGraph& graph):
+    graph_( graph), levels_count_( 0), coarsest_nodes_( 0),
+    operator_complexity_( 0) {}
+MultigridPreconditioner::~MultigridPreconditioner(){
+    release();
+}
+/**
+ * Free the levels, taken in the arena of the solve, the statistics are kept
+ */
+void MultigridPreconditioner::release(){
+    clearLevels();
+    coarsest_factor_.clear();
+}
+void MultigridPreconditioner::clearLevels(){
+    // The arrays are freed in the reverse order of the allocation
+    while( !levels_.empty() ){
+        delete levels_.back();
+        levels_.pop_back();
+    }
+}
+/**
+ * Build the levels: the coarse matrix is R * ( A * P)
+ */
+void MultigridPreconditioner::setup( MatrixOperator& matrix){
+    assert( matrix.getNodesCount() == graph_.getNodesCount());
+    clearLevels();
+    levels_.push_back( new MultigridLevel( new SparseMatrix( graph_)));
+    while( levels_.back()->matrix_p_->getRowsCount() >
+           MULTIGRID_COARSEST_NODES ){
+        MultigridLevel& level = *levels_.back();
+        SparseMatrix* prolongation_p = makeProlongation( levels_.size() - 1,
+            *level.matrix_p_);
+        if( !prolongation_p ){
+            break;
+        }
+        level.prolongation_p_ = prolongation_p;
+        level.restriction_p_ = transposeSparse( *prolongation_p);
+        SparseMatrix* product_p = multiplySparse( *level.matrix_p_,
+            *prolongation_p);
+        SparseMatrix* coarse_matrix_p = multiplySparse(
+            *level.restriction_p_, *product_p);
+        delete product_p;
+        levels_.push_back( new MultigridLevel( coarse_matrix_p));
+    }
+    double cells_count = 0;
+    for( size_t level_idx = 0; level_idx < levels_.size(); ++level_idx ){
+        cells_count += levels_[level_idx]->matrix_p_->getCellsCount();
+    }
+    operator_complexity_ = cells_count / graph_.getEdgesCount();
+    levels_count_ = levels_.size();
+    coarsest_nodes_ = levels_.back()->matrix_p_->getRowsCount();
+    factorizeCoarsest();
+}
+/**
+ * Take the dense Cholesky factor of the coarsest matrix, L * L^T.
+ * The factor isn't taken, if the coarsest level is too large for it.
+ */
+void MultigridPreconditioner::factorizeCoarsest(){
+    SparseMatrix& matrix = *levels_.back()->matrix_p_;
+    size_t nodes_count = matrix.getRowsCount();
+    coarsest_factor_.clear();
+    if( nodes_count > MULTIGRID_COARSEST_NODES ){
+        return;
+    }
+    int* IA = matrix.getIA();
+    int* JA = matrix.getJA();
+    double* A = matrix.getA();
+    coarsest_factor_.assign( nodes_count * nodes_count, 0);
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            coarsest_factor_[row_idx * nodes_count + JA[cell_idx]] +=
+                A[cell_idx];
+        }
+    }
+    for( size_t column_idx = 0; column_idx < nodes_count; ++column_idx ){
+        double* column_row = &coarsest_factor_[column_idx * nodes_count];
+        for( size_t inner_idx = 0; inner_idx < column_idx; ++inner_idx ){
+            column_row[column_idx] -= column_row[inner_idx] *
+                column_row[inner_idx];
+        }
+        column_row[column_idx] = sqrt( column_row[column_idx]);
+        for( size_t row_idx = column_idx + 1; row_idx < nodes_count;
+             ++row_idx ){
+            double* row = &coarsest_factor_[row_idx * nodes_count];
+            for( size_t inner_idx = 0; inner_idx < column_idx; ++inner_idx ){
+                row[column_idx] -= row[inner_idx] * column_row[inner_idx];
+            }
+            row[column_idx] /= column_row[column_idx];
+        }
+    }
+}
+void MultigridPreconditioner::solveCoarsest( const double* right_part,
+                                             double* solution){
+    size_t nodes_count = levels_.back()->matrix_p_->getRowsCount();
+    const double* factor = &coarsest_factor_[0];
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        double row_sum = right_part[row_idx];
+        for( size_t column_idx = 0; column_idx < row_idx; ++column_idx ){
+            row_sum -= factor[row_idx * nodes_count + column_idx] *
+                solution[column_idx];
+        }
+        solution[row_idx] = row_sum / factor[row_idx * nodes_count + row_idx];
+    }
+    for( size_t row_idx = nodes_count; row_idx > 0; --row_idx ){
+        double row_sum = solution[row_idx - 1];
+        for( size_t column_idx = row_idx; column_idx < nodes_count;
+             ++column_idx ){
+            row_sum -= factor[column_idx * nodes_count + row_idx - 1] *
+                solution[column_idx];
+        }
+        solution[row_idx - 1] = row_sum /
+            factor[( row_idx - 1) * nodes_count + row_idx - 1];
+    }
+}
+/**
+ * Smooth the solution of the level by a Jacobi sweep,
+ *      x = x + w * D^-1 * ( b - A * x)
+ * Must be called by every thread of the region.
+ */
+void MultigridPreconditioner::smoothInRegion( MultigridLevel& level,
+                                              const double* right_part,
+                                              double* solution){
+    size_t nodes_count = level.matrix_p_->getRowsCount();
+    level.matrix_p_->calculateResidualInRegion( solution, right_part,
+        level.residual_);
+    #pragma omp for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        solution[node_idx] += level.smoother_diagonal_[node_idx] *
+            level.residual_[node_idx];
+    }
+}
+/**
+ * The V-cycle from the level with the zero initial guess:
+ *      x = w * D^-1 * b
+ *      b_c = R * ( b - A * x)
+ *      x_c = the V-cycle of the coarse level
+ *      x = x + P * x_c
+ *      x = x + w * D^-1 * ( b - A * x)
+ * The coarsest level is solved by the factor, or, if the coarsening
+ * stalled and it is too large for the factor, it is smoothed
+ * MULTIGRID_COARSEST_SWEEPS times from zero.
+ * Must be called by every thread of the region.
+ */
+void MultigridPreconditioner::cycleInRegion( size_t level_idx,
+                                             const double* right_part,
+                                             double* solution){
+    MultigridLevel& level = *levels_[level_idx];
+    bool is_coarsest = level_idx + 1 == levels_.size();
+    if( is_coarsest && !coarsest_factor_.empty() ){
+        #pragma omp single
+        solveCoarsest( right_part, solution);
+        return;
+    }
+    size_t nodes_count = level.matrix_p_->getRowsCount();
+    #pragma omp for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        solution[node_idx] = level.smoother_diagonal_[node_idx] *
+            right_part[node_idx];
+    }
+    if( is_coarsest ){
+        for( int sweep_idx = 1; sweep_idx < MULTIGRID_COARSEST_SWEEPS;
+             ++sweep_idx ){
+            smoothInRegion( level, right_part, solution);
+        }
+        return;
+    }
+    level.matrix_p_->calculateResidualInRegion( solution, right_part,
+        level.residual_);
+    MultigridLevel& coarse_level = *levels_[level_idx + 1];
+    level.restriction_p_->multiplyInRegion( level.residual_,
+        coarse_level.right_part_);
+    cycleInRegion( level_idx + 1, coarse_level.right_part_,
+        coarse_level.solution_);
+    level.prolongation_p_->multiplyAddInRegion( coarse_level.solution_,
+        solution);
+    smoothInRegion( level, right_part, solution);
+}
+void MultigridPreconditioner::apply( MathVector& residual, MathVector& result){
+    assert( residual.getVecLen() == graph_.getNodesCount());
+    const double* residual_values = residual.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel
+    cycleInRegion( 0, residual_values, result_values);
+}
+double MultigridPreconditioner::applyDotInRegion( MathVector& residual,
+                                                  MathVector& result){
+    // The residual may be written by the other threads without a barrier
+    #pragma omp barrier
+    cycleInRegion( 0, residual.getValues(), result.getValues());
+    return evaluateDotInRegion( residual, result);
+}
+void MultigridPreconditioner::printStatistics(){
+    std::cout << "Multigrid levels: " << levels_count_ << std::endl;
+    std::cout << "Coarsest level nodes: " << coarsest_nodes_ << std::endl;
+    std::cout << "Operator complexity: " << getOperatorComplexity() <<
+    std::endl;
+}
+GeometricMultigridPreconditioner::GeometricMultigridPreconditioner(
+    NetGraph& graph, MatrixParameters* params_p):
+    MultigridPreconditioner( graph), grid_rows_( params_p->getRowLen() + 1),
+    grid_columns_( params_p->getColumnLen() + 1){
+    assert( grid_rows_ * grid_columns_ == graph.getNodesCount());
+}
+/**
+ * The coarse nodes of a fine node in one direction: the even node
+ * is a coarse node, the odd one is between two coarse nodes. The last
+ * odd node of an even line has only one coarse node, it takes it whole.
+ * Results:
+ *      A number of the coarse nodes
+ */
+static int getCoarseNodes( size_t fine_idx, size_t coarse_count,
+                           size_t coarse_nodes[2], double weights[2]){
+    coarse_nodes[0] = fine_idx / 2;
+    if( fine_idx % 2 == 0 || fine_idx / 2 + 1 >= coarse_count ){
+        weights[0] = 1;
+        return 1;
+    }
+    coarse_nodes[1] = fine_idx / 2 + 1;
+    weights[0] = weights[1] = 0.5;
+    return 2;
+}
+/**
+ * The grid of the level is the grid of the previous level halved
+ * in every direction, the interpolation is the product
+ * of the interpolations of the directions
+ */
+SparseMatrix* GeometricMultigridPreconditioner::makeProlongation(
+    size_t level_idx, SparseMatrix& matrix){
+    size_t fine_rows = grid_rows_;
+    size_t fine_columns = grid_columns_;
+    for( size_t coarsened_idx = 0; coarsened_idx < level_idx;
+         ++coarsened_idx ){
+        fine_rows = ( fine_rows + 1) / 2;
+        fine_columns = ( fine_columns + 1) / 2;
+    }
+    assert( fine_rows * fine_columns == matrix.getRowsCount());
+    size_t coarse_rows = ( fine_rows + 1) / 2;
+    size_t coarse_columns = ( fine_columns + 1) / 2;
+    if( coarse_rows * coarse_columns == fine_rows * fine_columns ){
+        return NULL;
+    }
+    size_t nodes_count = fine_rows * fine_columns;
+    int* IA = allocateArray<int>( nodes_count + 1);
+    IA[0] = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        size_t row_idx = node_idx / fine_columns;
+        size_t column_idx = node_idx % fine_columns;
+        int row_cells = ( row_idx % 2 == 0 || row_idx / 2 + 1 >= coarse_rows) ?
+            1 : 2;
+        int column_cells = ( column_idx % 2 == 0 ||
+            column_idx / 2 + 1 >= coarse_columns) ? 1 : 2;
+        IA[node_idx + 1] = IA[node_idx] + row_cells * column_cells;
+    }
+    int* JA = allocateArray<int>( IA[nodes_count]);
+    double* A = allocateArray<double>( IA[nodes_count]);
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        size_t coarse_row_nodes[2], coarse_column_nodes[2];
+        double row_weights[2], column_weights[2];
+        int row_cells = getCoarseNodes( node_idx / fine_columns, coarse_rows,
+            coarse_row_nodes, row_weights);
+        int column_cells = getCoarseNodes( node_idx % fine_columns,
+            coarse_columns, coarse_column_nodes, column_weights);
+        int cell_idx = IA[node_idx];
+        for( int row_cell = 0; row_cell < row_cells; ++row_cell ){
+            for( int column_cell = 0; column_cell < column_cells;
+                 ++column_cell ){
+                JA[cell_idx] = coarse_row_nodes[row_cell] * coarse_columns +
+                    coarse_column_nodes[column_cell];
+                A[cell_idx++] = row_weights[row_cell] *
+                    column_weights[column_cell];
+            }
+        }
+    }
+    return new SparseMatrix( nodes_count, coarse_rows * coarse_columns, IA,
+        JA, A);
+}
+/**
+ * Find the strong connections of the nodes, the diagonal isn't taken.
+ * The connections of a node are the nodes
+ * strong_nodes[[strong_ptr[node_idx]; strong_ptr[node_idx + 1])
+ */
+static void findStrongConnections( SparseMatrix& matrix,
+                                   const std::vector<double>& diagonal,
+                                   double strength,
+                                   std::vector<int>& strong_ptr,
+                                   std::vector<int>& strong_nodes){
+    size_t nodes_count = matrix.getRowsCount();
+    int* IA = matrix.getIA();
+    int* JA = matrix.getJA();
+    double* A = matrix.getA();
+    // The strong cells are marked, then they are taken in the order of rows
+    std::vector<char> is_strong( matrix.getCellsCount());
+    strong_ptr.assign( nodes_count + 1, 0);
+    #pragma omp parallel for schedule( static)
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        int strong_count = 0;
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            int column_idx = JA[cell_idx];
+            is_strong[cell_idx] = column_idx != static_cast<int>( row_idx) &&
+                fabs( A[cell_idx]) >= strength *
+                sqrt( fabs( diagonal[row_idx] * diagonal[column_idx]));
+            strong_count += is_strong[cell_idx];
+        }
+        strong_ptr[row_idx + 1] = strong_count;
+    }
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        strong_ptr[row_idx + 1] += strong_ptr[row_idx];
+    }
+    strong_nodes.resize( strong_ptr[nodes_count]);
+    #pragma omp parallel for schedule( static)
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        int strong_idx = strong_ptr[row_idx];
+        for( int cell_idx = IA[row_idx]; cell_idx < IA[row_idx + 1];
+             ++cell_idx ){
+            if( is_strong[cell_idx] ){
+                strong_nodes[strong_idx++] = JA[cell_idx];
+            }
+        }
+    }
+}
+typedef enum{
+    // The node is at the distance 2 or less from a root or isn't connected
+    AGGREGATION_COVERED = 0,
+    AGGREGATION_UNDECIDED,
+    AGGREGATION_ROOT
+} AggregationState_t;
+/**
+ * The key of a node for the choice of the roots: the state, then
+ * the hash of the index, then the index. The hash spreads the roots
+ * over the graph, the index makes the keys different.
+ */
+static uint64_t makeAggregationKey( AggregationState_t state, uint32_t node_idx){
+    uint32_t hash = node_idx;
+    hash = ( hash ^ 61) ^ ( hash >> 16);
+    hash *= 9;
+    hash ^= hash >> 4;
+    hash *= 0x27d4eb2d;
+    hash ^= hash >> 15;
+    return static_cast<uint64_t>( state) << 62 |
+        static_cast<uint64_t>( hash >> 2) << 32 | node_idx;
+}
+/**
+ * The maximum key of the node and its strong connections
+ */
+static uint64_t findMaxKey( const std::vector<uint64_t>& keys,
+                            const std::vector<int>& strong_ptr,
+                            const std::vector<int>& strong_nodes,
+                            size_t node_idx){
+    uint64_t max_key = keys[node_idx];
+    for( int strong_idx = strong_ptr[node_idx];
+         strong_idx < strong_ptr[node_idx + 1]; ++strong_idx ){
+        max_key = std::max( max_key, keys[strong_nodes[strong_idx]]);
+    }
+    return max_key;
+}
+/**
+ * Join the nodes into the aggregates. The roots are the maximal
+ * independent set of the distance 2 of the strong graph: an undecided
+ * node becomes a root, if its key is the maximum at the distance 2,
+ * and a node at the distance 2 from a root is covered. The rounds look
+ * only at the keys of the previous round, so the threads share the nodes.
+ * Then a node joins the aggregate of a root among its connections,
+ * and the rest of the nodes join the aggregate of a connection.
+ * A node without the strong connections isn't aggregated: the smoother
+ * removes its error alone.
+ * Results:
+ *      A number of the aggregates. aggregates has the aggregate of every node,
+ *      -1 for the nodes, that aren't aggregated
+ */
+static size_t aggregateNodes( const std::vector<int>& strong_ptr,
+                              const std::vector<int>& strong_nodes,
+                              std::vector<int>& aggregates){
+    size_t nodes_count = strong_ptr.size() - 1;
+    std::vector<AggregationState_t> states( nodes_count);
+    std::vector<uint64_t> keys( nodes_count);
+    std::vector<uint64_t> near_keys( nodes_count);
+    size_t undecided_count = 0;
+    #pragma omp parallel for schedule( static) reduction( +:undecided_count)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        bool is_connected = strong_ptr[node_idx + 1] > strong_ptr[node_idx];
+        states[node_idx] = is_connected ? AGGREGATION_UNDECIDED :
+            AGGREGATION_COVERED;
+        undecided_count += is_connected;
+    }
+    while( undecided_count > 0 ){
+        undecided_count = 0;
+        #pragma omp parallel
+        {
+            #pragma omp for schedule( static)
+            for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+                keys[node_idx] = makeAggregationKey( states[node_idx],
+                    node_idx);
+            }
+            #pragma omp for schedule( static)
+            for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+                near_keys[node_idx] = findMaxKey( keys, strong_ptr,
+                    strong_nodes, node_idx);
+            }
+            #pragma omp for schedule( static) reduction( +:undecided_count)
+            for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+                if( states[node_idx] != AGGREGATION_UNDECIDED ){
+                    continue;
+                }
+                uint64_t far_key = findMaxKey( near_keys, strong_ptr,
+                    strong_nodes, node_idx);
+                if( far_key == keys[node_idx] ){
+                    states[node_idx] = AGGREGATION_ROOT;
+                } else if( far_key >> 62 == AGGREGATION_ROOT ){
+                    states[node_idx] = AGGREGATION_COVERED;
+                } else{
+                    ++undecided_count;
+                }
+            }
+        }
+    }
+    aggregates.assign( nodes_count, -1);
+    size_t aggregates_count = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( states[node_idx] == AGGREGATION_ROOT ){
+            aggregates[node_idx] = aggregates_count++;
+        }
+    }
+    std::vector<int> root_aggregates( aggregates);
+    #pragma omp parallel
+    {
+        #pragma omp for schedule( static)
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            for( int strong_idx = strong_ptr[node_idx];
+                 strong_idx < strong_ptr[node_idx + 1] &&
+                 root_aggregates[node_idx] < 0; ++strong_idx ){
+                root_aggregates[node_idx] = aggregates[strong_nodes[strong_idx]];
+            }
+        }
+        #pragma omp for schedule( static)
+        for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+            aggregates[node_idx] = root_aggregates[node_idx];
+            for( int strong_idx = strong_ptr[node_idx];
+                 strong_idx < strong_ptr[node_idx + 1] &&
+                 aggregates[node_idx] < 0; ++strong_idx ){
+                aggregates[node_idx] =
+                    root_aggregates[strong_nodes[strong_idx]];
+            }
+            // A connected node is at the distance 2 from a root
+            assert( aggregates[node_idx] >= 0 ||
+                strong_ptr[node_idx + 1] == strong_ptr[node_idx]);
+        }
+    }
+    return aggregates_count;
+}
+/**
+ * The tentative prolongation T takes a coarse node to the nodes of its
+ * aggregate with the weight 1 / sqrt( size), the columns of T are
+ * orthonormal, the rows of the nodes out of the aggregates are empty.
+ * T is smoothed by the Jacobi sweep with the weight
+ * w = 4 / 3 / rho( D^-1 * A), the radius is bounded by the sums
+ * of the rows of D^-1 * |A|. A * T has the cell of the aggregate
+ * of the node in its row, so P is A * T scaled with T added to this cell.
+ * The strength of the connections is halved on every level: the coarse
+ * matrices are more diagonally dominant, than the graph.
+ */
+SparseMatrix* SmoothedAggregationPreconditioner::makeProlongation(
+    size_t level_idx, SparseMatrix& matrix){
+    size_t nodes_count = matrix.getRowsCount();
+    std::vector<double> diagonal( nodes_count);
+    matrix.copyDiagonal( &diagonal[0]);
+    std::vector<int> strong_ptr;
+    std::vector<int> strong_nodes;
+    double strength = AGGREGATION_STRENGTH * pow( 0.5, level_idx);
+    findStrongConnections( matrix, diagonal, strength, strong_ptr,
+        strong_nodes);
+    std::vector<int> aggregates;
+    size_t aggregates_count = aggregateNodes( strong_ptr, strong_nodes,
+        aggregates);
+    if( aggregates_count == 0 ||
+        aggregates_count > AGGREGATION_MAX_RATIO * nodes_count ){
+        return NULL;
+    }
+    std::vector<int> aggregate_sizes( aggregates_count, 0);
+    int* IA = allocateArray<int>( nodes_count + 1);
+    IA[0] = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        bool is_aggregated = aggregates[node_idx] >= 0;
+        if( is_aggregated ){
+            ++aggregate_sizes[aggregates[node_idx]];
+        }
+        IA[node_idx + 1] = IA[node_idx] + is_aggregated;
+    }
+    int* JA = allocateArray<int>( IA[nodes_count]);
+    double* A = allocateArray<double>( IA[nodes_count]);
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        if( aggregates[node_idx] >= 0 ){
+            JA[IA[node_idx]] = aggregates[node_idx];
+            A[IA[node_idx]] = 1 / sqrt( aggregate_sizes[aggregates[node_idx]]);
+        }
+    }
+    SparseMatrix tentative( nodes_count, aggregates_count, IA, JA, A);
+    SparseMatrix* prolongation_p = multiplySparse( matrix, tentative);
+    int* matrix_IA = matrix.getIA();
+    double* matrix_A = matrix.getA();
+    double radius = 0;
+    #pragma omp parallel for schedule( static) reduction( max:radius)
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        double row_sum = 0;
+        for( int cell_idx = matrix_IA[row_idx];
+             cell_idx < matrix_IA[row_idx + 1]; ++cell_idx ){
+            row_sum += fabs( matrix_A[cell_idx]);
+        }
+        radius = std::max( radius, row_sum / diagonal[row_idx]);
+    }
+    double weight = 4.0 / 3.0 / radius;
+    int* prolongation_IA = prolongation_p->getIA();
+    int* prolongation_JA = prolongation_p->getJA();
+    double* prolongation_A = prolongation_p->getA();
+    #pragma omp parallel for schedule( static)
+    for( size_t row_idx = 0; row_idx < nodes_count; ++row_idx ){
+        double row_weight = -weight / diagonal[row_idx];
+        for( int cell_idx = prolongation_IA[row_idx];
+             cell_idx < prolongation_IA[row_idx + 1]; ++cell_idx ){
+            prolongation_A[cell_idx] *= row_weight;
+            if( aggregates[row_idx] >= 0 &&
+                prolongation_JA[cell_idx] == aggregates[row_idx] ){
+                prolongation_A[cell_idx] += A[IA[row_idx]];
+            }
+        }
+    }
+    return prolongation_p;
+}
+
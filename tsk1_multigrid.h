@@ -0,0 +1,173 @@
+#ifndef MULTIGRID_H
+    #define MULTIGRID_H
+#include <vector>
+#include "tsk1_graph_prepare.h"
+#include "tsk1_preconditioner.h"
+/**
+ * A sparse matrix in CSR, that may be rectangular: the prolongation
+ * and the restriction between the levels of the multigrid and the matrices
+ * of the coarse levels. The columns of a row aren't sorted.
+ * The operations of the rows share them between the threads of the region,
+ * they must be called by every thread of the region.
+ */
+class SparseMatrix{
+public:
+    // The matrix takes the arrays, they must be taken by allocateArray()
+    SparseMatrix( size_t rows_count, size_t columns_count, int* IA, int* JA,
+                  double* A);
+    // The matrix of the graph takes its arrays, the graph frees them
+    SparseMatrix( NetGraph& graph);
+    SparseMatrix( const SparseMatrix&) = delete;
+    ~SparseMatrix();
+    size_t getRowsCount(){
+        return rows_count_;
+    }
+    size_t getColumnsCount(){
+        return columns_count_;
+    }
+    size_t getCellsCount(){
+        return IA[rows_count_];
+    }
+    int* getIA(){
+        return IA;
+    }
+    int* getJA(){
+        return JA;
+    }
+    double* getA(){
+        return A;
+    }
+    void copyDiagonal( double* diagonal);
+    void multiplyInRegion( const double* vec, double* result);
+    void multiplyAddInRegion( const double* vec, double* result);
+    void calculateResidualInRegion( const double* vec,
+                                    const double* right_part,
+                                    double* residual);
+private:
+    int* IA;
+    int* JA;
+    double* A;
+    size_t rows_count_;
+    size_t columns_count_;
+    // Are the arrays freed by the matrix
+    bool is_owner_;
+};
+SparseMatrix* transposeSparse( SparseMatrix& matrix);
+SparseMatrix* multiplySparse( SparseMatrix& left, SparseMatrix& right);
+/**
+ * A level of the multigrid: its matrix, the prolongation from the next
+ * coarser level and the restriction to it, and the vectors of the V-cycle
+ */
+class MultigridLevel{
+public:
+    MultigridLevel( SparseMatrix* matrix_p);
+    MultigridLevel( const MultigridLevel&) = delete;
+    ~MultigridLevel();
+    SparseMatrix* matrix_p_;
+    // NULL on the coarsest level
+    SparseMatrix* prolongation_p_;
+    SparseMatrix* restriction_p_;
+    // The weight of the Jacobi smoother divided by the diagonal
+    double* smoother_diagonal_;
+    // The right part and the solution of the coarse levels
+    double* right_part_;
+    double* solution_;
+    double* residual_;
+};
+/**
+ * The multigrid V-cycle, z = M^-1 * r. The levels are coarsened while
+ * the coarsest level has more than MULTIGRID_COARSEST_NODES nodes,
+ * the matrix of the coarse level is the Galerkin product R * A * P,
+ * R = P^T. A level is smoothed by a sweep of the weighted Jacobi before
+ * the coarse correction and after it, the coarsest level is solved by
+ * the dense Cholesky factorization. If the coarsening stops early,
+ * the coarsest level is smoothed by several sweeps instead. The smoothers
+ * are the same, and the coarse matrices are symmetric, so the V-cycle
+ * is symmetric and can precondition CG.
+ * The smoother, the restriction and the prolongation share the rows
+ * between the threads. A multigrid takes the prolongations
+ * from makeProlongation().
+ */
+class MultigridPreconditioner: public Preconditioner{
+public:
+    MultigridPreconditioner( NetGraph& graph);
+    MultigridPreconditioner( const MultigridPreconditioner&) = delete;
+    virtual ~MultigridPreconditioner();
+    void setup( MatrixOperator& matrix);
+    void apply( MathVector& residual, MathVector& result);
+    double applyDotInRegion( MathVector& residual, MathVector& result);
+    void release();
+    void printStatistics();
+    size_t getLevelsCount(){
+        return levels_count_;
+    }
+    /**
+     * The cells of the matrices of all levels to the cells of the graph,
+     * the memory and the work of the V-cycle to the ones of the graph
+     */
+    double getOperatorComplexity(){
+        return operator_complexity_;
+    }
+protected:
+    /**
+     * Make the prolongation from the next coarser level to the level
+     * Results:
+     *      The prolongation or NULL, if the level isn't coarsened
+     */
+    virtual SparseMatrix* makeProlongation( size_t level_idx,
+                                            SparseMatrix& matrix) = 0;
+private:
+    void clearLevels();
+    void factorizeCoarsest();
+    void solveCoarsest( const double* right_part, double* solution);
+    void smoothInRegion( MultigridLevel& level, const double* right_part,
+                         double* solution);
+    void cycleInRegion( size_t level_idx, const double* right_part,
+                        double* solution);
+    NetGraph& graph_;
+    std::vector<MultigridLevel*> levels_;
+    // The lower triangle of the Cholesky factor of the coarsest level,
+    // empty if the level is smoothed
+    std::vector<double> coarsest_factor_;
+    // Taken by the setup, the arrays of the levels may be released after it
+    size_t levels_count_;
+    size_t coarsest_nodes_;
+    double operator_complexity_;
+};
+/**
+ * The geometric multigrid: the grid of a level is coarsened by 2
+ * in every direction, the coarse node (i, j) is the fine node (2i, 2j).
+ * The prolongation is the bilinear interpolation: a fine node takes
+ * the coarse nodes around it with the weights 1, 1/2 or 1/4.
+ * The graph must be in the order of the grid.
+ */
+class GeometricMultigridPreconditioner: public MultigridPreconditioner{
+public:
+    GeometricMultigridPreconditioner( NetGraph& graph,
+                                      MatrixParameters* params_p);
+protected:
+    SparseMatrix* makeProlongation( size_t level_idx, SparseMatrix& matrix);
+private:
+    // The rows and the columns of the nodes of the finest grid
+    size_t grid_rows_;
+    size_t grid_columns_;
+};
+/**
+ * The smoothed aggregation multigrid takes the levels only from the matrix.
+ * The nodes are joined into the aggregates by the strong connections,
+ * |a_ij| >= theta * sqrt( a_ii * a_jj): the roots of the aggregates are
+ * a maximal set of the nodes at the distance 3 and more from each other,
+ * and a node joins the aggregate of the nearest root. The tentative
+ * prolongation takes the constant from a coarse node to its aggregate,
+ * and it is smoothed by a Jacobi sweep, P = ( I - w * D^-1 * A) * T,
+ * so P interpolates the smooth error across the aggregates. The levels
+ * don't depend on the number of the threads.
+ */
+class SmoothedAggregationPreconditioner: public MultigridPreconditioner{
+public:
+    SmoothedAggregationPreconditioner( NetGraph& graph):
+        MultigridPreconditioner( graph) {}
+protected:
+    SparseMatrix* makeProlongation( size_t level_idx, SparseMatrix& matrix);
+};
+#endif
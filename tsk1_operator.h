@@ -0,0 +1,55 @@
+#ifndef OPERATOR_H
+    #define OPERATOR_H
+#include <cstddef>
+template <typename Value_t> class MathVectorT;
+template <typename Index_t, typename Value_t> class NetGraphT;
+/**
+ * The solver works with the double vectors and the graph with the 32-bit
+ * indices: the nodes fit into int, only the cells of the large graphs don't.
+ */
+typedef MathVectorT<double> MathVector;
+typedef NetGraphT<int, double> NetGraph;
+/**
+ * The inner solver of the mixed precision solver takes the float vectors
+ * and the float copy of the graph
+ */
+typedef MathVectorT<float> MathVectorFloat;
+typedef NetGraphT<int, float> NetGraphFloat;
+/**
+ * A matrix of the system, as the solver sees it.
+ * The solver only multiplies the matrix to the vectors and the preconditioner
+ * takes its diagonal, so every storage format implements
+ * these operations and the solver doesn't depend on the format.
+ */
+class MatrixOperator{
+public:
+    virtual ~MatrixOperator() {}
+    virtual size_t getNodesCount() = 0;
+    /**
+     * Multiply the matrix to the vector, y = A*x
+     * The result must not be the multiplied vector
+     */
+    virtual void multiply( MathVector& vec, MathVector& result) = 0;
+    /**
+     * Multiply the matrix to the vector and calculate
+     * the dot product (x, y) in the same pass
+     */
+    virtual double multiplyDot( MathVector& vec, MathVector& result) = 0;
+    /**
+     * The same for a persistent parallel region.
+     * Must be called by every thread of the region.
+     * Results:
+     *      The partial sum of the thread
+     */
+    virtual double multiplyDotInRegion( MathVector& vec, MathVector& result) = 0;
+    /**
+     * Prepare the data, that the threads of a parallel region share,
+     * before the region starts
+     */
+    virtual void prepareThreads( size_t) {}
+    /**
+     * Copy the diagonal of the matrix to the vector of the nodes
+     */
+    virtual void copyDiagonal( MathVector& diagonal) = 0;
+};
+#endif
@@ -0,0 +1,525 @@
+/**
+ * The preconditioners of the CG solver
+ */
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <omp.h>
+#include "tsk1_preconditioner.h"
+#include "tsk1_reorder.h"
+/**
+ * Apply the preconditioner and calculate the dot product
+ * Results:
+ *      The dot product (r, z)
+ */
+double Preconditioner::applyDot( MathVector& residual, MathVector& result){
+    apply( residual, result);
+    return dot( residual, result);
+}
+/**
+ * Update the solver vectors and apply the preconditioner:
+ *      x = x + alpha * p
+ *      r = r - alpha * q
+ *      z = M^-1 * r
+ * Results:
+ *      The dot product (r, z)
+ */
+double Preconditioner::updateApplyDot( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result){
+    evaluate( assign( approximation, approximation + alpha_coeff * direction),
+        assign( residual, residual - alpha_coeff * matrix_direction));
+    return applyDot( residual, result);
+}
+/**
+ * The preconditioner, that doesn't share its work with the threads
+ * of the region, is applied by one thread
+ */
+double Preconditioner::applyDotInRegion( MathVector& residual,
+                                         MathVector& result){
+    double sum = 0;
+    #pragma omp barrier
+    #pragma omp single
+    sum = applyDot( residual, result);
+    return sum;
+}
+double Preconditioner::updateApplyDotInRegion( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result){
+    // The preconditioner waits for the residual of the other threads
+    evaluateInRegion( assign( approximation,
+        approximation + alpha_coeff * direction),
+        assign( residual, residual - alpha_coeff * matrix_direction));
+    return applyDotInRegion( residual, result);
+}
+/**
+ * Take the inverse of the matrix diagonal
+ */
+void JacobiPreconditioner::setup( MatrixOperator& matrix){
+    size_t nodes_count = matrix.getNodesCount();
+    if( reverse_diagonal_.getVecLen() != nodes_count ){
+        reverse_diagonal_ = MathVector( nodes_count);
+    }
+    matrix.copyDiagonal( reverse_diagonal_);
+    double* values = reverse_diagonal_.getValues();
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        values[node_idx] = 1.0 / values[node_idx];
+    }
+}
+void JacobiPreconditioner::release(){
+    // The moved diagonal is freed with the temporary, the next setup takes it
+    MathVector released_diagonal( std::move( reverse_diagonal_));
+}
+void JacobiPreconditioner::apply( MathVector& residual, MathVector& result){
+    result = reverse_diagonal_ * residual;
+}
+double JacobiPreconditioner::applyDot( MathVector& residual,
+                                       MathVector& result){
+    return evaluateDot( residual, result,
+        assign( result, reverse_diagonal_ * residual));
+}
+double JacobiPreconditioner::updateApplyDot( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result){
+    return evaluateDot( residual, result,
+        assign( approximation, approximation + alpha_coeff * direction),
+        assign( residual, residual - alpha_coeff * matrix_direction),
+        assign( result, reverse_diagonal_ * residual));
+}
+double JacobiPreconditioner::applyDotInRegion( MathVector& residual,
+                                               MathVector& result){
+    return evaluateDotInRegion( residual, result,
+        assign( result, reverse_diagonal_ * residual));
+}
+double JacobiPreconditioner::updateApplyDotInRegion( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result){
+    return evaluateDotInRegion( residual, result,
+        assign( approximation, approximation + alpha_coeff * direction),
+        assign( residual, residual - alpha_coeff * matrix_direction),
+        assign( result, reverse_diagonal_ * residual));
+}
+IncompleteCholeskyPreconditioner::IncompleteCholeskyPreconditioner(
+    NetGraph& graph): graph_( graph), nodes_count_( 0), lower_IA_( NULL),
+    lower_JA_( NULL), lower_A_( NULL), upper_IA_( NULL), upper_JA_( NULL),
+    upper_A_( NULL), transpose_idx_( NULL), reverse_diagonal_( NULL),
+    level_values_( NULL) {}
+IncompleteCholeskyPreconditioner::~IncompleteCholeskyPreconditioner(){
+    release();
+}
+/**
+ * Free the factor and the pattern, the next setup takes the pattern again
+ */
+void IncompleteCholeskyPreconditioner::release(){
+    freeArray( lower_IA_);
+    freeArray( lower_JA_);
+    freeArray( lower_A_);
+    freeArray( upper_IA_);
+    freeArray( upper_JA_);
+    freeArray( upper_A_);
+    freeArray( transpose_idx_);
+    freeArray( reverse_diagonal_);
+    freeArray( level_values_);
+    lower_IA_ = lower_JA_ = upper_IA_ = upper_JA_ = transpose_idx_ = NULL;
+    lower_A_ = upper_A_ = reverse_diagonal_ = level_values_ = NULL;
+    level_ptr_.clear();
+    level_rows_.clear();
+    row_positions_.clear();
+    nodes_count_ = 0;
+}
+/**
+ * Split the rows into the levels and take the pattern of L and L^T
+ * from the graph. The graph must be symmetric, as the filled graph is.
+ */
+void IncompleteCholeskyPreconditioner::preparePattern(){
+    nodes_count_ = graph_.getNodesCount();
+    int* IA = graph_.getIA();
+    int* JA = graph_.getJA();
+    // A row is on the level after the levels of its columns
+    std::vector<int> node_levels( nodes_count_, 0);
+    int levels_count = 0;
+    size_t lower_count = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            if( JA[edge_idx] < static_cast<int>( node_idx) ){
+                node_levels[node_idx] = std::max( node_levels[node_idx],
+                    node_levels[JA[edge_idx]] + 1);
+                ++lower_count;
+            }
+        }
+        levels_count = std::max( levels_count, node_levels[node_idx] + 1);
+    }
+    // Sort the rows by the levels, a level keeps the order of its rows
+    level_ptr_.assign( levels_count + 1, 0);
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        ++level_ptr_[node_levels[node_idx] + 1];
+    }
+    for( int level_idx = 0; level_idx < levels_count; ++level_idx ){
+        level_ptr_[level_idx + 1] += level_ptr_[level_idx];
+    }
+    std::vector<int> level_end( level_ptr_.begin(), level_ptr_.end() - 1);
+    level_rows_.resize( nodes_count_);
+    row_positions_.resize( nodes_count_);
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        row_positions_[node_idx] = level_end[node_levels[node_idx]]++;
+        level_rows_[row_positions_[node_idx]] = node_idx;
+    }
+    /**
+     * The rows of L and L^T are stored in the order of the levels,
+     * and the columns are the places of the rows in this order,
+     * so a level reads its cells and the solution of the levels before it
+     * in a row
+     */
+    lower_IA_ = allocateArray<int>( nodes_count_ + 1);
+    upper_IA_ = allocateArray<int>( nodes_count_ + 1);
+    std::fill( upper_IA_, upper_IA_ + nodes_count_ + 1, 0);
+    size_t cell_idx = 0;
+    for( size_t row_idx = 0; row_idx < nodes_count_; ++row_idx ){
+        size_t node_idx = level_rows_[row_idx];
+        lower_IA_[row_idx] = cell_idx;
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            if( JA[edge_idx] < static_cast<int>( node_idx) ){
+                ++upper_IA_[row_positions_[JA[edge_idx]] + 1];
+                ++cell_idx;
+            }
+        }
+    }
+    lower_IA_[nodes_count_] = lower_count;
+    for( size_t row_idx = 0; row_idx < nodes_count_; ++row_idx ){
+        upper_IA_[row_idx + 1] += upper_IA_[row_idx];
+    }
+    lower_JA_ = allocateArray<int>( lower_count);
+    lower_A_ = allocateArray<double>( lower_count);
+    upper_JA_ = allocateArray<int>( lower_count);
+    upper_A_ = allocateArray<double>( lower_count);
+    transpose_idx_ = allocateArray<int>( lower_count);
+    reverse_diagonal_ = allocateArray<double>( nodes_count_);
+    level_values_ = allocateArray<double>( nodes_count_);
+    std::vector<int> upper_end( upper_IA_, upper_IA_ + nodes_count_);
+    cell_idx = 0;
+    for( size_t row_idx = 0; row_idx < nodes_count_; ++row_idx ){
+        size_t node_idx = level_rows_[row_idx];
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            int column_idx = JA[edge_idx];
+            if( column_idx < static_cast<int>( node_idx) ){
+                int column_row = row_positions_[column_idx];
+                lower_JA_[cell_idx] = column_row;
+                transpose_idx_[cell_idx] = upper_end[column_row];
+                upper_JA_[upper_end[column_row]++] = row_idx;
+                ++cell_idx;
+            }
+        }
+    }
+}
+/**
+ * Calculate the row of L from the row of the graph and the rows of L
+ * of its columns:
+ *      l_ik = ( a_ik - sum( l_ij * l_kj, j < k)) / l_kk
+ *      l_ii = sqrt( a_ii - sum( l_ij^2, j < i))
+ * The sums take only the cells of the pattern.
+ */
+void IncompleteCholeskyPreconditioner::factorizeRow( size_t row_idx){
+    int* IA = graph_.getIA();
+    int* JA = graph_.getJA();
+    double* A = graph_.getA();
+    size_t node_idx = level_rows_[row_idx];
+    size_t row_start = lower_IA_[row_idx];
+    size_t cell_idx = row_start;
+    double diagonal = 0;
+    double diagonal_sum = 0;
+    size_t end_idx = IA[node_idx + 1];
+    for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+        size_t column_idx = JA[edge_idx];
+        if( column_idx == node_idx ){
+            diagonal = A[edge_idx];
+            continue;
+        }
+        if( column_idx > node_idx ){
+            continue;
+        }
+        /**
+         * The columns are the places in the order of the levels,
+         * they aren't sorted. The rows of the grid have a few cells,
+         * so the common columns are found by the nested loops.
+         */
+        int column_row = row_positions_[column_idx];
+        double cell_sum = A[edge_idx];
+        for( size_t row_cell = row_start; row_cell < cell_idx; ++row_cell ){
+            for( int column_cell = lower_IA_[column_row];
+                 column_cell < lower_IA_[column_row + 1]; ++column_cell ){
+                if( lower_JA_[row_cell] == lower_JA_[column_cell] ){
+                    cell_sum -= lower_A_[row_cell] * lower_A_[column_cell];
+                }
+            }
+        }
+        lower_A_[cell_idx] = cell_sum * reverse_diagonal_[column_row];
+        diagonal_sum += lower_A_[cell_idx] * lower_A_[cell_idx];
+        ++cell_idx;
+    }
+    /**
+     * The diagonally dominant matrix keeps the pivot positive.
+     * Otherwise the row takes the diagonal of the matrix, as Jacobi does.
+     */
+    double pivot = diagonal - diagonal_sum;
+    reverse_diagonal_[row_idx] = 1.0 / sqrt( pivot > 0 ? pivot : diagonal);
+}
+/**
+ * Factorize the graph. The pattern and the levels are taken once,
+ * the next setups only calculate the cells of L, until the release.
+ */
+void IncompleteCholeskyPreconditioner::setup( MatrixOperator& matrix){
+    assert( matrix.getNodesCount() == graph_.getNodesCount());
+    if( !lower_IA_ ){
+        preparePattern();
+    }
+    size_t levels_count = getLevelsCount();
+    #pragma omp parallel
+    {
+        for( size_t level_idx = 0; level_idx < levels_count; ++level_idx ){
+            #pragma omp for schedule( static)
+            for( int row_idx = level_ptr_[level_idx];
+                 row_idx < level_ptr_[level_idx + 1]; ++row_idx ){
+                factorizeRow( row_idx);
+            }
+        }
+        size_t lower_count = lower_IA_[nodes_count_];
+        #pragma omp for schedule( static)
+        for( size_t cell_idx = 0; cell_idx < lower_count; ++cell_idx ){
+            upper_A_[transpose_idx_[cell_idx]] = lower_A_[cell_idx];
+        }
+    }
+}
+/**
+ * Solve L * y = r by the levels, then L^T * z = y by the levels
+ * in the reverse order. y and z are kept in the order of the levels,
+ * the row of L^T takes only the solution after the row, so y is replaced
+ * by z in place. The residual is read and the result is written
+ * in the order of the graph.
+ * Must be called by every thread of the region.
+ */
+void IncompleteCholeskyPreconditioner::solveInRegion( const double* residual,
+                                                      double* result){
+    size_t levels_count = getLevelsCount();
+    for( size_t level_idx = 0; level_idx < levels_count; ++level_idx ){
+        #pragma omp for schedule( static)
+        for( int row_idx = level_ptr_[level_idx];
+             row_idx < level_ptr_[level_idx + 1]; ++row_idx ){
+            double row_sum = residual[level_rows_[row_idx]];
+            for( int cell_idx = lower_IA_[row_idx];
+                 cell_idx < lower_IA_[row_idx + 1]; ++cell_idx ){
+                row_sum -= lower_A_[cell_idx] *
+                    level_values_[lower_JA_[cell_idx]];
+            }
+            level_values_[row_idx] = row_sum * reverse_diagonal_[row_idx];
+        }
+    }
+    for( size_t level_idx = levels_count; level_idx > 0; --level_idx ){
+        #pragma omp for schedule( static)
+        for( int row_idx = level_ptr_[level_idx - 1];
+             row_idx < level_ptr_[level_idx]; ++row_idx ){
+            double row_sum = level_values_[row_idx];
+            for( int cell_idx = upper_IA_[row_idx];
+                 cell_idx < upper_IA_[row_idx + 1]; ++cell_idx ){
+                row_sum -= upper_A_[cell_idx] *
+                    level_values_[upper_JA_[cell_idx]];
+            }
+            level_values_[row_idx] = row_sum * reverse_diagonal_[row_idx];
+            result[level_rows_[row_idx]] = level_values_[row_idx];
+        }
+    }
+}
+void IncompleteCholeskyPreconditioner::apply( MathVector& residual,
+                                              MathVector& result){
+    assert( residual.getVecLen() == nodes_count_);
+    const double* residual_values = residual.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel
+    solveInRegion( residual_values, result_values);
+}
+double IncompleteCholeskyPreconditioner::applyDotInRegion(
+    MathVector& residual, MathVector& result){
+    // The residual may be written by the other threads without a barrier
+    #pragma omp barrier
+    solveInRegion( residual.getValues(), result.getValues());
+    return evaluateDotInRegion( residual, result);
+}
+MulticolorSSORPreconditioner::MulticolorSSORPreconditioner( NetGraph& graph,
+    double relaxation): graph_( graph), relaxation_( relaxation),
+    nodes_count_( 0), IA_( NULL), JA_( NULL), A_( NULL), lower_end_( NULL),
+    relaxed_diagonal_( NULL), color_values_( NULL) {}
+MulticolorSSORPreconditioner::~MulticolorSSORPreconditioner(){
+    release();
+}
+/**
+ * Free the rows and the colors, the next setup colors the graph again
+ */
+void MulticolorSSORPreconditioner::release(){
+    freeArray( IA_);
+    freeArray( JA_);
+    freeArray( A_);
+    freeArray( lower_end_);
+    freeArray( relaxed_diagonal_);
+    freeArray( color_values_);
+    IA_ = JA_ = lower_end_ = NULL;
+    A_ = relaxed_diagonal_ = color_values_ = NULL;
+    color_ptr_.clear();
+    color_rows_.clear();
+    row_positions_.clear();
+    nodes_count_ = 0;
+}
+int MulticolorSSORPreconditioner::getNodeColor( size_t node_idx){
+    return std::upper_bound( color_ptr_.begin(), color_ptr_.end(),
+        row_positions_[node_idx]) - color_ptr_.begin() - 1;
+}
+/**
+ * Color the graph and sort the rows by the colors, a color keeps
+ * the order of its rows
+ */
+void MulticolorSSORPreconditioner::preparePattern(){
+    nodes_count_ = graph_.getNodesCount();
+    std::vector<int> colors;
+    size_t colors_count = colorGraph( graph_, colors);
+    color_ptr_.assign( colors_count + 1, 0);
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        ++color_ptr_[colors[node_idx] + 1];
+    }
+    for( size_t color_idx = 0; color_idx < colors_count; ++color_idx ){
+        color_ptr_[color_idx + 1] += color_ptr_[color_idx];
+    }
+    std::vector<int> color_end( color_ptr_.begin(), color_ptr_.end() - 1);
+    color_rows_.resize( nodes_count_);
+    row_positions_.resize( nodes_count_);
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        row_positions_[node_idx] = color_end[colors[node_idx]]++;
+        color_rows_[row_positions_[node_idx]] = node_idx;
+    }
+    // The diagonal isn't stored
+    IA_ = allocateArray<int>( nodes_count_ + 1);
+    size_t cells_count = 0;
+    for( size_t row_idx = 0; row_idx < nodes_count_; ++row_idx ){
+        size_t node_idx = color_rows_[row_idx];
+        IA_[row_idx] = cells_count;
+        cells_count += graph_.getIA()[node_idx + 1] -
+            graph_.getIA()[node_idx] - 1;
+    }
+    IA_[nodes_count_] = cells_count;
+    JA_ = allocateArray<int>( cells_count);
+    A_ = allocateArray<double>( cells_count);
+    lower_end_ = allocateArray<int>( nodes_count_);
+    relaxed_diagonal_ = allocateArray<double>( nodes_count_);
+    color_values_ = allocateArray<double>( nodes_count_);
+}
+/**
+ * Take the rows of the graph in the order of the colors. The columns
+ * of a row are sorted by their places, so L is before U.
+ * The pattern and the colors are taken once, until the release.
+ */
+void MulticolorSSORPreconditioner::setup( MatrixOperator& matrix){
+    assert( matrix.getNodesCount() == graph_.getNodesCount());
+    if( !IA_ ){
+        preparePattern();
+    }
+    int* graph_IA = graph_.getIA();
+    int* graph_JA = graph_.getJA();
+    double* graph_A = graph_.getA();
+    #pragma omp parallel for schedule( static)
+    for( size_t row_idx = 0; row_idx < nodes_count_; ++row_idx ){
+        size_t node_idx = color_rows_[row_idx];
+        size_t cell_idx = IA_[row_idx];
+        size_t end_idx = graph_IA[node_idx + 1];
+        for( size_t edge_idx = graph_IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx ){
+            if( graph_JA[edge_idx] == static_cast<int>( node_idx) ){
+                relaxed_diagonal_[row_idx] = relaxation_ / graph_A[edge_idx];
+                continue;
+            }
+            // Insert the cell after the cells with the smaller columns
+            int column_idx = row_positions_[graph_JA[edge_idx]];
+            size_t insert_idx = cell_idx;
+            while( insert_idx > static_cast<size_t>( IA_[row_idx]) &&
+                   JA_[insert_idx - 1] > column_idx ){
+                JA_[insert_idx] = JA_[insert_idx - 1];
+                A_[insert_idx] = A_[insert_idx - 1];
+                --insert_idx;
+            }
+            JA_[insert_idx] = column_idx;
+            A_[insert_idx] = graph_A[edge_idx];
+            ++cell_idx;
+        }
+        lower_end_[row_idx] = std::lower_bound( JA_ + IA_[row_idx],
+            JA_ + IA_[row_idx + 1], static_cast<int>( row_idx)) - JA_;
+    }
+}
+/**
+ * Sweep the colors forward from zero, then backward:
+ *      y_i = w / a_ii * ( r_i - sum( a_ij * y_j, j < i))
+ *      z_i = ( 2 - w) * y_i - w / a_ii * sum( a_ij * z_j, j > i)
+ * The backward sweep takes r_i - sum( a_ij * y_j, j < i) from y_i,
+ * so it reads only U. r, y and z take the same vector in the order
+ * of the colors: the residual is taken to it and the result is taken
+ * from it in the order of the graph, so the vectors of the graph
+ * are read once, not once for every color.
+ * Must be called by every thread of the region.
+ */
+void MulticolorSSORPreconditioner::sweepInRegion( const double* residual,
+                                                  double* result){
+    #pragma omp for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        color_values_[row_positions_[node_idx]] = residual[node_idx];
+    }
+    size_t colors_count = getColorsCount();
+    for( size_t color_idx = 0; color_idx < colors_count; ++color_idx ){
+        #pragma omp for schedule( static)
+        for( int row_idx = color_ptr_[color_idx];
+             row_idx < color_ptr_[color_idx + 1]; ++row_idx ){
+            double row_sum = color_values_[row_idx];
+            for( int cell_idx = IA_[row_idx]; cell_idx < lower_end_[row_idx];
+                 ++cell_idx ){
+                row_sum -= A_[cell_idx] * color_values_[JA_[cell_idx]];
+            }
+            color_values_[row_idx] = row_sum * relaxed_diagonal_[row_idx];
+        }
+    }
+    double diagonal_coeff = 2 - relaxation_;
+    for( size_t color_idx = colors_count; color_idx > 0; --color_idx ){
+        #pragma omp for schedule( static)
+        for( int row_idx = color_ptr_[color_idx - 1];
+             row_idx < color_ptr_[color_idx]; ++row_idx ){
+            double row_sum = 0;
+            for( int cell_idx = lower_end_[row_idx];
+                 cell_idx < IA_[row_idx + 1]; ++cell_idx ){
+                row_sum += A_[cell_idx] * color_values_[JA_[cell_idx]];
+            }
+            color_values_[row_idx] = diagonal_coeff * color_values_[row_idx] -
+                row_sum * relaxed_diagonal_[row_idx];
+        }
+    }
+    #pragma omp for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        result[node_idx] = color_values_[row_positions_[node_idx]];
+    }
+}
+void MulticolorSSORPreconditioner::apply( MathVector& residual,
+                                          MathVector& result){
+    assert( residual.getVecLen() == nodes_count_);
+    const double* residual_values = residual.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel
+    sweepInRegion( residual_values, result_values);
+}
+double MulticolorSSORPreconditioner::applyDotInRegion( MathVector& residual,
+                                                       MathVector& result){
+    // The residual may be written by the other threads without a barrier
+    #pragma omp barrier
+    sweepInRegion( residual.getValues(), result.getValues());
+    return evaluateDotInRegion( residual, result);
+}
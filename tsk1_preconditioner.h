@@ -0,0 +1,199 @@
+#ifndef PRECONDITIONER_H
+    #define PRECONDITIONER_H
+#include <vector>
+#include "tsk1_operator.h"
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A preconditioner of the CG solver, z = M^-1 * r.
+ * The preconditioner is set up for a matrix before the solve
+ * and is applied on every iteration. The solver only applies it,
+ * so a stronger preconditioner doesn't change the solver loop.
+ * A preconditioner implements the apply, the other operations
+ * have the default implementations through it. A simple preconditioner
+ * may fuse them into one pass over the vectors.
+ */
+class Preconditioner{
+public:
+    virtual ~Preconditioner() {}
+    /**
+     * Build the preconditioner of the matrix
+     */
+    virtual void setup( MatrixOperator& matrix) = 0;
+    /**
+     * Apply the preconditioner, z = M^-1 * r
+     * The result must not be the residual
+     */
+    virtual void apply( MathVector& residual, MathVector& result) = 0;
+    virtual double applyDot( MathVector& residual, MathVector& result);
+    virtual double updateApplyDot( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result);
+    /**
+     * The same for a persistent parallel region.
+     * Must be called by every thread of the region.
+     * Results:
+     *      The partial sum of the thread
+     */
+    virtual double applyDotInRegion( MathVector& residual, MathVector& result);
+    virtual double updateApplyDotInRegion( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result);
+    // Print the structure of the preconditioner after the solve
+    virtual void printStatistics() {}
+    /**
+     * Free the arrays of the setup, the next setup takes them again.
+     * The setup of a solve takes the arrays in the ArenaScope of the solve,
+     * so the solve releases them before the scope ends.
+     */
+    virtual void release() {}
+};
+/**
+ * The Jacobi preconditioner, M = D.
+ * The inverse of the diagonal is a vector, so the apply is
+ * an elementwise product, and it is fused with the update
+ * of the solution and the residual in one streaming loop.
+ */
+class JacobiPreconditioner: public Preconditioner{
+public:
+    JacobiPreconditioner(): reverse_diagonal_( 0) {}
+    void setup( MatrixOperator& matrix);
+    void apply( MathVector& residual, MathVector& result);
+    double applyDot( MathVector& residual, MathVector& result);
+    double updateApplyDot( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result);
+    double applyDotInRegion( MathVector& residual, MathVector& result);
+    double updateApplyDotInRegion( MathVector& approximation,
+                   MathVector& residual, MathVector& direction,
+                   MathVector& matrix_direction, double alpha_coeff,
+                   MathVector& result);
+    void release();
+    // The inverse of the diagonal, D^-1
+    MathVector& getReverseDiagonal(){
+        return reverse_diagonal_;
+    }
+private:
+    MathVector reverse_diagonal_;
+};
+/**
+ * The incomplete Cholesky preconditioner IC(0), M = L * L^T.
+ * L has the pattern of the lower triangle of the graph: the cells
+ * outside the pattern are dropped from the factorization, so the factor
+ * takes about as much memory, as the graph. The factor is taken from
+ * the graph of the constructor, the matrix of the solve must be the same
+ * system in any format.
+ * The row i of L depends on the rows of its columns j < i, so the rows
+ * are split into the levels: a row is on the level after the levels
+ * of its columns. The rows of a level are independent, they are shared
+ * between the threads, and the threads wait for each other between
+ * the levels. On the grid the levels are the anti-diagonals of the grid,
+ * the wavefronts of the triangular solve. The backward solve with L^T
+ * takes the same levels in the reverse order. The rows of the factor
+ * and the solution of the solves are stored by the levels, so a level
+ * reads its cells and the solution of the levels before it in a row.
+ */
+class IncompleteCholeskyPreconditioner: public Preconditioner{
+public:
+    IncompleteCholeskyPreconditioner( NetGraph& graph);
+    IncompleteCholeskyPreconditioner(
+        const IncompleteCholeskyPreconditioner&) = delete;
+    ~IncompleteCholeskyPreconditioner();
+    void setup( MatrixOperator& matrix);
+    void apply( MathVector& residual, MathVector& result);
+    double applyDotInRegion( MathVector& residual, MathVector& result);
+    void release();
+    // A number of the levels of the triangular solves
+    size_t getLevelsCount(){
+        return level_ptr_.empty() ? 0 : level_ptr_.size() - 1;
+    }
+private:
+    void preparePattern();
+    void factorizeRow( size_t row_idx);
+    void solveInRegion( const double* residual, double* result);
+    NetGraph& graph_;
+    size_t nodes_count_;
+    /**
+     * The level level_idx has the rows level_rows_[row_idx] of
+     * [level_ptr_[level_idx]; level_ptr_[level_idx + 1]).
+     * The factor stores the rows in this order, row_positions_
+     * is the place of a row of the graph in it.
+     */
+    std::vector<int> level_ptr_;
+    std::vector<int> level_rows_;
+    std::vector<int> row_positions_;
+    // The cells of L under the diagonal in CSR
+    int* lower_IA_;
+    int* lower_JA_;
+    double* lower_A_;
+    // The same cells of L^T by the rows of L^T
+    int* upper_IA_;
+    int* upper_JA_;
+    double* upper_A_;
+    // The cell of L^T of a cell of L
+    int* transpose_idx_;
+    // The inverse of the diagonal of L
+    double* reverse_diagonal_;
+    // The solution of the triangular solves in the order of the levels
+    double* level_values_;
+};
+/**
+ * The symmetric successive over-relaxation SSOR,
+ *      M = ( D / w + L) * ( D / w)^-1 * ( D / w + U) / ( 2 - w).
+ * The apply is a forward Gauss-Seidel sweep and a backward one from zero
+ * with the relaxation w, w = 1 is the symmetric Gauss-Seidel.
+ * The sweep in the order of the graph is sequential, so the nodes
+ * are colored: the nodes of a color have no common edges, they are swept
+ * together by the threads, and the colors are swept one after another.
+ * The rows take L and U by the order of the colors. The rows and
+ * the solution of the sweeps are stored by the colors, so a color reads
+ * them in a row.
+ */
+class MulticolorSSORPreconditioner: public Preconditioner{
+public:
+    MulticolorSSORPreconditioner( NetGraph& graph, double relaxation = 1.0);
+    MulticolorSSORPreconditioner(
+        const MulticolorSSORPreconditioner&) = delete;
+    ~MulticolorSSORPreconditioner();
+    void setup( MatrixOperator& matrix);
+    void apply( MathVector& residual, MathVector& result);
+    double applyDotInRegion( MathVector& residual, MathVector& result);
+    void release();
+    size_t getColorsCount(){
+        return color_ptr_.empty() ? 0 : color_ptr_.size() - 1;
+    }
+    // The color of a node of the graph
+    int getNodeColor( size_t node_idx);
+private:
+    void preparePattern();
+    void sweepInRegion( const double* residual, double* result);
+    NetGraph& graph_;
+    double relaxation_;
+    size_t nodes_count_;
+    /**
+     * The color color_idx has the rows color_rows_[row_idx] of
+     * [color_ptr_[color_idx]; color_ptr_[color_idx + 1]).
+     * The rows are stored in this order, row_positions_
+     * is the place of a row of the graph in it.
+     */
+    std::vector<int> color_ptr_;
+    std::vector<int> color_rows_;
+    std::vector<int> row_positions_;
+    /**
+     * The cells of the rows without the diagonal in CSR, the columns are
+     * the places of the rows. The cells of L are before lower_end_,
+     * the cells of U are after it.
+     */
+    int* IA_;
+    int* JA_;
+    double* A_;
+    int* lower_end_;
+    // The relaxation divided by the diagonal, w / a_ii
+    double* relaxed_diagonal_;
+    // The solution of the sweeps in the order of the colors
+    double* color_values_;
+};
+#endif
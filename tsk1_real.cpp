@@ -7,9 +7,28 @@
 #include "tsk1_utils.h"
 #include "tsk1_vector.h"
 #include "tsk1_solver.h"
+#include "tsk1_simd.h"
+#include "tsk1_dia.h"
+#include "tsk1_sell.h"
+#include "tsk1_stencil.h"
+#include "tsk1_symmetric.h"
+#include "tsk1_compressed.h"
+#include "tsk1_reorder.h"
+#include "tsk1_multigrid.h"
 #include "tests/test_Vector.h"
+#include "tests/test_Solver.h"
+#include "tests/test_Matrix.h"
  
 const double CONVERGENCE_EPS = 0.00001;
+enum {
+    /**
+     * The arena takes the graph, its copies in the other formats
+     * or in float, the factor of the preconditioner and the vectors
+     * of the solver
+     */
+    ARENA_GRAPH_COPIES = 4,
+    ARENA_VECTORS = 32
+};
 /**
  * A wrapper over a graph generation
  * Warning: 
@@ -19,14 +38,433 @@ void generateWrapper( size_t row_len, size_t column_len, size_t undivided, size_
 	int* N, int** IA, int** JA){
 	MatrixParameters matrix_param( row_len, column_len, undivided, divided);
 	NetGraph graph( &matrix_param);
-	graph.generate( &matrix_param, 1);
+	graph.generate( &matrix_param);
 	*N = graph.getNodesCount();
 	// Allocate memory
-	size_t edges_max = *N * NETGRAPH_MAX_EDGES_NODE;
-	*IA = new int[edges_max];
-	*JA = new int[edges_max];
-	memcpy( *IA, graph.getIA(), edges_max);
-	memcpy( *JA, graph.getJA(), edges_max);
+	size_t edges_count = graph.getEdgesCount();
+	*IA = new int[*N + 1];
+	*JA = new int[edges_count];
+	memcpy( *IA, graph.getIA(), (*N + 1) * sizeof( int));
+	memcpy( *JA, graph.getJA(), edges_count * sizeof( int));
+}
+/**
+ * Reserve the arena for the arrays of the system.
+ * The system takes the pages, when the arrays are written,
+ * so the arena is reserved with a margin.
+ */
+void reserveArena( MatrixParameters* matrix_param_p, ProgramEnv& program_env){
+    size_t nodes_count = ( matrix_param_p->getRowLen() + 1) *
+        ( matrix_param_p->getColumnLen() + 1);
+    size_t edges_count = NetGraph::countEdges( matrix_param_p);
+    size_t index_size = program_env.isWideIndex() ||
+        !NetGraph::isIndexFitting( edges_count) ? sizeof( int64_t) :
+        sizeof( int);
+    size_t graph_bytes = ( nodes_count + 1 + edges_count) * index_size +
+        edges_count * sizeof( double);
+    size_t vector_bytes = nodes_count * sizeof( double);
+    MemoryArena::getArena().reserve( ARENA_GRAPH_COPIES * graph_bytes +
+        ARENA_VECTORS * vector_bytes, program_env.getArenaPages());
+}
+/**
+ * Print the statistics of the arena after the solves
+ * The statistics are printed only if MEASURE_ARENA define is set
+ */
+void printArenaStatistics(){
+#ifdef MEASURE_ARENA
+    MemoryArena::getArena().printStatistics();
+#endif
+}
+/**
+ * Print the solution in the order of the grid, if the system
+ * was solved in another order
+ */
+void printRestoredSolution( SolverSolution& solution,
+                            NodeOrdering* ordering_p,
+                            ProgramEnv& program_env){
+    if( !ordering_p || !program_env.isDebugPrint() ){
+        return;
+    }
+    MathVector& approximation = solution.getApproximateSolution();
+    MathVector restored( approximation.getVecLen());
+    ordering_p->restoreVector( approximation, restored);
+    std::cout << "The solution in the grid order" << std::endl;
+    restored.printVector();
+}
+/**
+ * Solve the system with the matrix in any storage format
+ * The arrays of a solve are released, when it ends
+ * If ordering_p is set, the system is in the new order of the nodes
+ */
+void runSolver( MatrixOperator& matrix, MathVector& b_vec,
+                Preconditioner& preconditioner, ProgramEnv& program_env,
+                NodeOrdering* ordering_p = NULL){
+#ifdef MEASURE_SOLVER
+    #ifdef MEASURE_MEMORY
+    uint64_t solver_before_mem = getMemoryUsage();
+    #endif
+    double solver_start = omp_get_wtime();
+    double setup_time = 0;
+    int solver_iterations = 0;
+    #ifdef MEASURE_VECTOR_OPS
+    double solve_time = 0;
+    double compared_time = 0;
+    #endif
+#endif
+    {
+        ArenaScope solve_scope;
+        preconditioner.setup( matrix);
+#ifdef MEASURE_SOLVER
+        setup_time = omp_get_wtime() - solver_start;
+#endif
+        SolverWorkspace workspace( matrix.getNodesCount());
+        if( program_env.isPersistentSolver() ){
+            SolverSolution solution = solverCGPersistent( matrix, b_vec,
+                program_env.isDebugPrint(), CONVERGENCE_EPS, preconditioner,
+                workspace);
+            printRestoredSolution( solution, ordering_p, program_env);
+#ifdef MEASURE_SOLVER
+            solver_iterations = solution.getIterationsNumber();
+#endif
+        } else{
+            SolverSolution solution = solverCG( matrix, b_vec,
+                program_env.isDebugPrint(), CONVERGENCE_EPS, preconditioner,
+                workspace, program_env.isFusedOps());
+            printRestoredSolution( solution, ordering_p, program_env);
+#ifdef MEASURE_SOLVER
+            solver_iterations = solution.getIterationsNumber();
+#endif
+        }
+#if defined( MEASURE_SOLVER) && defined( MEASURE_VECTOR_OPS)
+        /**
+         * Compare the solver running in one parallel region
+         * with the solver, that runs the parallel region for every operation.
+         * The other solver takes the same preconditioner and workspace
+         */
+        double compared_start = omp_get_wtime();
+        solve_time = compared_start - solver_start - setup_time;
+        if( program_env.isPersistentSolver() ){
+            solverCG( matrix, b_vec, false, CONVERGENCE_EPS, preconditioner,
+                workspace, program_env.isFusedOps());
+        } else{
+            solverCGPersistent( matrix, b_vec, false, CONVERGENCE_EPS,
+                preconditioner, workspace);
+        }
+        compared_time = omp_get_wtime() - compared_start;
+#endif
+        // The arrays of the setup are released with the scope
+        preconditioner.release();
+    }
+#ifdef MEASURE_SOLVER
+    #ifdef MEASURE_MEMORY
+    uint64_t solver_after_mem = getMemoryUsage();
+    std::cout << "Solver memory usage: " << solver_after_mem -
+    solver_before_mem << std::endl;
+    #endif
+    double solver_end = omp_get_wtime();
+    #ifdef MEASURE_VECTOR_OPS
+    // The compared solve is not a part of the measured one
+    solver_end -= compared_time;
+    #endif
+    std::cout << "Solver time: " << solver_end - solver_start << std::endl;
+    std::cout << "Preconditioner setup time: " << setup_time << std::endl;
+    std::cout << "Solve time: " << solver_end - solver_start - setup_time <<
+    std::endl;
+    std::cout << "Solver iterations: " << solver_iterations << std::endl;
+    preconditioner.printStatistics();
+    // Compare a stronger preconditioner with the Jacobi one
+    if( program_env.getPreconditionerType() !=
+        ProgramEnv::PRECONDITIONER_JACOBI ){
+        double jacobi_start = omp_get_wtime();
+        int jacobi_iterations = 0;
+        {
+            ArenaScope solve_scope;
+            jacobi_iterations = solverCG( matrix, b_vec, false,
+                CONVERGENCE_EPS, program_env.isFusedOps()).getIterationsNumber();
+        }
+        double jacobi_end = omp_get_wtime();
+        std::cout << "Jacobi solver time: " << jacobi_end - jacobi_start <<
+        std::endl;
+        std::cout << "Jacobi iterations: " << jacobi_iterations << std::endl;
+    }
+    #ifdef MEASURE_VECTOR_OPS
+    // Only the solves are compared, the setup is shared
+    double persistent_time = program_env.isPersistentSolver() ?
+        solve_time : compared_time;
+    double default_time = program_env.isPersistentSolver() ?
+        compared_time : solve_time;
+    std::cout << "Persistent region solver time: " << persistent_time <<
+    std::endl;
+    std::cout << "Persistent region speedup: " << default_time /
+    persistent_time << std::endl;
+    #endif
+#endif
+    printArenaStatistics();
+}
+/**
+ * Solve the system with the mixed precision solver.
+ * It takes a float copy of the graph, so the graph must be in CSR.
+ */
+void runMixedSolver( NetGraph& graph, MathVector& b_vec,
+                     ProgramEnv& program_env, NodeOrdering* ordering_p = NULL){
+#ifdef MEASURE_SOLVER
+    double solver_start = omp_get_wtime();
+    int mixed_iterations = 0;
+#endif
+    {
+        ArenaScope solve_scope;
+        SolverSolution solution = solverCGMixed( graph, b_vec,
+            program_env.isDebugPrint(), CONVERGENCE_EPS);
+        printRestoredSolution( solution, ordering_p, program_env);
+#ifdef MEASURE_SOLVER
+        mixed_iterations = solution.getIterationsNumber();
+#endif
+    }
+#ifdef MEASURE_SOLVER
+    double solver_end = omp_get_wtime();
+    std::cout << "Solver time: " << solver_end - solver_start << std::endl;
+    std::cout << "Mixed precision iterations: " << mixed_iterations <<
+    std::endl;
+    // Compare with the solver, that iterates in double
+    double double_start = omp_get_wtime();
+    int double_iterations = 0;
+    {
+        ArenaScope solve_scope;
+        double_iterations = solverCG( graph, b_vec, false, CONVERGENCE_EPS,
+            program_env.isFusedOps()).getIterationsNumber();
+    }
+    double double_end = omp_get_wtime();
+    std::cout << "Double precision solver time: " << double_end -
+    double_start << std::endl;
+    std::cout << "Double precision iterations: " << double_iterations <<
+    std::endl;
+#endif
+    printArenaStatistics();
+}
+/**
+ * Make the preconditioner of the program options.
+ * IC(0), SSOR and the multigrid are taken from the graph in any format.
+ * Results:
+ *      The preconditioner, the caller deletes it
+ */
+Preconditioner* makePreconditioner( NetGraph& graph,
+                                    MatrixParameters* matrix_param_p,
+                                    ProgramEnv& program_env){
+    switch( program_env.getPreconditionerType() ){
+    case ProgramEnv::PRECONDITIONER_IC0:
+        return new IncompleteCholeskyPreconditioner( graph);
+    case ProgramEnv::PRECONDITIONER_SSOR:
+        return new MulticolorSSORPreconditioner( graph);
+    case ProgramEnv::PRECONDITIONER_GMG:
+        return new GeometricMultigridPreconditioner( graph, matrix_param_p);
+    case ProgramEnv::PRECONDITIONER_AMG:
+        return new SmoothedAggregationPreconditioner( graph);
+    default:
+        return new JacobiPreconditioner;
+    }
+}
+/**
+ * Solve the system with the graph converted to the storage format
+ */
+void solveGraph( NetGraph& graph, MathVector& b_vec,
+                 MatrixParameters* matrix_param_p, ProgramEnv& program_env,
+                 NodeOrdering* ordering_p = NULL){
+    Preconditioner* preconditioner_p = makePreconditioner( graph,
+        matrix_param_p, program_env);
+    Preconditioner& preconditioner = *preconditioner_p;
+    if( program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_SELL ){
+        // The chunk height is the width of the vector register
+        SellMatrix sell_matrix( graph, getSimdWidth( getSimdIsa()),
+            program_env.getSortWindow());
+        runSolver( sell_matrix, b_vec, preconditioner, program_env,
+            ordering_p);
+    } else if( program_env.getMatrixFormat() ==
+               ProgramEnv::MATRIX_FORMAT_SYMMETRIC ){
+        SymmetricGraph symmetric_graph( graph);
+        runSolver( symmetric_graph, b_vec, preconditioner, program_env,
+            ordering_p);
+    } else if( program_env.getMatrixFormat() ==
+               ProgramEnv::MATRIX_FORMAT_COMPRESSED ){
+        CompressedGraph compressed_graph( graph);
+        runSolver( compressed_graph, b_vec, preconditioner, program_env,
+            ordering_p);
+    } else if( program_env.isMixedPrecision() ){
+        runMixedSolver( graph, b_vec, program_env, ordering_p);
+    } else{
+        runSolver( graph, b_vec, preconditioner, program_env, ordering_p);
+    }
+    delete preconditioner_p;
+}
+/**
+ * Solve the system in the new order of the nodes: the graph and the right
+ * part are permuted, and the solution is restored to the grid order
+ */
+void runReorderedGraph( NetGraph& graph, MathVector& b_vec,
+                        MatrixParameters* matrix_param_p,
+                        ProgramEnv& program_env){
+#ifdef MEASURE_REORDER
+    double reorder_start = omp_get_wtime();
+#endif
+    NodeOrdering ordering = program_env.getNodeOrder() ==
+        ProgramEnv::NODE_ORDER_RCM ? makeRCMOrdering( graph) :
+        makeMortonOrdering( matrix_param_p);
+    NetGraph reordered_graph = ordering.permuteGraph( graph);
+    MathVector reordered_b( b_vec.getVecLen());
+    ordering.permuteVector( b_vec, reordered_b);
+#ifdef MEASURE_REORDER
+    double reorder_end = omp_get_wtime();
+    std::cout << "Reorder time: " << reorder_end - reorder_start << std::endl;
+    /**
+     * Compare the multiplication in the grid order and in the new order.
+     * The farther the neighbors, the more parts of the vector
+     * the multiplication keeps in the cache.
+     */
+    const int reorder_repeats = 20;
+    MathVector reorder_result( b_vec.getVecLen());
+    double grid_start = omp_get_wtime();
+    for( int repeat = 0; repeat < reorder_repeats; ++repeat ){
+        graph.multiplyDot( b_vec, reorder_result);
+    }
+    double grid_time = omp_get_wtime() - grid_start;
+    double reordered_start = omp_get_wtime();
+    for( int repeat = 0; repeat < reorder_repeats; ++repeat ){
+        reordered_graph.multiplyDot( reordered_b, reorder_result);
+    }
+    double reordered_time = omp_get_wtime() - reordered_start;
+    std::cout << "Grid bandwidth: " << calculateBandwidth( graph) << std::endl;
+    std::cout << "Reordered bandwidth: " <<
+    calculateBandwidth( reordered_graph) << std::endl;
+    std::cout << "Grid multiplication time: " << grid_time / reorder_repeats <<
+    std::endl;
+    std::cout << "Reordered multiplication time: " << reordered_time /
+    reorder_repeats << std::endl;
+#endif
+    solveGraph( reordered_graph, reordered_b, matrix_param_p, program_env,
+        &ordering);
+}
+/**
+ * Generate the matrix in the diagonal format from the parameters and solve
+ * the system. The graph isn't generated, the diagonals don't need IA and JA.
+ */
+int runDiaMatrix( MatrixParameters* matrix_param_p, ProgramEnv& program_env){
+    double start = omp_get_wtime();
+#ifdef MEASURE_GENERATE
+    double generate_start = omp_get_wtime();
+#endif
+    DiaMatrix matrix( matrix_param_p);
+    matrix.generate( matrix_param_p);
+#ifdef MEASURE_GENERATE
+    double generate_end = omp_get_wtime();
+    std::cout << "Generation time: " << generate_end - generate_start << std::endl;
+#endif
+#ifdef MEASURE_FILL
+    double fill_start = omp_get_wtime();
+#endif
+    matrix.fillMatrix();
+    MathVector b_vec( matrix.getNodesCount());
+    b_vec.fillVector();
+#ifdef MEASURE_FILL
+    double fill_end = omp_get_wtime();
+    std::cout << "Fill time: " << fill_end - fill_start << std::endl;
+#endif
+    JacobiPreconditioner preconditioner;
+    runSolver( matrix, b_vec, preconditioner, program_env);
+    double end = omp_get_wtime();
+    std::cout << "Time: " << end - start << std::endl;
+    if( program_env.isDebugPrint() ){
+        b_vec.printVector();
+    }
+    return 0;
+}
+/**
+ * Solve the system without storing the matrix: the cells are calculated
+ * on the fly from the parameters, only the diagonal is stored.
+ */
+int runStencilMatrix( MatrixParameters* matrix_param_p,
+                      ProgramEnv& program_env){
+    double start = omp_get_wtime();
+#ifdef MEASURE_FILL
+    double fill_start = omp_get_wtime();
+#endif
+    StencilMatrix matrix( matrix_param_p);
+    matrix.fillDiagonal();
+    MathVector b_vec( matrix.getNodesCount());
+    b_vec.fillVector();
+#ifdef MEASURE_FILL
+    double fill_end = omp_get_wtime();
+    std::cout << "Fill time: " << fill_end - fill_start << std::endl;
+#endif
+    JacobiPreconditioner preconditioner;
+    runSolver( matrix, b_vec, preconditioner, program_env);
+    double end = omp_get_wtime();
+    std::cout << "Time: " << end - start << std::endl;
+    if( program_env.isDebugPrint() ){
+        b_vec.printVector();
+    }
+    return 0;
+}
+/**
+ * Solve the system with the graph, that has the 64-bit indices.
+ * The other formats are converted from the graph with the 32-bit indices,
+ * so the graph is multiplied in CSR.
+ */
+int runWideGraph( MatrixParameters* matrix_param_p, ProgramEnv& program_env){
+    if( program_env.getMatrixFormat() != ProgramEnv::MATRIX_FORMAT_CSR ){
+        std::cout << "The format needs the 32-bit indices of the graph" <<
+        std::endl;
+        return -1;
+    }
+    if( program_env.isMixedPrecision() ){
+        std::cout << "The mixed precision needs the 32-bit indices of the graph"
+        << std::endl;
+        return -1;
+    }
+    if( program_env.getNodeOrder() != ProgramEnv::NODE_ORDER_GRID ){
+        std::cout << "The order of nodes needs the 32-bit indices of the graph"
+        << std::endl;
+        return -1;
+    }
+    if( program_env.getPreconditionerType() !=
+        ProgramEnv::PRECONDITIONER_JACOBI ){
+        std::cout << "The preconditioner needs the 32-bit indices of the graph"
+        << std::endl;
+        return -1;
+    }
+    double start = omp_get_wtime();
+#ifdef MEASURE_GENERATE
+    double generate_start = omp_get_wtime();
+#endif
+    NetGraph64 graph( matrix_param_p);
+    // The one-pass graph is filled in the generation
+    if( program_env.isTwoPassFill() ){
+        graph.generate( matrix_param_p);
+    } else{
+        graph.generateFilled( matrix_param_p);
+    }
+#ifdef MEASURE_GENERATE
+    double generate_end = omp_get_wtime();
+    std::cout << "Generation time: " << generate_end - generate_start << std::endl;
+#endif
+#ifdef MEASURE_FILL
+    double fill_start = omp_get_wtime();
+#endif
+    if( program_env.isTwoPassFill() ){
+        graph.fillMatrix();
+    }
+    MathVector b_vec( graph.getNodesCount());
+    b_vec.fillVector();
+#ifdef MEASURE_FILL
+    double fill_end = omp_get_wtime();
+    std::cout << "Fill time: " << fill_end - fill_start << std::endl;
+#endif
+    JacobiPreconditioner preconditioner;
+    runSolver( graph, b_vec, preconditioner, program_env);
+    double end = omp_get_wtime();
+    std::cout << "Time: " << end - start << std::endl;
+    if( program_env.isDebugPrint() ){
+        graph.printGraph();
+        b_vec.printVector();
+    }
+    return 0;
 }
 int main( int argc, char **argv){
     if( argc == 1 ){
@@ -39,9 +477,63 @@ int main( int argc, char **argv){
     if( parse_env == -1 ){
         return -1;
     }
+    if( bindThreads( argv, &program_env) == -1 ){
+        return -1;
+    }
     omp_set_num_threads( program_env.getThreadsNum());
     // Run the tests
     launchTests();
+    launchSolverTests();
+    launchMatrixTests();
+    // The tests take their arrays from the heap
+    reserveArena( &matrix_param, program_env);
+    // The float copy is taken from the graph
+    if( program_env.isMixedPrecision() &&
+        program_env.getMatrixFormat() != ProgramEnv::MATRIX_FORMAT_CSR ){
+        std::cout << "The mixed precision needs the graph in CSR" << std::endl;
+        return -1;
+    }
+    // The new order is made from the graph
+    if( program_env.getNodeOrder() != ProgramEnv::NODE_ORDER_GRID &&
+        ( program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_DIA ||
+        program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_STENCIL) ){
+        std::cout << "The order of nodes needs a format of the graph" <<
+        std::endl;
+        return -1;
+    }
+    // IC(0), SSOR and the multigrid are taken from the graph
+    if( program_env.getPreconditionerType() !=
+        ProgramEnv::PRECONDITIONER_JACOBI &&
+        ( program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_DIA ||
+        program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_STENCIL) ){
+        std::cout << "The preconditioner needs a format of the graph" <<
+        std::endl;
+        return -1;
+    }
+    if( program_env.getPreconditionerType() ==
+        ProgramEnv::PRECONDITIONER_GMG &&
+        program_env.getNodeOrder() != ProgramEnv::NODE_ORDER_GRID ){
+        std::cout << "The multigrid needs the grid order of the nodes" <<
+        std::endl;
+        return -1;
+    }
+    if( program_env.getPreconditionerType() !=
+        ProgramEnv::PRECONDITIONER_JACOBI && program_env.isMixedPrecision() ){
+        std::cout << "The mixed precision takes the Jacobi preconditioner" <<
+        std::endl;
+        return -1;
+    }
+    if( program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_DIA ){
+        return runDiaMatrix( &matrix_param, program_env);
+    }
+    if( program_env.getMatrixFormat() == ProgramEnv::MATRIX_FORMAT_STENCIL ){
+        return runStencilMatrix( &matrix_param, program_env);
+    }
+    // The 32-bit indices are used, while the cells fit into them
+    if( program_env.isWideIndex() ||
+        !NetGraph::isIndexFitting( NetGraph::countEdges( &matrix_param)) ){
+        return runWideGraph( &matrix_param, program_env);
+    }
     double start = omp_get_wtime();
     // Measure the phases time if the parameter is set
 #ifdef MEASURE_GENERATE
@@ -51,7 +543,12 @@ int main( int argc, char **argv){
     double generate_start = omp_get_wtime();
 #endif
     NetGraph graph( &matrix_param);
-    graph.generate( &matrix_param, program_env.getThreadsNum());
+    // The one-pass graph is filled in the generation
+    if( program_env.isTwoPassFill() ){
+        graph.generate( &matrix_param);
+    } else{
+        graph.generateFilled( &matrix_param);
+    }
 #ifdef MEASURE_GENERATE
     #ifdef MEASURE_MEMORY
     uint64_t generate_after_mem = getMemoryUsage();
@@ -67,9 +564,11 @@ int main( int argc, char **argv){
     #endif
     double fill_start = omp_get_wtime();
 #endif
-    graph.fillMatrix( program_env.getThreadsNum());
+    if( program_env.isTwoPassFill() ){
+        graph.fillMatrix();
+    }
     MathVector b_vec( graph.getNodesCount());
-    b_vec.fillVector( program_env.getThreadsNum());
+    b_vec.fillVector();
 #ifdef MEASURE_FILL
     #ifdef MEASURE_MEMORY
     uint64_t fill_after_mem = getMemoryUsage();
@@ -79,22 +578,119 @@ int main( int argc, char **argv){
     double fill_end = omp_get_wtime();
     std::cout << "Fill time: " << fill_end - fill_start << std::endl;
 #endif
-#ifdef MEASURE_SOLVER
-    #ifdef MEASURE_MEMORY
-    uint64_t solver_before_mem = getMemoryUsage();
-    #endif
-    double solver_start = omp_get_wtime();
+#ifdef MEASURE_PARTITION
+    /**
+     * Compare the partition of the rows by the static schedule
+     * with the partition by the not-null cells
+     */
+    size_t parts_count = program_env.getThreadsNum();
+    graph.prepareThreads( parts_count);
+    std::cout << "Static schedule imbalance: " << graph.calculateImbalance(
+    graph.makeUniformPartition( parts_count)) << std::endl;
+    std::cout << "Balanced partition imbalance: " << graph.calculateImbalance(
+    graph.getRowPartition()) << std::endl;
 #endif
-    solverCG( graph, b_vec, program_env.isDebugPrint(), CONVERGENCE_EPS);
-#ifdef MEASURE_SOLVER
-    #ifdef MEASURE_MEMORY
-    uint64_t solver_after_mem = getMemoryUsage();
-    std::cout << "Solver memory usage: " << solver_after_mem -
-    solver_before_mem << std::endl;
-    #endif
-    double solver_end = omp_get_wtime();
-    std::cout << "Solver time: " << solver_end - solver_start << std::endl;
+#ifdef MEASURE_SIMD
+    /**
+     * Compare the throughput of the kernels for every supported
+     * instruction set. The bytes are the arrays, that the kernel reads
+     * and writes.
+     */
+    const int simd_repeats = 20;
+    size_t nodes_count = graph.getNodesCount();
+    size_t edges_count = graph.getEdgesCount();
+    double vec_bytes = nodes_count * sizeof( double);
+    double mv_bytes = 3 * vec_bytes + edges_count * ( sizeof( double) + sizeof( int)) +
+        nodes_count * sizeof( int);
+    MathVector simd_result( nodes_count);
+    SimdIsa_t detected_isa = getSimdIsa();
+    std::cout << "ISA\tdot GB/s\taxpby GB/s\tSpMV GB/s" << std::endl;
+    for( int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; ++isa ){
+        if( !isSimdIsaSupported( static_cast<SimdIsa_t>( isa)) ){
+            continue;
+        }
+        setSimdIsa( static_cast<SimdIsa_t>( isa));
+        double dot_start = omp_get_wtime();
+        for( int repeat = 0; repeat < simd_repeats; ++repeat ){
+            dotProduct( b_vec, b_vec);
+        }
+        double dot_time = omp_get_wtime() - dot_start;
+        double comb_start = omp_get_wtime();
+        for( int repeat = 0; repeat < simd_repeats; ++repeat ){
+            linearCombination( b_vec, b_vec, 1, 1, simd_result);
+        }
+        double comb_time = omp_get_wtime() - comb_start;
+        double mv_start = omp_get_wtime();
+        for( int repeat = 0; repeat < simd_repeats; ++repeat ){
+            sparseMV( graph, b_vec, simd_result);
+        }
+        double mv_time = omp_get_wtime() - mv_start;
+        std::cout << getSimdIsaName( static_cast<SimdIsa_t>( isa)) << "\t" <<
+        simd_repeats * 2 * vec_bytes / dot_time * 1e-9 << "\t" <<
+        simd_repeats * 3 * vec_bytes / comb_time * 1e-9 << "\t" <<
+        simd_repeats * mv_bytes / mv_time * 1e-9 << std::endl;
+    }
+    setSimdIsa( detected_isa);
 #endif
+#ifdef MEASURE_FORMAT
+    /**
+     * Compare the storage formats of the same matrix:
+     * the memory of the arrays, the stored cells to the not-null cells
+     * and the multiplication speed, 2 flops for every not-null cell
+     */
+    const int format_repeats = 20;
+    double edges_count = graph.getEdgesCount();
+    double csr_memory = graph.getNodesCount() * sizeof( int) + edges_count *
+        ( sizeof( int) + sizeof( double));
+    SellMatrix sell_format( graph, getSimdWidth( getSimdIsa()),
+        program_env.getSortWindow());
+    DiaMatrix dia_format( &matrix_param);
+    dia_format.generate( &matrix_param);
+    dia_format.fillMatrix();
+    StencilMatrix stencil_format( &matrix_param);
+    stencil_format.fillDiagonal();
+    SymmetricGraph symmetric_format( graph);
+    CompressedGraph compressed_format( graph);
+    MathVector format_result( graph.getNodesCount());
+    const int formats_count = 6;
+    MatrixOperator* formats[] = { &graph, &sell_format, &dia_format,
+        &stencil_format, &symmetric_format, &compressed_format };
+    const char* format_names[] = { "CSR", "SELL", "DIA", "Stencil", "Sym",
+        "Delta" };
+    // The stencil stores only the diagonal
+    double format_memory[] = { csr_memory,
+        static_cast<double>( sell_format.getMemorySize()),
+        static_cast<double>( DIA_DIAGONALS_COUNT * graph.getNodesCount() *
+        sizeof( double)),
+        static_cast<double>( graph.getNodesCount() * sizeof( double)),
+        static_cast<double>( symmetric_format.getMemorySize()),
+        static_cast<double>( compressed_format.getMemorySize()) };
+    double format_cells[] = { edges_count,
+        static_cast<double>( sell_format.getCellsCount()),
+        static_cast<double>( DIA_DIAGONALS_COUNT * graph.getNodesCount()),
+        static_cast<double>( graph.getNodesCount()),
+        static_cast<double>( symmetric_format.getEdgesCount()),
+        static_cast<double>( compressed_format.getEdgesCount()) };
+    std::cout << "Format\tMemory MB\tBytes per not-null\tCells to not-null\t"
+    "GFLOP/s" << std::endl;
+    for( int format_idx = 0; format_idx < formats_count; ++format_idx ){
+        double format_start = omp_get_wtime();
+        for( int repeat = 0; repeat < format_repeats; ++repeat ){
+            formats[format_idx]->multiplyDot( b_vec, format_result);
+        }
+        double format_time = omp_get_wtime() - format_start;
+        std::cout << format_names[format_idx] << "\t" <<
+        format_memory[format_idx] / ( 1 << 20) << "\t" <<
+        format_memory[format_idx] / edges_count << "\t" <<
+        format_cells[format_idx] / edges_count << "\t" <<
+        format_repeats * 2 * edges_count / format_time * 1e-9 << std::endl;
+    }
+#endif
+    if( program_env.getNodeOrder() != ProgramEnv::NODE_ORDER_GRID ){
+        runReorderedGraph( graph, b_vec, &matrix_param, program_env);
+    } else{
+        solveGraph( graph, b_vec, &matrix_param, program_env);
+    }
     double end = omp_get_wtime();
 #ifdef MEASURE_MEMORY
     std::cout << "Memory usage: " << getMemoryUsage() << std::endl;
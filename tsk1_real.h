@@ -1,12 +1,86 @@
+#include <string>
+#include "tsk1_memory.h"
 /**
  * A class that stores information about the program environment
  */
 class ProgramEnv{
+public:
+    typedef enum{
+        // The graph in the CSR format
+        MATRIX_FORMAT_CSR = 0,
+        // The diagonals of the grid
+        MATRIX_FORMAT_DIA,
+        // The sliced ELLPACK converted from the graph
+        MATRIX_FORMAT_SELL,
+        // The cells are calculated on the fly, only the diagonal is stored
+        MATRIX_FORMAT_STENCIL,
+        // The upper triangle of the graph in CSR
+        MATRIX_FORMAT_SYMMETRIC,
+        // The graph in CSR with the columns stored as the deltas
+        MATRIX_FORMAT_COMPRESSED
+    } MatrixFormat_t;
+    typedef enum{
+        // The threads aren't bound by the program, OMP_PROC_BIND is kept
+        THREAD_BIND_NONE = 0,
+        // The threads take the neighbor places
+        THREAD_BIND_CLOSE,
+        // The threads are spread over the places, e.g. over the sockets
+        THREAD_BIND_SPREAD,
+        // The threads take the place of the master thread
+        THREAD_BIND_MASTER
+    } ThreadBind_t;
+    typedef enum{
+        // The nodes are numbered by the rows of the grid
+        NODE_ORDER_GRID = 0,
+        // The reverse Cuthill-McKee order of the graph
+        NODE_ORDER_RCM,
+        // The Morton curve over the grid
+        NODE_ORDER_MORTON
+    } NodeOrder_t;
+    typedef enum{
+        // The inverse of the diagonal
+        PRECONDITIONER_JACOBI = 0,
+        // The incomplete Cholesky factorization on the pattern of the graph
+        PRECONDITIONER_IC0,
+        // The symmetric Gauss-Seidel sweeps over the colors of the graph
+        PRECONDITIONER_SSOR,
+        // The V-cycle of the geometric multigrid over the grid
+        PRECONDITIONER_GMG,
+        // The V-cycle of the smoothed aggregation multigrid over the graph
+        PRECONDITIONER_AMG
+    } PreconditionerType_t;
 private:
     // Is a debug print enabled
     bool debug_print_;
     // Number of threads
     int threads_num_;
+    // The binding of the threads to the places, as OMP_PROC_BIND sets it
+    ThreadBind_t thread_bind_;
+    /**
+     * The places of the threads, as OMP_PLACES sets them:
+     * threads, cores, sockets or a list of the processors
+     */
+    std::string thread_places_;
+    // Does the solver use the fused operations
+    bool fused_ops_;
+    // Does the solver run in one parallel region
+    bool persistent_solver_;
+    // Is the graph generated and filled in two passes
+    bool two_pass_fill_;
+    // A storage format of the matrix
+    MatrixFormat_t matrix_format_;
+    // The rows sorted by length together in the sliced ELLPACK format
+    size_t sort_window_;
+    // Does the graph use the 64-bit indices, even if the 32-bit ones fit
+    bool wide_index_;
+    // Does the solver iterate in float and refine the solution in double
+    bool mixed_precision_;
+    // The order of the nodes, that the system is solved in
+    NodeOrder_t node_order_;
+    // The preconditioner of the solver
+    PreconditionerType_t preconditioner_type_;
+    // The pages of the arena of the arrays, the heap is used for none
+    MemoryArena::PageMode_t arena_pages_;
 public:
     void setDebugPrint( bool debug_print){
         debug_print_ = debug_print;
@@ -20,5 +94,84 @@ public:
     int getThreadsNum(){
         return threads_num_;
     }
-    ProgramEnv(): debug_print_( false), threads_num_( 1){}
+    void setThreadBind( ThreadBind_t thread_bind){
+        thread_bind_ = thread_bind;
+    }
+    ThreadBind_t getThreadBind(){
+        return thread_bind_;
+    }
+    void setThreadPlaces( const std::string& thread_places){
+        thread_places_ = thread_places;
+    }
+    const std::string& getThreadPlaces(){
+        return thread_places_;
+    }
+    void setFusedOps( bool fused_ops){
+        fused_ops_ = fused_ops;
+    }
+    bool isFusedOps(){
+        return fused_ops_;
+    }
+    void setPersistentSolver( bool persistent_solver){
+        persistent_solver_ = persistent_solver;
+    }
+    bool isPersistentSolver(){
+        return persistent_solver_;
+    }
+    void setTwoPassFill( bool two_pass_fill){
+        two_pass_fill_ = two_pass_fill;
+    }
+    bool isTwoPassFill(){
+        return two_pass_fill_;
+    }
+    void setMatrixFormat( MatrixFormat_t matrix_format){
+        matrix_format_ = matrix_format;
+    }
+    MatrixFormat_t getMatrixFormat(){
+        return matrix_format_;
+    }
+    void setSortWindow( size_t sort_window){
+        sort_window_ = sort_window;
+    }
+    size_t getSortWindow(){
+        return sort_window_;
+    }
+    void setWideIndex( bool wide_index){
+        wide_index_ = wide_index;
+    }
+    bool isWideIndex(){
+        return wide_index_;
+    }
+    void setMixedPrecision( bool mixed_precision){
+        mixed_precision_ = mixed_precision;
+    }
+    bool isMixedPrecision(){
+        return mixed_precision_;
+    }
+    void setNodeOrder( NodeOrder_t node_order){
+        node_order_ = node_order;
+    }
+    NodeOrder_t getNodeOrder(){
+        return node_order_;
+    }
+    void setPreconditionerType( PreconditionerType_t preconditioner_type){
+        preconditioner_type_ = preconditioner_type;
+    }
+    PreconditionerType_t getPreconditionerType(){
+        return preconditioner_type_;
+    }
+    void setArenaPages( MemoryArena::PageMode_t arena_pages){
+        arena_pages_ = arena_pages;
+    }
+    MemoryArena::PageMode_t getArenaPages(){
+        return arena_pages_;
+    }
+    ProgramEnv(): debug_print_( false), threads_num_( 1),
+        thread_bind_( THREAD_BIND_NONE), fused_ops_( true),
+        persistent_solver_( false), two_pass_fill_( false),
+        matrix_format_( MATRIX_FORMAT_CSR),
+        sort_window_( 256), wide_index_( false),
+        mixed_precision_( false), node_order_( NODE_ORDER_GRID),
+        preconditioner_type_( PRECONDITIONER_JACOBI),
+        arena_pages_( MemoryArena::PAGES_SMALL){}
 };
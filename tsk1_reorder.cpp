@@ -0,0 +1,304 @@
+/**
+ * The orderings of the graph nodes, that reduce the distance
+ * between the neighbors
+ */
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+#include <type_traits>
+#include <omp.h>
+#include "tsk1_reorder.h"
+// The permuted graph is returned by value, it must be moved with its arrays
+static_assert( !std::is_copy_constructible<NetGraph>::value &&
+               std::is_move_constructible<NetGraph>::value,
+               "The graph owns its arrays, it must be moved, not copied");
+NodeOrdering::NodeOrdering( const std::vector<int>& new_to_old):
+    new_to_old_( new_to_old), old_to_new_( new_to_old.size(), -1){
+    for( size_t new_idx = 0; new_idx < new_to_old_.size(); ++new_idx ){
+        assert( old_to_new_[new_to_old_[new_idx]] == -1);
+        old_to_new_[new_to_old_[new_idx]] = new_idx;
+    }
+}
+/**
+ * Make the graph of the new order: the row new_idx is the row
+ * getOldNode( new_idx), and the columns are renumbered and sorted,
+ * so the diagonal keeps its place between the columns.
+ * The new graph owns its arrays and is moved to the caller.
+ */
+NetGraph NodeOrdering::permuteGraph( NetGraph& graph){
+    size_t nodes_count = graph.getNodesCount();
+    size_t edges_count = graph.getEdgesCount();
+    assert( nodes_count == new_to_old_.size());
+    int* graph_IA = graph.getIA();
+    int* graph_JA = graph.getJA();
+    double* graph_A = graph.getA();
+    int* IA = allocateArray<int>( nodes_count + 1);
+    int* JA = allocateArray<int>( edges_count);
+    double* A = allocateArray<double>( edges_count);
+    size_t edge_idx = 0;
+    for( size_t new_idx = 0; new_idx < nodes_count; ++new_idx ){
+        IA[new_idx] = edge_idx;
+        size_t old_idx = new_to_old_[new_idx];
+        edge_idx += graph_IA[old_idx + 1] - graph_IA[old_idx];
+    }
+    IA[nodes_count] = edges_count;
+    #pragma omp parallel for schedule( static)
+    for( size_t new_idx = 0; new_idx < nodes_count; ++new_idx ){
+        size_t old_idx = new_to_old_[new_idx];
+        size_t cell_idx = IA[new_idx];
+        size_t end_idx = graph_IA[old_idx + 1];
+        for( size_t old_edge = graph_IA[old_idx]; old_edge < end_idx;
+             ++old_edge ){
+            // Insert the cell after the cells with the smaller columns
+            int column_idx = old_to_new_[graph_JA[old_edge]];
+            size_t insert_idx = cell_idx;
+            while( insert_idx > static_cast<size_t>( IA[new_idx]) &&
+                   JA[insert_idx - 1] > column_idx ){
+                JA[insert_idx] = JA[insert_idx - 1];
+                A[insert_idx] = A[insert_idx - 1];
+                --insert_idx;
+            }
+            JA[insert_idx] = column_idx;
+            A[insert_idx] = graph_A[old_edge];
+            ++cell_idx;
+        }
+    }
+    return NetGraph( nodes_count, edges_count, IA, JA, A);
+}
+/**
+ * Take the vector of the grid order to the new order
+ */
+void NodeOrdering::permuteVector( const MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == new_to_old_.size());
+    assert( result.getVecLen() == new_to_old_.size());
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel for schedule( static)
+    for( size_t new_idx = 0; new_idx < new_to_old_.size(); ++new_idx ){
+        result_values[new_idx] = vec_values[new_to_old_[new_idx]];
+    }
+}
+/**
+ * Take the vector of the new order back to the grid order
+ */
+void NodeOrdering::restoreVector( const MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == new_to_old_.size());
+    assert( result.getVecLen() == new_to_old_.size());
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel for schedule( static)
+    for( size_t new_idx = 0; new_idx < new_to_old_.size(); ++new_idx ){
+        result_values[new_to_old_[new_idx]] = vec_values[new_idx];
+    }
+}
+/**
+ * Compare the nodes by their degrees, the nodes with the same degree
+ * are compared by their indices
+ */
+class DegreeLess{
+public:
+    DegreeLess( const std::vector<int>& degrees): degrees_( degrees) {}
+    bool operator()( int first_node, int second_node) const{
+        return degrees_[first_node] < degrees_[second_node] ||
+            ( degrees_[first_node] == degrees_[second_node] &&
+            first_node < second_node);
+    }
+private:
+    const std::vector<int>& degrees_;
+};
+/**
+ * Number the nodes of the component of the start node by the levels
+ * of the breadth-first search, the Cuthill-McKee order: the neighbors
+ * of a node are appended in the order of their degrees.
+ * The nodes are appended to the order, the numbered nodes are marked.
+ * Results:
+ *      A number of the levels. last_level is the index in the order
+ *      of the first node of the last level
+ */
+static size_t appendLevels( NetGraph& graph, const std::vector<int>& degrees,
+                            size_t start_node, std::vector<int>& order,
+                            std::vector<bool>& is_numbered,
+                            size_t& last_level){
+    int* IA = graph.getIA();
+    int* JA = graph.getJA();
+    size_t head_idx = order.size();
+    size_t level_end = head_idx + 1;
+    size_t levels_count = 1;
+    last_level = head_idx;
+    order.push_back( start_node);
+    is_numbered[start_node] = true;
+    std::vector<int> neighbors;
+    while( head_idx < order.size() ){
+        // The current level is numbered, the next level is complete
+        if( head_idx == level_end ){
+            last_level = level_end;
+            level_end = order.size();
+            ++levels_count;
+        }
+        size_t node_idx = order[head_idx++];
+        neighbors.clear();
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            if( !is_numbered[JA[edge_idx]] ){
+                is_numbered[JA[edge_idx]] = true;
+                neighbors.push_back( JA[edge_idx]);
+            }
+        }
+        std::sort( neighbors.begin(), neighbors.end(), DegreeLess( degrees));
+        order.insert( order.end(), neighbors.begin(), neighbors.end());
+    }
+    return levels_count;
+}
+/**
+ * Find a node far from the other nodes of its component:
+ * start from a node, and move to the node of the least degree on the last
+ * level, while the number of the levels grows
+ */
+static size_t findPeripheralNode( NetGraph& graph,
+                                  const std::vector<int>& degrees,
+                                  size_t start_node,
+                                  std::vector<bool>& is_numbered){
+    const int max_searches = 8;
+    size_t levels_count = 0;
+    std::vector<int> order;
+    for( int search_idx = 0; search_idx < max_searches; ++search_idx ){
+        order.clear();
+        size_t last_level = 0;
+        size_t search_levels = appendLevels( graph, degrees, start_node,
+            order, is_numbered, last_level);
+        // The search only marks the nodes, they are numbered later
+        for( size_t order_idx = 0; order_idx < order.size(); ++order_idx ){
+            is_numbered[order[order_idx]] = false;
+        }
+        if( search_levels <= levels_count ){
+            break;
+        }
+        levels_count = search_levels;
+        start_node = *std::min_element( order.begin() + last_level,
+            order.end(), DegreeLess( degrees));
+    }
+    return start_node;
+}
+/**
+ * Make the reverse Cuthill-McKee order: the nodes are numbered by the levels
+ * from a peripheral node, and the order is reversed. The neighbors
+ * of a node are on the neighbor levels, so the distance between them
+ * is at most the width of two levels. On the grid the levels cross
+ * the grid, so they are about as long, as the short side of the grid.
+ */
+NodeOrdering makeRCMOrdering( NetGraph& graph){
+    size_t nodes_count = graph.getNodesCount();
+    int* IA = graph.getIA();
+    std::vector<int> degrees( nodes_count);
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        degrees[node_idx] = IA[node_idx + 1] - IA[node_idx];
+    }
+    std::vector<int> order;
+    order.reserve( nodes_count);
+    std::vector<bool> is_numbered( nodes_count, false);
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        // Every component is numbered from its own peripheral node
+        if( !is_numbered[node_idx] ){
+            size_t start_node = findPeripheralNode( graph, degrees, node_idx,
+                is_numbered);
+            size_t last_level = 0;
+            appendLevels( graph, degrees, start_node, order, is_numbered,
+                last_level);
+        }
+    }
+    std::reverse( order.begin(), order.end());
+    return NodeOrdering( order);
+}
+/**
+ * Interleave the bits of the row and the column, the row takes the odd bits
+ */
+static uint64_t makeMortonKey( uint32_t row_idx, uint32_t column_idx){
+    uint64_t key = 0;
+    for( int bit_idx = 0; bit_idx < 32; ++bit_idx ){
+        key |= static_cast<uint64_t>( ( column_idx >> bit_idx) & 1) <<
+            ( 2 * bit_idx);
+        key |= static_cast<uint64_t>( ( row_idx >> bit_idx) & 1) <<
+            ( 2 * bit_idx + 1);
+    }
+    return key;
+}
+/**
+ * Make the order of the Morton curve over the grid: the grid is split into
+ * the squares, the squares into the smaller squares, and the nodes
+ * of a square are numbered together. The neighbors of a node are mostly
+ * in the same small square, so they are close in the vector.
+ */
+NodeOrdering makeMortonOrdering( MatrixParameters* params_p){
+    size_t row_nodes = params_p->getColumnLen() + 1;
+    size_t nodes_count = ( params_p->getRowLen() + 1) * row_nodes;
+    std::vector<std::pair<uint64_t, int> > keys( nodes_count);
+    #pragma omp parallel for schedule( static)
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        keys[node_idx] = std::make_pair( makeMortonKey( node_idx / row_nodes,
+            node_idx % row_nodes), static_cast<int>( node_idx));
+    }
+    std::sort( keys.begin(), keys.end());
+    std::vector<int> order( nodes_count);
+    for( size_t new_idx = 0; new_idx < nodes_count; ++new_idx ){
+        order[new_idx] = keys[new_idx].second;
+    }
+    return NodeOrdering( order);
+}
+/**
+ * Color the nodes greedily in the order of the graph: a node takes
+ * the least color, that its colored neighbors don't have. The neighbors
+ * have the different colors, so the nodes of a color are independent.
+ * On the grid a node has at most 4 colored neighbors, so at most 5 colors
+ * are taken.
+ * Results:
+ *      A number of the colors. colors has the color of every node
+ */
+size_t colorGraph( NetGraph& graph, std::vector<int>& colors){
+    size_t nodes_count = graph.getNodesCount();
+    int* IA = graph.getIA();
+    int* JA = graph.getJA();
+    colors.assign( nodes_count, -1);
+    // The node, that took the color last, marks the colors of its neighbors
+    std::vector<int> color_marks;
+    size_t colors_count = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            int neighbor_color = colors[JA[edge_idx]];
+            if( neighbor_color >= 0 ){
+                color_marks[neighbor_color] = node_idx;
+            }
+        }
+        size_t color = 0;
+        while( color < colors_count &&
+               color_marks[color] == static_cast<int>( node_idx) ){
+            ++color;
+        }
+        if( color == colors_count ){
+            color_marks.push_back( -1);
+            ++colors_count;
+        }
+        colors[node_idx] = color;
+    }
+    return colors_count;
+}
+/**
+ * Calculate the bandwidth of the graph
+ * Results:
+ *      The maximum distance between the row and the column of a cell
+ */
+size_t calculateBandwidth( NetGraph& graph){
+    int* IA = graph.getIA();
+    int* JA = graph.getJA();
+    size_t bandwidth = 0;
+    #pragma omp parallel for reduction( max:bandwidth)
+    for( size_t node_idx = 0; node_idx < graph.getNodesCount(); ++node_idx ){
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx ){
+            size_t distance = JA[edge_idx] > static_cast<int>( node_idx) ?
+                JA[edge_idx] - node_idx : node_idx - JA[edge_idx];
+            bandwidth = std::max( bandwidth, distance);
+        }
+    }
+    return bandwidth;
+}
@@ -0,0 +1,39 @@
+#ifndef REORDER_H
+    #define REORDER_H
+#include <vector>
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A new numbering of the graph nodes.
+ * The grid numbers the nodes by the rows, so the neighbors of a node
+ * on the next and the previous rows are column_len + 1 nodes away,
+ * and on a wide grid the multiplication reads three distant parts
+ * of the vector. The new order puts the neighbors close to each other.
+ * The system is solved in the new order: the graph and the right part
+ * are permuted, and the solution is restored to the order of the grid.
+ */
+class NodeOrdering{
+public:
+    // The node new_idx of the new order is the node new_to_old[new_idx]
+    NodeOrdering( const std::vector<int>& new_to_old);
+    size_t getNodesCount(){
+        return new_to_old_.size();
+    }
+    int getOldNode( size_t new_idx){
+        return new_to_old_[new_idx];
+    }
+    int getNewNode( size_t old_idx){
+        return old_to_new_[old_idx];
+    }
+    NetGraph permuteGraph( NetGraph& graph);
+    void permuteVector( const MathVector& vec, MathVector& result);
+    void restoreVector( const MathVector& vec, MathVector& result);
+private:
+    std::vector<int> new_to_old_;
+    std::vector<int> old_to_new_;
+};
+NodeOrdering makeRCMOrdering( NetGraph& graph);
+NodeOrdering makeMortonOrdering( MatrixParameters* params_p);
+size_t colorGraph( NetGraph& graph, std::vector<int>& colors);
+size_t calculateBandwidth( NetGraph& graph);
+#endif
@@ -0,0 +1,164 @@
+/**
+ * The graph matrix in the sliced ELLPACK format
+ */
+#include <algorithm>
+#include <omp.h>
+#include "tsk1_sell.h"
+#include "tsk1_simd.h"
+/**
+ * Compare the rows by their length, the longer rows go first
+ */
+class RowLengthGreater{
+public:
+    RowLengthGreater( const std::vector<int>& row_lengths):
+        row_lengths_( row_lengths) {}
+    bool operator()( int first_row, int second_row) const{
+        return row_lengths_[first_row] > row_lengths_[second_row];
+    }
+private:
+    const std::vector<int>& row_lengths_;
+};
+/**
+ * Convert the CSR graph to the sliced ELLPACK format.
+ * The sorting window is rounded up to a multiple of the chunk height,
+ * the window of 1 row keeps the order of the rows.
+ */
+SellMatrix::SellMatrix( NetGraph& graph, size_t chunk_height,
+                        size_t sort_window){
+    assert( chunk_height > 0 && chunk_height <= SELL_MAX_CHUNK_HEIGHT);
+    nodes_count_ = graph.getNodesCount();
+    chunk_height_ = chunk_height;
+    sort_window_ = sort_window > 1 ? ( sort_window + chunk_height - 1) /
+        chunk_height * chunk_height : 1;
+    chunks_count_ = ( nodes_count_ + chunk_height - 1) / chunk_height;
+    int* IA = graph.getIA();
+    int* JA = graph.getJA();
+    double* A = graph.getA();
+    std::vector<int> row_lengths( nodes_count_);
+    row_permutation_ = allocateArray<int>( nodes_count_);
+    chunk_lengths_ = allocateArray<int>( chunks_count_);
+    chunk_offsets_ = allocateArray<int>( chunks_count_ + 1);
+    chunk_offsets_[0] = 0;
+    #pragma omp parallel
+    {
+        size_t start_chunk = 0, end_chunk = 0;
+        getThreadChunks( start_chunk, end_chunk);
+        for( size_t chunk_idx = start_chunk; chunk_idx < end_chunk;
+             ++chunk_idx ){
+            chunk_lengths_[chunk_idx] = 0;
+            chunk_offsets_[chunk_idx + 1] = 0;
+            size_t first_row = chunk_idx * chunk_height_;
+            size_t end_row = std::min( first_row + chunk_height_, nodes_count_);
+            for( size_t node_idx = first_row; node_idx < end_row; ++node_idx ){
+                size_t end_idx = IA[node_idx + 1];
+                row_lengths[node_idx] = end_idx - IA[node_idx];
+                row_permutation_[node_idx] = node_idx;
+            }
+        }
+    }
+    // The stable sort keeps the neighbor rows together
+    for( size_t window_start = 0; sort_window_ > 1 &&
+         window_start < nodes_count_; window_start += sort_window_ ){
+        size_t window_end = std::min( window_start + sort_window_, nodes_count_);
+        std::stable_sort( row_permutation_ + window_start,
+            row_permutation_ + window_end, RowLengthGreater( row_lengths));
+    }
+    for( size_t chunk_idx = 0; chunk_idx < chunks_count_; ++chunk_idx ){
+        size_t first_row = chunk_idx * chunk_height_;
+        size_t end_row = std::min( first_row + chunk_height_, nodes_count_);
+        for( size_t row_idx = first_row; row_idx < end_row; ++row_idx ){
+            chunk_lengths_[chunk_idx] = std::max( chunk_lengths_[chunk_idx],
+                row_lengths[row_permutation_[row_idx]]);
+        }
+        chunk_offsets_[chunk_idx + 1] = chunk_offsets_[chunk_idx] +
+            chunk_lengths_[chunk_idx] * chunk_height_;
+    }
+    cells_count_ = chunk_offsets_[chunks_count_];
+    columns_ = allocateArray<int>( cells_count_);
+    values_ = allocateArray<double>( cells_count_);
+    // Every cell of a chunk is written, the padding ones too
+    #pragma omp parallel
+    {
+        size_t start_chunk = 0, end_chunk = 0;
+        getThreadChunks( start_chunk, end_chunk);
+        for( size_t chunk_idx = start_chunk; chunk_idx < end_chunk;
+             ++chunk_idx ){
+            for( size_t lane_idx = 0; lane_idx < chunk_height_; ++lane_idx ){
+                size_t row_idx = chunk_idx * chunk_height_ + lane_idx;
+                // The rows after the last row of the graph are only the padding
+                size_t node_idx = row_idx < nodes_count_ ?
+                    row_permutation_[row_idx] : 0;
+                int row_length = row_idx < nodes_count_ ?
+                    row_lengths[node_idx] : 0;
+                for( int column_idx = 0; column_idx < chunk_lengths_[chunk_idx];
+                     ++column_idx ){
+                    size_t cell_idx = chunk_offsets_[chunk_idx] +
+                        column_idx * chunk_height_ + lane_idx;
+                    if( column_idx < row_length ){
+                        columns_[cell_idx] = JA[IA[node_idx] + column_idx];
+                        values_[cell_idx] = A[IA[node_idx] + column_idx];
+                    } else{
+                        columns_[cell_idx] = node_idx;
+                        values_[cell_idx] = 0;
+                    }
+                }
+            }
+        }
+    }
+}
+void SellMatrix::multiply( MathVector& vec, MathVector& result){
+    multiplyDot( vec, result);
+}
+double SellMatrix::multiplyDot( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    assert( &result != &vec);
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel reduction( +:sum)
+    {
+        size_t start_chunk = 0, end_chunk = 0;
+        getThreadChunks( start_chunk, end_chunk);
+        sum += sellMVDotKernel( chunk_offsets_, chunk_lengths_, columns_,
+            values_, row_permutation_, chunk_height_, vec_values,
+            result_values, start_chunk, end_chunk, nodes_count_);
+    }
+    return sum;
+}
+double SellMatrix::multiplyDotInRegion( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    size_t start_chunk = 0, end_chunk = 0;
+    getThreadChunks( start_chunk, end_chunk);
+    return sellMVDotKernel( chunk_offsets_, chunk_lengths_, columns_, values_,
+        row_permutation_, chunk_height_, vec.getValues(), result.getValues(),
+        start_chunk, end_chunk, nodes_count_);
+}
+/**
+ * Copy the diagonal of the current matrix
+ */
+void SellMatrix::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    #pragma omp parallel for
+    for( size_t chunk_idx = 0; chunk_idx < chunks_count_; ++chunk_idx ){
+        for( size_t lane_idx = 0; lane_idx < chunk_height_ &&
+             chunk_idx * chunk_height_ + lane_idx < nodes_count_; ++lane_idx ){
+            size_t node_idx = row_permutation_[chunk_idx * chunk_height_ +
+                lane_idx];
+            /**
+             * The padding cells are after the cells of the row,
+             * so the first cell in the node column is the diagonal one
+             */
+            for( int column_idx = 0; column_idx < chunk_lengths_[chunk_idx];
+                 ++column_idx ){
+                size_t cell_idx = chunk_offsets_[chunk_idx] +
+                    column_idx * chunk_height_ + lane_idx;
+                if( columns_[cell_idx] == static_cast<int>( node_idx) ){
+                    diagonal[node_idx] = values_[cell_idx];
+                    break;
+                }
+            }
+        }
+    }
+}
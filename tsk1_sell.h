@@ -0,0 +1,83 @@
+#ifndef SELL_H
+    #define SELL_H
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A matrix in the sliced ELLPACK format with sorting (SELL-C-sigma).
+ * The rows are split into the chunks of chunk_height rows, a chunk stores
+ * its rows column by column and pads them to the longest row of the chunk.
+ * The vectorized multiplication loads one column of a chunk into a register,
+ * so the short rows don't need the horizontal sums and the remainder loops.
+ * Before the split the rows in every window of sort_window rows are sorted
+ * by their length, so the rows of a chunk have almost the same length
+ * and the padding is small.
+ */
+class SellMatrix: public MatrixOperator{
+public:
+SellMatrix( NetGraph& graph, size_t chunk_height, size_t sort_window);
+SellMatrix( const SellMatrix&) = delete;
+~SellMatrix(){
+    freeArray( chunk_offsets_);
+    freeArray( chunk_lengths_);
+    freeArray( columns_);
+    freeArray( values_);
+    freeArray( row_permutation_);
+}
+size_t getNodesCount(){
+    return nodes_count_;
+}
+size_t getChunkHeight(){
+    return chunk_height_;
+}
+size_t getSortWindow(){
+    return sort_window_;
+}
+/**
+ * Get a number of the stored cells, including the padding
+ */
+size_t getCellsCount(){
+    return cells_count_;
+}
+/**
+ * Get the memory of the matrix arrays in bytes
+ */
+size_t getMemorySize(){
+    return cells_count_ * ( sizeof( double) + sizeof( int)) +
+        ( 2 * chunks_count_ + 1 + nodes_count_) * sizeof( int);
+}
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void copyDiagonal( MathVector& diagonal);
+private:
+    /**
+     * Get the chunks [start_chunk; end_chunk) of the current thread.
+     * The construction writes the arrays with the same split, that the
+     * multiplication reads them, so their pages are on the node of the thread.
+     */
+    void getThreadChunks( size_t& start_chunk, size_t& end_chunk){
+        size_t threads_num = omp_get_num_threads();
+        size_t thread_idx = omp_get_thread_num();
+        start_chunk = chunks_count_ * thread_idx / threads_num;
+        end_chunk = chunks_count_ * ( thread_idx + 1) / threads_num;
+    }
+    size_t nodes_count_;
+    size_t chunk_height_;
+    size_t sort_window_;
+    size_t chunks_count_;
+    size_t cells_count_;
+    // The first cell of a chunk, the last element is the number of cells
+    int* chunk_offsets_;
+    // The length of the longest row of a chunk
+    int* chunk_lengths_;
+    /**
+     * The cell column_idx of the row lane_idx of a chunk is at
+     * chunk_offsets_[chunk_idx] + column_idx * chunk_height_ + lane_idx.
+     * The padding cells are zero, their column is the row itself.
+     */
+    int* columns_;
+    double* values_;
+    // The row of the graph for every row of the chunks
+    int* row_permutation_;
+};
+#endif
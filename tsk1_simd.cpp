@@ -0,0 +1,1022 @@
+/**
+ * The vectorized kernels of the basic operations
+ */
+#include <cstring>
+#include <cmath>
+#include "tsk1_simd.h"
+#if defined( __GNUC__) && ( defined( __x86_64__) || defined( __i386__))
+    #define SIMD_X86
+    #include <immintrin.h>
+#endif
+/**
+ * The instruction set of the kernels.
+ * It is selected once, when the program starts.
+ */
+static SimdIsa_t current_isa = detectSimdIsa();
+/**
+ * Find the best instruction set, that the processor supports
+ */
+SimdIsa_t detectSimdIsa(){
+    if( isSimdIsaSupported( SIMD_AVX512) ){
+        return SIMD_AVX512;
+    }
+    if( isSimdIsaSupported( SIMD_AVX2) ){
+        return SIMD_AVX2;
+    }
+    return SIMD_SCALAR;
+}
+bool isSimdIsaSupported( SimdIsa_t isa){
+#ifdef SIMD_X86
+    // The detection may run before main, in a static initialization
+    __builtin_cpu_init();
+#endif
+    switch( isa ){
+    case SIMD_SCALAR:
+        return true;
+#ifdef SIMD_X86
+    case SIMD_AVX2:
+        return __builtin_cpu_supports( "avx2") && __builtin_cpu_supports( "fma");
+    case SIMD_AVX512:
+        return __builtin_cpu_supports( "avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+SimdIsa_t getSimdIsa(){
+    return current_isa;
+}
+/**
+ * Select the instruction set of the kernels
+ * An unsupported instruction set is replaced by the scalar kernels
+ */
+void setSimdIsa( SimdIsa_t isa){
+    current_isa = isSimdIsaSupported( isa) ? isa : SIMD_SCALAR;
+}
+const char* getSimdIsaName( SimdIsa_t isa){
+    switch( isa ){
+    case SIMD_AVX2:
+        return "AVX2";
+    case SIMD_AVX512:
+        return "AVX-512";
+    default:
+        return "Scalar";
+    }
+}
+/**
+ * Get a number of the doubles in a vector register.
+ * The scalar kernels handle the chunks of the sliced ELLPACK matrix
+ * by 4 rows, as AVX2 does.
+ */
+size_t getSimdWidth( SimdIsa_t isa){
+    switch( isa ){
+    case SIMD_AVX512:
+        return 8;
+    default:
+        return 4;
+    }
+}
+/**
+ * Write the products of the chunk rows to the rows of the result,
+ * that the chunk rows were permuted from. The rows after the last row
+ * of the matrix are skipped.
+ * Results:
+ *      The dot product of the vector and the result on the chunk rows
+ */
+static double storeChunkRows( const double* rows_product,
+                              const int* row_permutation, size_t first_row,
+                              size_t chunk_height, size_t nodes_count,
+                              const double* vec, double* result){
+    double sum = 0;
+    for( size_t lane_idx = 0; lane_idx < chunk_height &&
+         first_row + lane_idx < nodes_count; ++lane_idx ){
+        size_t node_idx = row_permutation[first_row + lane_idx];
+        result[node_idx] = rows_product[lane_idx];
+        sum += vec[node_idx] * rows_product[lane_idx];
+    }
+    return sum;
+}
+/**
+ * The scalar kernels
+ */
+static double dotProductScalar( const double* vec_a, const double* vec_b,
+                                size_t vec_len){
+    double sum = 0;
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        sum += vec_a[vec_idx] * vec_b[vec_idx];
+    }
+    return sum;
+}
+static void linearCombinationScalar( const double* vec_a, const double* vec_b,
+                                     double alpha_coeff, double beta_coeff,
+                                     double* result, size_t vec_len){
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        result[vec_idx] = alpha_coeff * vec_a[vec_idx] +
+            beta_coeff * vec_b[vec_idx];
+    }
+}
+template <typename Index_t, typename Value_t, typename Vector_t>
+static double sparseMVDotScalar( const Index_t* IA, const Index_t* JA,
+                                 const Value_t* A, const Vector_t* vec,
+                                 Vector_t* result, size_t start_row,
+                                 size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        double row_product = 0;
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
+            row_product += vec[JA[edge_idx]] * A[edge_idx];
+        }
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+template <typename Delta_t>
+static double compressedMVDotScalar( const int* IA, const Delta_t* deltas,
+                                     const double* A, const double* vec,
+                                     double* result, size_t start_row,
+                                     size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        double row_product = 0;
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx){
+            row_product += vec[node_idx + deltas[edge_idx]] * A[edge_idx];
+        }
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+static double sellMVDotScalar( const int* chunk_offsets,
+                               const int* chunk_lengths, const int* columns,
+                               const double* values, const int* row_permutation,
+                               size_t chunk_height, const double* vec,
+                               double* result, size_t start_chunk,
+                               size_t end_chunk, size_t nodes_count){
+    double sum = 0;
+    for( size_t chunk_idx = start_chunk; chunk_idx < end_chunk; ++chunk_idx ){
+        double rows_product[SELL_MAX_CHUNK_HEIGHT] = { 0 };
+        size_t cell_idx = chunk_offsets[chunk_idx];
+        for( int column_idx = 0; column_idx < chunk_lengths[chunk_idx];
+             ++column_idx ){
+            for( size_t lane_idx = 0; lane_idx < chunk_height; ++lane_idx ){
+                rows_product[lane_idx] += values[cell_idx] *
+                    vec[columns[cell_idx]];
+                ++cell_idx;
+            }
+        }
+        sum += storeChunkRows( rows_product, row_permutation,
+            chunk_idx * chunk_height, chunk_height, nodes_count, vec, result);
+    }
+    return sum;
+}
+/**
+ * The cosine is reduced to [-pi/4; pi/4] by the quadrant of the argument
+ * and is taken by the polynomials of fdlibm.
+ * Pi/2 is split into 3 doubles: the quadrant times the first part is
+ * subtracted by fma() exactly, the rest is subtracted in two doubles,
+ * so the reduction keeps about 100 bits for the arguments
+ * up to COSINE_REDUCTION_LIMIT without the multiprecision reduction of libm.
+ * The larger arguments are taken by libm.
+ */
+static const double COSINE_REDUCTION_LIMIT = 1125899906842624.0; // 2^50
+static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+static const double PIO2_FIRST = 1.57079632679489655800e+00;
+static const double PIO2_SECOND = 6.12323399573676603587e-17;
+static const double PIO2_THIRD = -1.49738490485916983e-33;
+static const double COS_C1 = 4.16666666666666019037e-02;
+static const double COS_C2 = -1.38888888888741095749e-03;
+static const double COS_C3 = 2.48015872894767294178e-05;
+static const double COS_C4 = -2.75573143513906633035e-07;
+static const double COS_C5 = 2.08757232129817482790e-09;
+static const double COS_C6 = -1.13596475577881948265e-11;
+static const double SIN_S1 = -1.66666666666666324348e-01;
+static const double SIN_S2 = 8.33333333332248946124e-03;
+static const double SIN_S3 = -1.98412698298579493134e-04;
+static const double SIN_S4 = 2.75573137070700676789e-06;
+static const double SIN_S5 = -2.50507602534068634195e-08;
+static const double SIN_S6 = 1.58969099521155010221e-10;
+static double cosineScalar( double arg){
+    if( fabs( arg) >= COSINE_REDUCTION_LIMIT ){
+        return cos( arg);
+    }
+    double quadrant = nearbyint( arg * TWO_OVER_PI);
+    // The bits of the difference are within the bits of the double
+    double reduced_high = fma( -quadrant, PIO2_FIRST, arg);
+    double product_high = quadrant * PIO2_SECOND;
+    double product_low = fma( quadrant, PIO2_SECOND, -product_high);
+    // The sum of two doubles and its error
+    double reduced = reduced_high - product_high;
+    double sum_error = reduced - reduced_high;
+    double reduced_low = ( reduced_high - ( reduced - sum_error)) -
+        ( product_high + sum_error);
+    reduced_low = ( reduced_low - product_low) - quadrant * PIO2_THIRD;
+    double reduced_arg = reduced + reduced_low;
+    reduced_low = reduced_low - ( reduced_arg - reduced);
+    // The cosine and the sine of the reduced argument
+    double square = reduced_arg * reduced_arg;
+    double fourth = square * square;
+    double cos_poly = square * ( COS_C1 + square * ( COS_C2 + square * COS_C3))
+        + fourth * fourth * ( COS_C4 + square * ( COS_C5 + square * COS_C6));
+    double half_square = 0.5 * square;
+    double cos_high = 1.0 - half_square;
+    double cos_value = cos_high + ( ( ( 1.0 - cos_high) - half_square) +
+        ( square * cos_poly - reduced_arg * reduced_low));
+    double sin_poly = ( SIN_S2 + square * ( SIN_S3 + square * SIN_S4)) +
+        square * fourth * ( SIN_S5 + square * SIN_S6);
+    double cube = square * reduced_arg;
+    double sin_value = reduced_arg - ( ( square * ( 0.5 * reduced_low -
+        cube * sin_poly) - reduced_low) - cube * SIN_S1);
+    // The quadrants 1 and 3 take the sine, 1 and 2 are negative
+    double quadrant_idx = quadrant - 4.0 * floor( quadrant * 0.25);
+    double value = quadrant_idx == 1.0 || quadrant_idx == 3.0 ? sin_value :
+        cos_value;
+    return quadrant_idx == 1.0 || quadrant_idx == 2.0 ? -value : value;
+}
+static void cosineKernelScalar( const double* args, double* result,
+                                size_t count){
+    for( size_t arg_idx = 0; arg_idx < count; ++arg_idx ){
+        result[arg_idx] = cosineScalar( args[arg_idx]);
+    }
+}
+#ifdef SIMD_X86
+/**
+ * The AVX2 kernels.
+ * A row of the matrix has 3-7 not-null cells, so it is multiplied
+ * by the gather of 4 elements, the rest is masked.
+ */
+__attribute__(( target( "avx2,fma")))
+static double horizontalSumAvx2( __m256d vec){
+    __m128d low = _mm256_castpd256_pd128( vec);
+    __m128d high = _mm256_extractf128_pd( vec, 1);
+    low = _mm_add_pd( low, high);
+    return _mm_cvtsd_f64( _mm_add_sd( low, _mm_unpackhi_pd( low, low)));
+}
+__attribute__(( target( "avx2,fma")))
+static double dotProductAvx2( const double* vec_a, const double* vec_b,
+                              size_t vec_len){
+    __m256d first_sum = _mm256_setzero_pd();
+    __m256d second_sum = _mm256_setzero_pd();
+    size_t vec_idx = 0;
+    for( ; vec_idx + 8 <= vec_len; vec_idx += 8){
+        first_sum = _mm256_fmadd_pd( _mm256_loadu_pd( vec_a + vec_idx),
+            _mm256_loadu_pd( vec_b + vec_idx), first_sum);
+        second_sum = _mm256_fmadd_pd( _mm256_loadu_pd( vec_a + vec_idx + 4),
+            _mm256_loadu_pd( vec_b + vec_idx + 4), second_sum);
+    }
+    double sum = horizontalSumAvx2( _mm256_add_pd( first_sum, second_sum));
+    for( ; vec_idx < vec_len; ++vec_idx){
+        sum += vec_a[vec_idx] * vec_b[vec_idx];
+    }
+    return sum;
+}
+__attribute__(( target( "avx2,fma")))
+static void linearCombinationAvx2( const double* vec_a, const double* vec_b,
+                                   double alpha_coeff, double beta_coeff,
+                                   double* result, size_t vec_len){
+    __m256d alpha_vec = _mm256_set1_pd( alpha_coeff);
+    __m256d beta_vec = _mm256_set1_pd( beta_coeff);
+    size_t vec_idx = 0;
+    for( ; vec_idx + 4 <= vec_len; vec_idx += 4){
+        __m256d b_part = _mm256_mul_pd( beta_vec,
+            _mm256_loadu_pd( vec_b + vec_idx));
+        _mm256_storeu_pd( result + vec_idx, _mm256_fmadd_pd( alpha_vec,
+            _mm256_loadu_pd( vec_a + vec_idx), b_part));
+    }
+    for( ; vec_idx < vec_len; ++vec_idx){
+        result[vec_idx] = alpha_coeff * vec_a[vec_idx] +
+            beta_coeff * vec_b[vec_idx];
+    }
+}
+__attribute__(( target( "avx2,fma")))
+static double sparseMVDotAvx2( const int* IA, const int* JA, const double* A,
+                               const double* vec, double* result,
+                               size_t start_row, size_t end_row){
+    const __m128i lanes_32 = _mm_setr_epi32( 0, 1, 2, 3);
+    const __m256i lanes_64 = _mm256_setr_epi64x( 0, 1, 2, 3);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        size_t edge_idx = IA[node_idx];
+        __m256d row_sum = _mm256_setzero_pd();
+        for( ; edge_idx + 4 <= end_idx; edge_idx += 4){
+            __m128i columns = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>( JA + edge_idx));
+            row_sum = _mm256_fmadd_pd( _mm256_loadu_pd( A + edge_idx),
+                _mm256_i32gather_pd( vec, columns, 8), row_sum);
+        }
+        if( edge_idx < end_idx ){
+            // Mask the cells after the end of the row
+            int rest = end_idx - edge_idx;
+            __m128i mask_32 = _mm_cmpgt_epi32( _mm_set1_epi32( rest), lanes_32);
+            __m256i mask_64 = _mm256_cmpgt_epi64( _mm256_set1_epi64x( rest),
+                lanes_64);
+            __m128i columns = _mm_maskload_epi32( JA + edge_idx, mask_32);
+            __m256d cells = _mm256_maskload_pd( A + edge_idx, mask_64);
+            __m256d elems = _mm256_mask_i32gather_pd( _mm256_setzero_pd(), vec,
+                columns, _mm256_castsi256_pd( mask_64), 8);
+            row_sum = _mm256_fmadd_pd( cells, elems, row_sum);
+        }
+        double row_product = horizontalSumAvx2( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * The 64-bit columns are gathered by 4 directly
+ */
+__attribute__(( target( "avx2,fma")))
+static double sparseMVDotAvx2( const int64_t* IA, const int64_t* JA,
+                               const double* A, const double* vec,
+                               double* result, size_t start_row,
+                               size_t end_row){
+    const __m256i lanes_64 = _mm256_setr_epi64x( 0, 1, 2, 3);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        size_t edge_idx = IA[node_idx];
+        __m256d row_sum = _mm256_setzero_pd();
+        for( ; edge_idx + 4 <= end_idx; edge_idx += 4){
+            __m256i columns = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>( JA + edge_idx));
+            row_sum = _mm256_fmadd_pd( _mm256_loadu_pd( A + edge_idx),
+                _mm256_i64gather_pd( vec, columns, 8), row_sum);
+        }
+        if( edge_idx < end_idx ){
+            // Mask the cells after the end of the row
+            __m256i mask = _mm256_cmpgt_epi64( _mm256_set1_epi64x(
+                end_idx - edge_idx), lanes_64);
+            __m256i columns = _mm256_maskload_epi64(
+                reinterpret_cast<const long long*>( JA + edge_idx), mask);
+            __m256d cells = _mm256_maskload_pd( A + edge_idx, mask);
+            __m256d elems = _mm256_mask_i64gather_pd( _mm256_setzero_pd(), vec,
+                columns, _mm256_castsi256_pd( mask), 8);
+            row_sum = _mm256_fmadd_pd( cells, elems, row_sum);
+        }
+        double row_product = horizontalSumAvx2( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * The float cells and vector elements of the mixed precision solver.
+ * A row fits into a single gather of 8 elements.
+ */
+__attribute__(( target( "avx2,fma")))
+static double sparseMVDotAvx2( const int* IA, const int* JA, const float* A,
+                               const float* vec, float* result,
+                               size_t start_row, size_t end_row){
+    const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        __m256 row_sum = _mm256_setzero_ps();
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             edge_idx += 8){
+            // Mask the cells after the end of the row
+            int rest = end_idx - edge_idx;
+            __m256i mask = _mm256_cmpgt_epi32( _mm256_set1_epi32( rest), lanes);
+            __m256i columns = _mm256_maskload_epi32( JA + edge_idx, mask);
+            __m256 cells = _mm256_maskload_ps( A + edge_idx, mask);
+            __m256 elems = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), vec,
+                columns, _mm256_castsi256_ps( mask), 4);
+            row_sum = _mm256_fmadd_ps( cells, elems, row_sum);
+        }
+        __m128 half_sum = _mm_add_ps( _mm256_castps256_ps128( row_sum),
+            _mm256_extractf128_ps( row_sum, 1));
+        half_sum = _mm_add_ps( half_sum, _mm_movehl_ps( half_sum, half_sum));
+        float row_product = _mm_cvtss_f32( _mm_add_ss( half_sum,
+            _mm_movehdup_ps( half_sum)));
+        result[node_idx] = row_product;
+        sum += static_cast<double>( vec[node_idx]) * row_product;
+    }
+    return sum;
+}
+/**
+ * Load 4 deltas and extend them to int
+ */
+__attribute__(( target( "avx2,fma")))
+static __m128i loadDeltasAvx2( const int8_t* deltas){
+    int packed_deltas = 0;
+    memcpy( &packed_deltas, deltas, sizeof( packed_deltas));
+    return _mm_cvtepi8_epi32( _mm_cvtsi32_si128( packed_deltas));
+}
+__attribute__(( target( "avx2,fma")))
+static __m128i loadDeltasAvx2( const int16_t* deltas){
+    return _mm_cvtepi16_epi32( _mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>( deltas)));
+}
+/**
+ * The columns are the row plus the deltas. The deltas after the end
+ * of the row are loaded, but their cells are masked.
+ */
+template <typename Delta_t>
+__attribute__(( target( "avx2,fma")))
+static double compressedMVDotAvx2( const int* IA, const Delta_t* deltas,
+                                   const double* A, const double* vec,
+                                   double* result, size_t start_row,
+                                   size_t end_row){
+    const __m256i lanes_64 = _mm256_setr_epi64x( 0, 1, 2, 3);
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        size_t edge_idx = IA[node_idx];
+        __m128i row = _mm_set1_epi32( node_idx);
+        __m256d row_sum = _mm256_setzero_pd();
+        for( ; edge_idx + 4 <= end_idx; edge_idx += 4){
+            __m128i columns = _mm_add_epi32( row,
+                loadDeltasAvx2( deltas + edge_idx));
+            row_sum = _mm256_fmadd_pd( _mm256_loadu_pd( A + edge_idx),
+                _mm256_i32gather_pd( vec, columns, 8), row_sum);
+        }
+        if( edge_idx < end_idx ){
+            __m256i mask = _mm256_cmpgt_epi64( _mm256_set1_epi64x(
+                end_idx - edge_idx), lanes_64);
+            __m128i columns = _mm_add_epi32( row,
+                loadDeltasAvx2( deltas + edge_idx));
+            __m256d cells = _mm256_maskload_pd( A + edge_idx, mask);
+            __m256d elems = _mm256_mask_i32gather_pd( _mm256_setzero_pd(), vec,
+                columns, _mm256_castsi256_pd( mask), 8);
+            row_sum = _mm256_fmadd_pd( cells, elems, row_sum);
+        }
+        double row_product = horizontalSumAvx2( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * A column of a chunk is loaded by the groups of 4 rows.
+ * The chunk height must be a multiple of 4.
+ */
+__attribute__(( target( "avx2,fma")))
+static double sellMVDotAvx2( const int* chunk_offsets, const int* chunk_lengths,
+                             const int* columns, const double* values,
+                             const int* row_permutation, size_t chunk_height,
+                             const double* vec, double* result,
+                             size_t start_chunk, size_t end_chunk,
+                             size_t nodes_count){
+    size_t groups_count = chunk_height / 4;
+    double sum = 0;
+    for( size_t chunk_idx = start_chunk; chunk_idx < end_chunk; ++chunk_idx ){
+        __m256d rows_sum[SELL_MAX_CHUNK_HEIGHT / 4];
+        for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+            rows_sum[group_idx] = _mm256_setzero_pd();
+        }
+        size_t cell_idx = chunk_offsets[chunk_idx];
+        for( int column_idx = 0; column_idx < chunk_lengths[chunk_idx];
+             ++column_idx ){
+            for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+                __m128i group_columns = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>( columns + cell_idx));
+                rows_sum[group_idx] = _mm256_fmadd_pd( _mm256_loadu_pd(
+                    values + cell_idx), _mm256_i32gather_pd( vec,
+                    group_columns, 8), rows_sum[group_idx]);
+                cell_idx += 4;
+            }
+        }
+        double rows_product[SELL_MAX_CHUNK_HEIGHT];
+        for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+            _mm256_storeu_pd( rows_product + 4 * group_idx, rows_sum[group_idx]);
+        }
+        sum += storeChunkRows( rows_product, row_permutation,
+            chunk_idx * chunk_height, chunk_height, nodes_count, vec, result);
+    }
+    return sum;
+}
+/**
+ * The cosines of 4 arguments, the operations of cosineScalar()
+ */
+__attribute__(( target( "avx2,fma")))
+static __m256d cosineAvx2( __m256d arg){
+    const __m256d sign_mask = _mm256_set1_pd( -0.0);
+    __m256d quadrant = _mm256_round_pd( _mm256_mul_pd( arg,
+        _mm256_set1_pd( TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT |
+        _MM_FROUND_NO_EXC);
+    __m256d reduced_high = _mm256_fnmadd_pd( quadrant,
+        _mm256_set1_pd( PIO2_FIRST), arg);
+    __m256d product_high = _mm256_mul_pd( quadrant,
+        _mm256_set1_pd( PIO2_SECOND));
+    __m256d product_low = _mm256_fmsub_pd( quadrant,
+        _mm256_set1_pd( PIO2_SECOND), product_high);
+    __m256d reduced = _mm256_sub_pd( reduced_high, product_high);
+    __m256d sum_error = _mm256_sub_pd( reduced, reduced_high);
+    __m256d reduced_low = _mm256_sub_pd( _mm256_sub_pd( reduced_high,
+        _mm256_sub_pd( reduced, sum_error)), _mm256_add_pd( product_high,
+        sum_error));
+    reduced_low = _mm256_sub_pd( _mm256_sub_pd( reduced_low, product_low),
+        _mm256_mul_pd( quadrant, _mm256_set1_pd( PIO2_THIRD)));
+    __m256d reduced_arg = _mm256_add_pd( reduced, reduced_low);
+    reduced_low = _mm256_sub_pd( reduced_low, _mm256_sub_pd( reduced_arg,
+        reduced));
+    __m256d square = _mm256_mul_pd( reduced_arg, reduced_arg);
+    __m256d fourth = _mm256_mul_pd( square, square);
+    __m256d cos_poly = _mm256_add_pd( _mm256_mul_pd( square, _mm256_add_pd(
+        _mm256_set1_pd( COS_C1), _mm256_mul_pd( square, _mm256_add_pd(
+        _mm256_set1_pd( COS_C2), _mm256_mul_pd( square,
+        _mm256_set1_pd( COS_C3)))))), _mm256_mul_pd( _mm256_mul_pd( fourth,
+        fourth), _mm256_add_pd( _mm256_set1_pd( COS_C4), _mm256_mul_pd(
+        square, _mm256_add_pd( _mm256_set1_pd( COS_C5), _mm256_mul_pd( square,
+        _mm256_set1_pd( COS_C6)))))));
+    __m256d half_square = _mm256_mul_pd( _mm256_set1_pd( 0.5), square);
+    __m256d one = _mm256_set1_pd( 1.0);
+    __m256d cos_high = _mm256_sub_pd( one, half_square);
+    __m256d cos_value = _mm256_add_pd( cos_high, _mm256_add_pd( _mm256_sub_pd(
+        _mm256_sub_pd( one, cos_high), half_square), _mm256_sub_pd(
+        _mm256_mul_pd( square, cos_poly), _mm256_mul_pd( reduced_arg,
+        reduced_low))));
+    __m256d sin_poly = _mm256_add_pd( _mm256_add_pd( _mm256_set1_pd( SIN_S2),
+        _mm256_mul_pd( square, _mm256_add_pd( _mm256_set1_pd( SIN_S3),
+        _mm256_mul_pd( square, _mm256_set1_pd( SIN_S4))))), _mm256_mul_pd(
+        _mm256_mul_pd( square, fourth), _mm256_add_pd( _mm256_set1_pd( SIN_S5),
+        _mm256_mul_pd( square, _mm256_set1_pd( SIN_S6)))));
+    __m256d cube = _mm256_mul_pd( square, reduced_arg);
+    __m256d sin_value = _mm256_sub_pd( reduced_arg, _mm256_sub_pd(
+        _mm256_sub_pd( _mm256_mul_pd( square, _mm256_sub_pd( _mm256_mul_pd(
+        _mm256_set1_pd( 0.5), reduced_low), _mm256_mul_pd( cube, sin_poly))),
+        reduced_low), _mm256_mul_pd( cube, _mm256_set1_pd( SIN_S1))));
+    __m256d quadrant_idx = _mm256_sub_pd( quadrant, _mm256_mul_pd(
+        _mm256_set1_pd( 4.0), _mm256_floor_pd( _mm256_mul_pd( quadrant,
+        _mm256_set1_pd( 0.25)))));
+    __m256d is_first = _mm256_cmp_pd( quadrant_idx, one, _CMP_EQ_OQ);
+    __m256d is_second = _mm256_cmp_pd( quadrant_idx, _mm256_set1_pd( 2.0),
+        _CMP_EQ_OQ);
+    __m256d is_third = _mm256_cmp_pd( quadrant_idx, _mm256_set1_pd( 3.0),
+        _CMP_EQ_OQ);
+    __m256d value = _mm256_blendv_pd( cos_value, sin_value,
+        _mm256_or_pd( is_first, is_third));
+    return _mm256_xor_pd( value, _mm256_and_pd( sign_mask,
+        _mm256_or_pd( is_first, is_second)));
+}
+__attribute__(( target( "avx2,fma")))
+static void cosineKernelAvx2( const double* args, double* result,
+                              size_t count){
+    const __m256d limit = _mm256_set1_pd( COSINE_REDUCTION_LIMIT);
+    const __m256d abs_mask = _mm256_castsi256_pd( _mm256_set1_epi64x(
+        0x7FFFFFFFFFFFFFFFLL));
+    size_t arg_idx = 0;
+    for( ; arg_idx + 4 <= count; arg_idx += 4){
+        __m256d arg = _mm256_loadu_pd( args + arg_idx);
+        _mm256_storeu_pd( result + arg_idx, cosineAvx2( arg));
+        // The large arguments are taken by libm
+        if( _mm256_movemask_pd( _mm256_cmp_pd( _mm256_and_pd( arg, abs_mask),
+            limit, _CMP_GE_OQ)) ){
+            cosineKernelScalar( args + arg_idx, result + arg_idx, 4);
+        }
+    }
+    cosineKernelScalar( args + arg_idx, result + arg_idx, count - arg_idx);
+}
+/**
+ * The AVX-512 kernels.
+ * A row of the matrix fits into a single gather of 8 elements.
+ */
+__attribute__(( target( "avx512f")))
+static double dotProductAvx512( const double* vec_a, const double* vec_b,
+                                size_t vec_len){
+    __m512d first_sum = _mm512_setzero_pd();
+    __m512d second_sum = _mm512_setzero_pd();
+    size_t vec_idx = 0;
+    for( ; vec_idx + 16 <= vec_len; vec_idx += 16){
+        first_sum = _mm512_fmadd_pd( _mm512_loadu_pd( vec_a + vec_idx),
+            _mm512_loadu_pd( vec_b + vec_idx), first_sum);
+        second_sum = _mm512_fmadd_pd( _mm512_loadu_pd( vec_a + vec_idx + 8),
+            _mm512_loadu_pd( vec_b + vec_idx + 8), second_sum);
+    }
+    for( ; vec_idx < vec_len; vec_idx += 8){
+        __mmask8 mask = vec_len - vec_idx >= 8 ? 0xFF :
+            ( 1 << ( vec_len - vec_idx)) - 1;
+        first_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+            vec_a + vec_idx), _mm512_maskz_loadu_pd( mask, vec_b + vec_idx),
+            first_sum);
+    }
+    return _mm512_reduce_add_pd( _mm512_add_pd( first_sum, second_sum));
+}
+__attribute__(( target( "avx512f")))
+static void linearCombinationAvx512( const double* vec_a, const double* vec_b,
+                                     double alpha_coeff, double beta_coeff,
+                                     double* result, size_t vec_len){
+    __m512d alpha_vec = _mm512_set1_pd( alpha_coeff);
+    __m512d beta_vec = _mm512_set1_pd( beta_coeff);
+    for( size_t vec_idx = 0; vec_idx < vec_len; vec_idx += 8){
+        __mmask8 mask = vec_len - vec_idx >= 8 ? 0xFF :
+            ( 1 << ( vec_len - vec_idx)) - 1;
+        __m512d b_part = _mm512_mul_pd( beta_vec,
+            _mm512_maskz_loadu_pd( mask, vec_b + vec_idx));
+        _mm512_mask_storeu_pd( result + vec_idx, mask, _mm512_fmadd_pd(
+            alpha_vec, _mm512_maskz_loadu_pd( mask, vec_a + vec_idx), b_part));
+    }
+}
+__attribute__(( target( "avx512f")))
+static double sparseMVDotAvx512( const int* IA, const int* JA, const double* A,
+                                 const double* vec, double* result,
+                                 size_t start_row, size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        __m512d row_sum = _mm512_setzero_pd();
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             edge_idx += 8){
+            __mmask8 mask = end_idx - edge_idx >= 8 ? 0xFF :
+                ( 1 << ( end_idx - edge_idx)) - 1;
+            __m256i columns = _mm512_castsi512_si256( _mm512_maskz_loadu_epi32(
+                mask, JA + edge_idx));
+            __m512d elems = _mm512_mask_i32gather_pd( _mm512_setzero_pd(),
+                mask, columns, vec, 8);
+            row_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+                A + edge_idx), elems, row_sum);
+        }
+        double row_product = _mm512_reduce_add_pd( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+__attribute__(( target( "avx512f")))
+static double sparseMVDotAvx512( const int64_t* IA, const int64_t* JA,
+                                 const double* A, const double* vec,
+                                 double* result, size_t start_row,
+                                 size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        __m512d row_sum = _mm512_setzero_pd();
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             edge_idx += 8){
+            __mmask8 mask = end_idx - edge_idx >= 8 ? 0xFF :
+                ( 1 << ( end_idx - edge_idx)) - 1;
+            __m512i columns = _mm512_maskz_loadu_epi64( mask, JA + edge_idx);
+            __m512d elems = _mm512_mask_i64gather_pd( _mm512_setzero_pd(),
+                mask, columns, vec, 8);
+            row_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+                A + edge_idx), elems, row_sum);
+        }
+        double row_product = _mm512_reduce_add_pd( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * Load 8 deltas and extend them to int
+ */
+__attribute__(( target( "avx512f")))
+static __m256i loadDeltasAvx512( const int8_t* deltas){
+    return _mm256_cvtepi8_epi32( _mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>( deltas)));
+}
+__attribute__(( target( "avx512f")))
+static __m256i loadDeltasAvx512( const int16_t* deltas){
+    return _mm256_cvtepi16_epi32( _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>( deltas)));
+}
+template <typename Delta_t>
+__attribute__(( target( "avx512f")))
+static double compressedMVDotAvx512( const int* IA, const Delta_t* deltas,
+                                     const double* A, const double* vec,
+                                     double* result, size_t start_row,
+                                     size_t end_row){
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx){
+        size_t end_idx = IA[node_idx + 1];
+        __m256i row = _mm256_set1_epi32( node_idx);
+        __m512d row_sum = _mm512_setzero_pd();
+        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx;
+             edge_idx += 8){
+            __mmask8 mask = end_idx - edge_idx >= 8 ? 0xFF :
+                ( 1 << ( end_idx - edge_idx)) - 1;
+            __m256i columns = _mm256_add_epi32( row,
+                loadDeltasAvx512( deltas + edge_idx));
+            __m512d elems = _mm512_mask_i32gather_pd( _mm512_setzero_pd(),
+                mask, columns, vec, 8);
+            row_sum = _mm512_fmadd_pd( _mm512_maskz_loadu_pd( mask,
+                A + edge_idx), elems, row_sum);
+        }
+        double row_product = _mm512_reduce_add_pd( row_sum);
+        result[node_idx] = row_product;
+        sum += vec[node_idx] * row_product;
+    }
+    return sum;
+}
+/**
+ * A column of a chunk is loaded by the groups of 8 rows.
+ * The chunk height must be a multiple of 8.
+ */
+__attribute__(( target( "avx512f")))
+static double sellMVDotAvx512( const int* chunk_offsets,
+                               const int* chunk_lengths, const int* columns,
+                               const double* values, const int* row_permutation,
+                               size_t chunk_height, const double* vec,
+                               double* result, size_t start_chunk,
+                               size_t end_chunk, size_t nodes_count){
+    size_t groups_count = chunk_height / 8;
+    double sum = 0;
+    for( size_t chunk_idx = start_chunk; chunk_idx < end_chunk; ++chunk_idx ){
+        __m512d rows_sum[SELL_MAX_CHUNK_HEIGHT / 8];
+        for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+            rows_sum[group_idx] = _mm512_setzero_pd();
+        }
+        size_t cell_idx = chunk_offsets[chunk_idx];
+        for( int column_idx = 0; column_idx < chunk_lengths[chunk_idx];
+             ++column_idx ){
+            for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+                __m256i group_columns = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>( columns + cell_idx));
+                rows_sum[group_idx] = _mm512_fmadd_pd( _mm512_loadu_pd(
+                    values + cell_idx), _mm512_i32gather_pd( group_columns,
+                    vec, 8), rows_sum[group_idx]);
+                cell_idx += 8;
+            }
+        }
+        double rows_product[SELL_MAX_CHUNK_HEIGHT];
+        for( size_t group_idx = 0; group_idx < groups_count; ++group_idx ){
+            _mm512_storeu_pd( rows_product + 8 * group_idx, rows_sum[group_idx]);
+        }
+        sum += storeChunkRows( rows_product, row_permutation,
+            chunk_idx * chunk_height, chunk_height, nodes_count, vec, result);
+    }
+    return sum;
+}
+/**
+ * The cosines of 8 arguments, the operations of cosineScalar()
+ */
+__attribute__(( target( "avx512f")))
+static __m512d cosineAvx512( __m512d arg){
+    __m512d quadrant = _mm512_roundscale_pd( _mm512_mul_pd( arg,
+        _mm512_set1_pd( TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT |
+        _MM_FROUND_NO_EXC);
+    __m512d reduced_high = _mm512_fnmadd_pd( quadrant,
+        _mm512_set1_pd( PIO2_FIRST), arg);
+    __m512d product_high = _mm512_mul_pd( quadrant,
+        _mm512_set1_pd( PIO2_SECOND));
+    __m512d product_low = _mm512_fmsub_pd( quadrant,
+        _mm512_set1_pd( PIO2_SECOND), product_high);
+    __m512d reduced = _mm512_sub_pd( reduced_high, product_high);
+    __m512d sum_error = _mm512_sub_pd( reduced, reduced_high);
+    __m512d reduced_low = _mm512_sub_pd( _mm512_sub_pd( reduced_high,
+        _mm512_sub_pd( reduced, sum_error)), _mm512_add_pd( product_high,
+        sum_error));
+    reduced_low = _mm512_sub_pd( _mm512_sub_pd( reduced_low, product_low),
+        _mm512_mul_pd( quadrant, _mm512_set1_pd( PIO2_THIRD)));
+    __m512d reduced_arg = _mm512_add_pd( reduced, reduced_low);
+    reduced_low = _mm512_sub_pd( reduced_low, _mm512_sub_pd( reduced_arg,
+        reduced));
+    __m512d square = _mm512_mul_pd( reduced_arg, reduced_arg);
+    __m512d fourth = _mm512_mul_pd( square, square);
+    __m512d cos_poly = _mm512_add_pd( _mm512_mul_pd( square, _mm512_add_pd(
+        _mm512_set1_pd( COS_C1), _mm512_mul_pd( square, _mm512_add_pd(
+        _mm512_set1_pd( COS_C2), _mm512_mul_pd( square,
+        _mm512_set1_pd( COS_C3)))))), _mm512_mul_pd( _mm512_mul_pd( fourth,
+        fourth), _mm512_add_pd( _mm512_set1_pd( COS_C4), _mm512_mul_pd(
+        square, _mm512_add_pd( _mm512_set1_pd( COS_C5), _mm512_mul_pd( square,
+        _mm512_set1_pd( COS_C6)))))));
+    __m512d half_square = _mm512_mul_pd( _mm512_set1_pd( 0.5), square);
+    __m512d one = _mm512_set1_pd( 1.0);
+    __m512d cos_high = _mm512_sub_pd( one, half_square);
+    __m512d cos_value = _mm512_add_pd( cos_high, _mm512_add_pd( _mm512_sub_pd(
+        _mm512_sub_pd( one, cos_high), half_square), _mm512_sub_pd(
+        _mm512_mul_pd( square, cos_poly), _mm512_mul_pd( reduced_arg,
+        reduced_low))));
+    __m512d sin_poly = _mm512_add_pd( _mm512_add_pd( _mm512_set1_pd( SIN_S2),
+        _mm512_mul_pd( square, _mm512_add_pd( _mm512_set1_pd( SIN_S3),
+        _mm512_mul_pd( square, _mm512_set1_pd( SIN_S4))))), _mm512_mul_pd(
+        _mm512_mul_pd( square, fourth), _mm512_add_pd( _mm512_set1_pd( SIN_S5),
+        _mm512_mul_pd( square, _mm512_set1_pd( SIN_S6)))));
+    __m512d cube = _mm512_mul_pd( square, reduced_arg);
+    __m512d sin_value = _mm512_sub_pd( reduced_arg, _mm512_sub_pd(
+        _mm512_sub_pd( _mm512_mul_pd( square, _mm512_sub_pd( _mm512_mul_pd(
+        _mm512_set1_pd( 0.5), reduced_low), _mm512_mul_pd( cube, sin_poly))),
+        reduced_low), _mm512_mul_pd( cube, _mm512_set1_pd( SIN_S1))));
+    __m512d quadrant_idx = _mm512_sub_pd( quadrant, _mm512_mul_pd(
+        _mm512_set1_pd( 4.0), _mm512_roundscale_pd( _mm512_mul_pd( quadrant,
+        _mm512_set1_pd( 0.25)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)));
+    __mmask8 is_first = _mm512_cmp_pd_mask( quadrant_idx, one, _CMP_EQ_OQ);
+    __mmask8 is_second = _mm512_cmp_pd_mask( quadrant_idx,
+        _mm512_set1_pd( 2.0), _CMP_EQ_OQ);
+    __mmask8 is_third = _mm512_cmp_pd_mask( quadrant_idx,
+        _mm512_set1_pd( 3.0), _CMP_EQ_OQ);
+    __m512d value = _mm512_mask_blend_pd( is_first | is_third, cos_value,
+        sin_value);
+    __m512i value_bits = _mm512_castpd_si512( value);
+    return _mm512_castsi512_pd( _mm512_mask_xor_epi64( value_bits,
+        is_first | is_second, value_bits, _mm512_set1_epi64( 1LL << 63)));
+}
+__attribute__(( target( "avx512f")))
+static void cosineKernelAvx512( const double* args, double* result,
+                                size_t count){
+    const __m512d limit = _mm512_set1_pd( COSINE_REDUCTION_LIMIT);
+    for( size_t arg_idx = 0; arg_idx < count; arg_idx += 8){
+        __mmask8 mask = count - arg_idx >= 8 ? 0xFF :
+            ( 1 << ( count - arg_idx)) - 1;
+        __m512d arg = _mm512_maskz_loadu_pd( mask, args + arg_idx);
+        _mm512_mask_storeu_pd( result + arg_idx, mask, cosineAvx512( arg));
+        // The large arguments are taken by libm
+        if( _mm512_mask_cmp_pd_mask( mask, _mm512_abs_pd( arg), limit,
+            _CMP_GE_OQ) ){
+            cosineKernelScalar( args + arg_idx, result + arg_idx,
+                count - arg_idx >= 8 ? 8 : count - arg_idx);
+        }
+    }
+}
+#endif
+/**
+ * Calculate a dot product of the two arrays
+ */
+double dotProductKernel( const double* vec_a, const double* vec_b,
+                         size_t vec_len){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        return dotProductAvx512( vec_a, vec_b, vec_len);
+    case SIMD_AVX2:
+        return dotProductAvx2( vec_a, vec_b, vec_len);
+#endif
+    default:
+        return dotProductScalar( vec_a, vec_b, vec_len);
+    }
+}
+/**
+ * Calculate a linear combination of the two arrays
+ * The result may be one of the arrays
+ */
+void linearCombinationKernel( const double* vec_a, const double* vec_b,
+                              double alpha_coeff, double beta_coeff,
+                              double* result, size_t vec_len){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        linearCombinationAvx512( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+        break;
+    case SIMD_AVX2:
+        linearCombinationAvx2( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+        break;
+#endif
+    default:
+        linearCombinationScalar( vec_a, vec_b, alpha_coeff, beta_coeff, result,
+            vec_len);
+    }
+}
+/**
+ * Multiply the CSR rows by the kernel of the instruction set.
+ * The overloads by the index type select the gather of the columns.
+ */
+template <typename Index_t>
+static double sparseMVDotVectorized( const Index_t* IA, const Index_t* JA,
+                                     const double* A, const double* vec,
+                                     double* result, size_t start_row,
+                                     size_t end_row){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        return sparseMVDotAvx512( IA, JA, A, vec, result, start_row, end_row);
+    case SIMD_AVX2:
+        return sparseMVDotAvx2( IA, JA, A, vec, result, start_row, end_row);
+#endif
+    default:
+        return sparseMVDotScalar( IA, JA, A, vec, result, start_row, end_row);
+    }
+}
+// The float cells aren't vectorized
+template <typename Index_t>
+static double sparseMVDotVectorized( const Index_t* IA, const Index_t* JA,
+                                     const float* A, const double* vec,
+                                     double* result, size_t start_row,
+                                     size_t end_row){
+    return sparseMVDotScalar( IA, JA, A, vec, result, start_row, end_row);
+}
+/**
+ * Multiply the rows [start_row; end_row) of a CSR matrix to the vector
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+template <typename Index_t, typename Value_t>
+double sparseMVDotKernel( const Index_t* IA, const Index_t* JA,
+                          const Value_t* A, const double* vec, double* result,
+                          size_t start_row, size_t end_row){
+    return sparseMVDotVectorized( IA, JA, A, vec, result, start_row, end_row);
+}
+template double sparseMVDotKernel( const int*, const int*, const double*,
+                                   const double*, double*, size_t, size_t);
+template double sparseMVDotKernel( const int64_t*, const int64_t*,
+                                   const double*, const double*, double*,
+                                   size_t, size_t);
+template double sparseMVDotKernel( const int*, const int*, const float*,
+                                   const double*, double*, size_t, size_t);
+template double sparseMVDotKernel( const int64_t*, const int64_t*,
+                                   const float*, const double*, double*,
+                                   size_t, size_t);
+/**
+ * Multiply the rows [start_row; end_row) of a CSR matrix with the float
+ * cells to the float vector. The processors with AVX-512 take the AVX2
+ * kernel: a row takes a half of a 512-bit register of the floats.
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+double sparseMVDotKernel( const int* IA, const int* JA, const float* A,
+                          const float* vec, float* result, size_t start_row,
+                          size_t end_row){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+    case SIMD_AVX2:
+        return sparseMVDotAvx2( IA, JA, A, vec, result, start_row, end_row);
+#endif
+    default:
+        return sparseMVDotScalar( IA, JA, A, vec, result, start_row, end_row);
+    }
+}
+/**
+ * Multiply the rows [start_row; end_row) of a CSR matrix with the deltas
+ * instead of the columns to the vector. The deltas are loaded by the whole
+ * registers, so SIMD_DELTAS_PADDING deltas must follow the last cell.
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+template <typename Delta_t>
+double compressedMVDotKernel( const int* IA, const Delta_t* deltas,
+                              const double* A, const double* vec,
+                              double* result, size_t start_row,
+                              size_t end_row){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        return compressedMVDotAvx512( IA, deltas, A, vec, result, start_row,
+            end_row);
+    case SIMD_AVX2:
+        return compressedMVDotAvx2( IA, deltas, A, vec, result, start_row,
+            end_row);
+#endif
+    default:
+        return compressedMVDotScalar( IA, deltas, A, vec, result, start_row,
+            end_row);
+    }
+}
+template double compressedMVDotKernel( const int*, const int8_t*,
+                                       const double*, const double*, double*,
+                                       size_t, size_t);
+template double compressedMVDotKernel( const int*, const int16_t*,
+                                       const double*, const double*, double*,
+                                       size_t, size_t);
+/**
+ * Multiply the chunks [start_chunk; end_chunk) of a sliced ELLPACK matrix
+ * to the vector. The chunk height must not exceed SELL_MAX_CHUNK_HEIGHT.
+ * The vectorized kernels need the height to be a multiple of the register
+ * width, otherwise a narrower kernel is used.
+ * Results:
+ *      The dot product of the vector and the result on these rows
+ */
+double sellMVDotKernel( const int* chunk_offsets, const int* chunk_lengths,
+                        const int* columns, const double* values,
+                        const int* row_permutation, size_t chunk_height,
+                        const double* vec, double* result,
+                        size_t start_chunk, size_t end_chunk,
+                        size_t nodes_count){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        if( chunk_height % 8 == 0 ){
+            return sellMVDotAvx512( chunk_offsets, chunk_lengths, columns,
+                values, row_permutation, chunk_height, vec, result,
+                start_chunk, end_chunk, nodes_count);
+        }
+        // Falls through - the processors with AVX-512 have AVX2
+    case SIMD_AVX2:
+        if( chunk_height % 4 == 0 ){
+            return sellMVDotAvx2( chunk_offsets, chunk_lengths, columns,
+                values, row_permutation, chunk_height, vec, result,
+                start_chunk, end_chunk, nodes_count);
+        }
+#endif
+        // Falls through - the height isn't a multiple of the register width
+    default:
+        return sellMVDotScalar( chunk_offsets, chunk_lengths, columns, values,
+            row_permutation, chunk_height, vec, result, start_chunk, end_chunk,
+            nodes_count);
+    }
+}
+/**
+ * Calculate the cosines of the arguments.
+ * The arguments up to 2^50 are reduced without libm, so the kernel
+ * doesn't take the slow reduction of libm for the large arguments.
+ * The cosines differ from the ones of libm by 1 ulp at most.
+ */
+void cosineKernel( const double* args, double* result, size_t count){
+    switch( current_isa ){
+#ifdef SIMD_X86
+    case SIMD_AVX512:
+        cosineKernelAvx512( args, result, count);
+        break;
+    case SIMD_AVX2:
+        cosineKernelAvx2( args, result, count);
+        break;
+#endif
+    default:
+        cosineKernelScalar( args, result, count);
+    }
+}
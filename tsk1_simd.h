@@ -0,0 +1,69 @@
+#ifndef SIMD_H
+    #define SIMD_H
+#include <cstddef>
+#include <stdint.h>
+/**
+ * The vectorized kernels of the basic operations.
+ * The kernels work on the raw arrays and on a range of the elements,
+ * the OpenMP threads call them on their part of the vectors.
+ * The instruction set is detected by CPUID at the start of the program,
+ * the kernels without the explicit vectorization are the fallback.
+ */
+typedef enum{
+    SIMD_SCALAR = 0,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_ISA_COUNT
+} SimdIsa_t;
+SimdIsa_t detectSimdIsa();
+bool isSimdIsaSupported( SimdIsa_t isa);
+SimdIsa_t getSimdIsa();
+void setSimdIsa( SimdIsa_t isa);
+const char* getSimdIsaName( SimdIsa_t isa);
+size_t getSimdWidth( SimdIsa_t isa);
+double dotProductKernel( const double* vec_a, const double* vec_b,
+                         size_t vec_len);
+void linearCombinationKernel( const double* vec_a, const double* vec_b,
+                              double alpha_coeff, double beta_coeff,
+                              double* result, size_t vec_len);
+/**
+ * The CSR kernel is instantiated for the int and int64_t indices
+ * and the double and float cells. The vectorized kernels gather
+ * the double cells, the float cells are multiplied by the scalar kernel.
+ * IA has the end of the last row, so a row ends at IA[node_idx + 1].
+ */
+template <typename Index_t, typename Value_t>
+double sparseMVDotKernel( const Index_t* IA, const Index_t* JA,
+                          const Value_t* A, const double* vec, double* result,
+                          size_t start_row, size_t end_row);
+/**
+ * The CSR kernel of the mixed precision solver: the float cells
+ * and the float vectors. The dot product is summed in double.
+ */
+double sparseMVDotKernel( const int* IA, const int* JA, const float* A,
+                          const float* vec, float* result, size_t start_row,
+                          size_t end_row);
+void cosineKernel( const double* args, double* result, size_t count);
+enum {
+    // The maximum number of rows in a chunk of the sliced ELLPACK matrix
+    SELL_MAX_CHUNK_HEIGHT = 16,
+    // The deltas after the last cell, that the kernels may load
+    SIMD_DELTAS_PADDING = 8
+};
+/**
+ * The CSR kernel with the columns stored as the deltas from the row,
+ * instantiated for the int8_t and int16_t deltas.
+ * IA has the end of the last row.
+ */
+template <typename Delta_t>
+double compressedMVDotKernel( const int* IA, const Delta_t* deltas,
+                              const double* A, const double* vec,
+                              double* result, size_t start_row,
+                              size_t end_row);
+double sellMVDotKernel( const int* chunk_offsets, const int* chunk_lengths,
+                        const int* columns, const double* values,
+                        const int* row_permutation, size_t chunk_height,
+                        const double* vec, double* result,
+                        size_t start_chunk, size_t end_chunk,
+                        size_t nodes_count);
+#endif
@@ -1,12 +1,77 @@
+#include <algorithm>
 #include <iostream>
+#include "omp.h"
 #include "tsk1_graph_prepare.h"
 #include "tsk1_solver.h"
 enum { MAX_ITERATIONS = 10000 };
+/**
+ * The inner solver of the mixed precision solver reduces rho of the true
+ * residual by this factor. The float residual keeps about 7 digits,
+ * so a deeper reduction isn't reached in float.
+ */
+const double MIXED_INNER_REDUCTION = 0.000001;
 /**
  * A CG solver for a matrix
+ * Allocate the solver vectors for a single solve
  */
-SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
-               double convergence_accuracy){ // The convergence accuracy
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, // The convergence accuracy
+               bool use_fused){             // Use the fused operations
+    SolverWorkspace workspace( matrix.getNodesCount());
+    return solverCG( matrix, right_part, print_debug, convergence_accuracy,
+        workspace, use_fused);
+}
+/**
+ * A CG solver for a matrix with the Jacobi preconditioner
+ */
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, // The convergence accuracy
+               SolverWorkspace& workspace,  // Preallocated solver vectors
+               bool use_fused){             // Use the fused operations
+    JacobiPreconditioner preconditioner;
+    preconditioner.setup( matrix);
+    return solverCG( matrix, right_part, print_debug, convergence_accuracy,
+        preconditioner, workspace, use_fused);
+}
+/**
+ * Start the time measurement of an operation
+ * The time is calculated only if MEASURE_VECTOR_OPS define is set
+ */
+static double startMeasure(){
+#ifdef MEASURE_VECTOR_OPS
+    return omp_get_wtime();
+#else
+    return 0;
+#endif
+}
+/**
+ * Append the time since the start to the time of an operation
+ */
+static void stopMeasure( double start_time, double& time){
+#ifdef MEASURE_VECTOR_OPS
+    time += omp_get_wtime() - start_time;
+#else
+    ( void)start_time;
+    ( void)time;
+#endif
+}
+/**
+ * A CG solver for a matrix
+ * The vectors are taken from the workspace, so after the workspace is
+ * prepared the iterations don't allocate memory
+ * The vector operations are the expressions of tsk1_expression.h,
+ * every statement is one loop without the temporary vectors.
+ * If use_fused is set, the matrix multiplication is fused with the dot
+ * product, and the vector updates are fused with the preconditioning
+ * and the dot product.
+ * Otherwise every basic operation is a separate pass.
+ * The preconditioner must be set up for the matrix.
+ */
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy,     // The convergence accuracy
+               Preconditioner& preconditioner,  // z = M^-1 * r
+               SolverWorkspace& workspace,      // Preallocated solver vectors
+               bool use_fused){                 // Use the fused operations
 	/**
 	 * The variables for time measurement
 	 * Matter only if the time of the basic operations is measure.
@@ -14,35 +79,49 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
     double dotproduct_time = 0;
     double linearcombination_time = 0;
     double sparsemv_time = 0;
-    double start_measurement = 0;
-    double end_measurement = 0;
+    double fused_sparsemv_time = 0;
+    double fused_update_time = 0;
 	// Matrix information
     size_t row_count = matrix.getNodesCount();
-    size_t not_null_cells = matrix.getEdgesCount();
+    workspace.prepare( row_count);
+    MathVector& initial_guess = workspace.getApproximation();
+    MathVector& r_iter = workspace.getR();
+    MathVector& z_iter = workspace.getZ();
+    MathVector& p_iter = workspace.getP();
+    MathVector& q_iter = workspace.getQ();
     // Generate an initial guess vector
-    MathVector initial_guess( row_count);
-    for( size_t vec_idx = 0; vec_idx < row_count; ++vec_idx){
-        initial_guess[vec_idx] = 0;
-    }
+    initial_guess.setZero();
     bool has_converged = false;
     size_t iteration_num = 1;
-    /** 
-     * Create a preconditioner matrix from a matrix,
-     * borrowing only a diagonal
-     */
-    NetGraph reverse_preconditioner = matrix.makeDiagonalMatrix( true);
-    MathVector current_approximation = sparseMVWithMeasure( matrix, initial_guess,
-    sparsemv_time);
-    MathVector r_iter = linearCombinationWithMeasure( right_part, current_approximation, 1,
-    -1, linearcombination_time);
+    // The current approximation is stored in the q vector
+    sparseMVWithMeasure( matrix, initial_guess, q_iter, sparsemv_time);
+    double op_start = startMeasure();
+    r_iter = right_part - q_iter;
+    stopMeasure( op_start, linearcombination_time);
     double rho_prev = 0, rho_iter = 0;
-    MathVector p_iter( r_iter.getVecLen());
+    /**
+     * The fused update calculates z_{k+1} and rho_{k+1}
+     * at the end of the previous iteration
+     */
+    double rho_next = 0;
+    if( use_fused ){
+        op_start = startMeasure();
+        rho_next = preconditioner.applyDot( r_iter, z_iter);
+        stopMeasure( op_start, fused_update_time);
+    }
     // A conjugate gradient algorithm
     while( !has_converged ){
-        MathVector z_iter = sparseMVWithMeasure( reverse_preconditioner, r_iter,
-        sparsemv_time);
         rho_prev = rho_iter;
-        rho_iter = dotProductWithMeasure( r_iter, z_iter, dotproduct_time);
+        if( use_fused ){
+            rho_iter = rho_next;
+        } else{
+            op_start = startMeasure();
+            preconditioner.apply( r_iter, z_iter);
+            stopMeasure( op_start, sparsemv_time);
+            op_start = startMeasure();
+            rho_iter = dot( r_iter, z_iter);
+            stopMeasure( op_start, dotproduct_time);
+        }
         if( iteration_num == 1 ){
             p_iter.copyValues( z_iter);
         } else{
@@ -51,20 +130,35 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
                 break;
             }
             double b_iter = rho_iter / rho_prev;
-            p_iter.copyValues( linearCombinationWithMeasure( z_iter, p_iter, 1, b_iter, linearcombination_time));
+            op_start = startMeasure();
+            p_iter = z_iter + b_iter * p_iter;
+            stopMeasure( op_start, linearcombination_time);
+        }
+        double pq_product = 0;
+        if( use_fused ){
+            pq_product = sparseMVDotWithMeasure( matrix, p_iter, q_iter,
+            fused_sparsemv_time);
+        } else{
+            sparseMVWithMeasure( matrix, p_iter, q_iter, sparsemv_time);
+            op_start = startMeasure();
+            pq_product = dot( p_iter, q_iter);
+            stopMeasure( op_start, dotproduct_time);
         }
-        MathVector q_iter = sparseMVWithMeasure( matrix, p_iter, sparsemv_time);
-        double pq_product = dotProductWithMeasure( p_iter, q_iter,
-        dotproduct_time);
         if( !pq_product ){
             std::cout << "Product of p_{k} and q_{k} is zero" << std::endl;
             break;
         }
         double alpha_iter = rho_iter / pq_product;
-        initial_guess.copyValues( linearCombinationWithMeasure( initial_guess, p_iter, 1,
-        alpha_iter, linearcombination_time));   
-        r_iter.copyValues( linearCombinationWithMeasure( r_iter, q_iter, 
-        1, -alpha_iter, linearcombination_time));
+        op_start = startMeasure();
+        if( use_fused ){
+            rho_next = preconditioner.updateApplyDot( initial_guess, r_iter,
+                p_iter, q_iter, alpha_iter, z_iter);
+            stopMeasure( op_start, fused_update_time);
+        } else{
+            initial_guess += alpha_iter * p_iter;
+            r_iter -= alpha_iter * q_iter;
+            stopMeasure( op_start, linearcombination_time);
+        }
         if( print_debug ){
             std::cout << "Iterations:" << iteration_num << " " << rho_iter << std::endl;
         }
@@ -84,6 +178,276 @@ SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_de
     std::cout << "Linear combination time: " << linearcombination_time <<
     std::endl;
     std::cout << "Sparse multiplication time: " << sparsemv_time << std::endl;
+    if( use_fused ){
+        std::cout << "Fused sparse multiplication and dot product time: " <<
+        fused_sparsemv_time << std::endl;
+        std::cout << "Fused solution and residual update time: " <<
+        fused_update_time << std::endl;
+    }
 #endif
     return SolverSolution( initial_guess, iteration_num, r_iter.calculateL2());
 }
+/**
+ * A CG solver for a matrix, that runs the whole iteration loop
+ * in one parallel region
+ * Allocate the solver vectors for a single solve
+ */
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug,
+               double convergence_accuracy){ // The convergence accuracy
+    SolverWorkspace workspace( matrix.getNodesCount());
+    return solverCGPersistent( matrix, right_part, print_debug,
+        convergence_accuracy, workspace);
+}
+/**
+ * A CG solver for a matrix, that runs the whole iteration loop
+ * in one parallel region, with the Jacobi preconditioner
+ */
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug,
+               double convergence_accuracy, // The convergence accuracy
+               SolverWorkspace& workspace){ // Preallocated solver vectors
+    JacobiPreconditioner preconditioner;
+    preconditioner.setup( matrix);
+    return solverCGPersistent( matrix, right_part, print_debug,
+        convergence_accuracy, preconditioner, workspace);
+}
+/**
+ * A CG solver for a matrix, that runs the whole iteration loop
+ * in one parallel region.
+ * The thread team is created once instead of every basic operation.
+ * The operations share the work with the orphaned omp for,
+ * the dot products are summed in a shared scratch, so every thread
+ * gets the same sums and calculates the same coefficients.
+ * The iteration counter and the convergence flag are updated by
+ * a single thread.
+ * The preconditioner must be set up for the matrix.
+ */
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug,
+               double convergence_accuracy,     // The convergence accuracy
+               Preconditioner& preconditioner,  // z = M^-1 * r
+               SolverWorkspace& workspace){     // Preallocated solver vectors
+	// Matrix information
+    size_t row_count = matrix.getNodesCount();
+    workspace.prepare( row_count);
+    MathVector& initial_guess = workspace.getApproximation();
+    MathVector& r_iter = workspace.getR();
+    MathVector& z_iter = workspace.getZ();
+    MathVector& p_iter = workspace.getP();
+    MathVector& q_iter = workspace.getQ();
+    ReductionScratch scratch( omp_get_max_threads());
+    // Prepare the row partitions before the threads share them
+    matrix.prepareThreads( omp_get_max_threads());
+    // The state shared by the threads
+    bool has_converged = false;
+    size_t iteration_num = 1;
+    #pragma omp parallel
+    {
+        // Generate an initial guess vector
+        #pragma omp for schedule( static)
+        for( size_t vec_idx = 0; vec_idx < row_count; ++vec_idx){
+            initial_guess[vec_idx] = 0;
+        }
+        // The current approximation is stored in the q vector
+        matrix.multiplyDotInRegion( initial_guess, q_iter);
+        #pragma omp barrier
+        linearCombinationInRegion( right_part, q_iter, 1, -1, r_iter);
+        // The preconditioner gives z_{1} and rho_{1}
+        double rho_next = scratch.reduce( preconditioner.applyDotInRegion(
+            r_iter, z_iter));
+        double rho_prev = 0, rho_iter = 0;
+        // A conjugate gradient algorithm
+        while( !has_converged ){
+            rho_prev = rho_iter;
+            rho_iter = rho_next;
+            if( iteration_num == 1 ){
+                copyValuesInRegion( z_iter, p_iter);
+            } else{
+                if( !rho_prev ){
+                    #pragma omp single
+                    std::cout << "Zero dot product" << std::endl;
+                    break;
+                }
+                double b_iter = rho_iter / rho_prev;
+                linearCombinationInRegion( z_iter, p_iter, 1, b_iter, p_iter);
+            }
+            double pq_product = scratch.reduce( matrix.multiplyDotInRegion(
+                p_iter, q_iter));
+            if( !pq_product ){
+                #pragma omp single
+                std::cout << "Product of p_{k} and q_{k} is zero" << std::endl;
+                break;
+            }
+            double alpha_iter = rho_iter / pq_product;
+            rho_next = scratch.reduce( preconditioner.updateApplyDotInRegion(
+                initial_guess, r_iter, p_iter, q_iter, alpha_iter, z_iter));
+            #pragma omp single
+            {
+                if( print_debug ){
+                    std::cout << "Iterations:" << iteration_num << " " << rho_iter << std::endl;
+                }
+                if( rho_iter < convergence_accuracy || iteration_num >= MAX_ITERATIONS ){
+                    has_converged = true;
+                } else{
+                    iteration_num++;
+                }
+            }
+        }
+    }
+    if( print_debug ){
+        initial_guess.printVector();
+        std::cout << "Number of iterations: " << iteration_num << std::endl;
+        std::cout << "L2 norm: " << r_iter.calculateL2() << std::endl;
+    }
+    return SolverSolution( initial_guess, iteration_num, r_iter.calculateL2());
+}
+/**
+ * Round the cells of the graph to float
+ * The indices are copied, the graph keeps its arrays.
+ * The float graph is moved to the caller.
+ */
+static NetGraphFloat makeFloatGraph( NetGraph& graph){
+    size_t nodes_count = graph.getNodesCount();
+    size_t edges_count = graph.getEdgesCount();
+    int* graph_IA = graph.getIA();
+    int* graph_JA = graph.getJA();
+    double* graph_A = graph.getA();
+    int* float_IA = allocateArray<int>( nodes_count + 1);
+    int* float_JA = allocateArray<int>( edges_count);
+    float* float_A = allocateArray<float>( edges_count);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx ){
+        float_IA[node_idx] = graph_IA[node_idx];
+    }
+    float_IA[nodes_count] = edges_count;
+    #pragma omp parallel for
+    for( size_t edge_idx = 0; edge_idx < edges_count; ++edge_idx ){
+        float_JA[edge_idx] = graph_JA[edge_idx];
+        float_A[edge_idx] = static_cast<float>( graph_A[edge_idx]);
+    }
+    return NetGraphFloat( nodes_count, edges_count, float_IA, float_JA,
+        float_A);
+}
+/**
+ * Solve A*d = r by the CG in float. The correction d is the approximation
+ * of the workspace. The iterations stop, when rho of the float residual
+ * falls below the accuracy.
+ * Results:
+ *      A number of the iterations
+ */
+static size_t solveCorrectionFloat( NetGraphFloat& matrix,
+               MathVectorFloat& reverse_diagonal,     // D^-1 in float
+               MathVector& residual,                  // r in double
+               double inner_accuracy,
+               size_t max_iterations,
+               SolverWorkspaceFloat& workspace){
+    size_t row_count = matrix.getNodesCount();
+    workspace.prepare( row_count);
+    MathVectorFloat& correction = workspace.getApproximation();
+    MathVectorFloat& r_iter = workspace.getR();
+    MathVectorFloat& z_iter = workspace.getZ();
+    MathVectorFloat& p_iter = workspace.getP();
+    MathVectorFloat& q_iter = workspace.getQ();
+    correction.setZero();
+    r_iter.convertValues( residual);
+    double rho_next = evaluateDot( r_iter, z_iter,
+        assign( z_iter, reverse_diagonal * r_iter));
+    double rho_prev = 0, rho_iter = 0;
+    size_t iteration_num = 0;
+    while( iteration_num < max_iterations ){
+        rho_prev = rho_iter;
+        rho_iter = rho_next;
+        if( iteration_num == 0 ){
+            p_iter.copyValues( z_iter);
+        } else{
+            if( !rho_prev ){
+                break;
+            }
+            p_iter = z_iter + ( rho_iter / rho_prev) * p_iter;
+        }
+        double pq_product = sparseMVDot( matrix, p_iter, q_iter);
+        if( !pq_product ){
+            break;
+        }
+        double alpha_iter = rho_iter / pq_product;
+        rho_next = evaluateDot( r_iter, z_iter,
+            assign( correction, correction + alpha_iter * p_iter),
+            assign( r_iter, r_iter - alpha_iter * q_iter),
+            assign( z_iter, reverse_diagonal * r_iter));
+        ++iteration_num;
+        if( rho_next < inner_accuracy ){
+            break;
+        }
+    }
+    return iteration_num;
+}
+/**
+ * A mixed precision CG solver for a graph.
+ * The iterations run in float with a float copy of the graph, it halves
+ * the bytes of the cells and the vectors. The float solution isn't
+ * accurate enough, so it is refined: the true residual r = b - A*x is
+ * calculated in double, the float CG solves A*d = r for the correction,
+ * and x = x + d. The refinement stops, when rho of the true residual
+ * is less than the accuracy, as the double solver does.
+ * Results:
+ *      The number of the float iterations in all refinements
+ */
+SolverSolution solverCGMixed( NetGraph& matrix, MathVector& right_part,
+               bool print_debug,
+               double convergence_accuracy){ // The convergence accuracy
+    size_t row_count = matrix.getNodesCount();
+    // The initial approximation is zero, as a new vector is
+    MathVector approximation( row_count);
+    MathVector residual( row_count);
+    MathVector preconditioned_residual( row_count);
+    // A*x, then the correction in double
+    MathVector product( row_count);
+    JacobiPreconditioner preconditioner;
+    preconditioner.setup( matrix);
+    MathVector& reverse_diagonal = preconditioner.getReverseDiagonal();
+    NetGraphFloat float_matrix = makeFloatGraph( matrix);
+    MathVectorFloat float_diagonal( row_count);
+    float_diagonal.convertValues( reverse_diagonal);
+    SolverWorkspaceFloat workspace( row_count);
+    size_t iteration_num = 0;
+    size_t refinement_num = 0;
+    while( true ){
+        matrix.multiply( approximation, product);
+        double rho = evaluateDot( residual, preconditioned_residual,
+            assign( residual, right_part - product),
+            assign( preconditioned_residual, reverse_diagonal * residual));
+        if( print_debug ){
+            std::cout << "Refinement:" << refinement_num << " " << rho <<
+            std::endl;
+        }
+        if( rho < convergence_accuracy || iteration_num >= MAX_ITERATIONS ){
+            break;
+        }
+        /**
+         * The last refinement doesn't need to reduce rho below
+         * the accuracy of the solver
+         */
+        double inner_accuracy = std::max( rho * MIXED_INNER_REDUCTION,
+            convergence_accuracy);
+        size_t inner_iterations = solveCorrectionFloat( float_matrix,
+            float_diagonal, residual, inner_accuracy,
+            MAX_ITERATIONS - iteration_num, workspace);
+        if( !inner_iterations ){
+            std::cout << "The float solver has stopped" << std::endl;
+            break;
+        }
+        iteration_num += inner_iterations;
+        product.convertValues( workspace.getApproximation());
+        approximation += product;
+        ++refinement_num;
+    }
+    if( print_debug ){
+        approximation.printVector();
+        std::cout << "Number of iterations: " << iteration_num << std::endl;
+        std::cout << "Number of refinements: " << refinement_num << std::endl;
+        std::cout << "L2 norm: " << residual.calculateL2() << std::endl;
+    }
+    return SolverSolution( std::move( approximation), iteration_num,
+        residual.calculateL2());
+}
@@ -1,11 +1,16 @@
+#include <utility>
 #include "tsk1_vector.h"
+#include "tsk1_preconditioner.h"
 // A solver result
 class SolverSolution{
 public:
-    SolverSolution( MathVector approximate_solution, int iterations_number,
+    SolverSolution( MathVector&& approximate_solution, int iterations_number,
+        double solution_l2): approximate_solution_( std::move( approximate_solution)),
+        iterations_number_(iterations_number), solution_l2_(solution_l2) {}
+    SolverSolution( const MathVector& approximate_solution, int iterations_number,
         double solution_l2): approximate_solution_( approximate_solution),
         iterations_number_(iterations_number), solution_l2_(solution_l2) {}
-    MathVector getApproximateSolution(){
+    MathVector& getApproximateSolution(){
         return approximate_solution_;
     }
     int getIterationsNumber(){
@@ -22,6 +27,75 @@ private:
     // An l2 norm of the solution
     double solution_l2_;
 };
+/**
+ * The vectors used by the solver on every iteration.
+ * Allocate them once and reuse between the solves,
+ * so the solver loop doesn't allocate memory.
+ * The inner solver of the mixed precision solver takes the float vectors.
+ */
+template <typename Value_t>
+class SolverWorkspaceT{
+public:
+    SolverWorkspaceT( size_t vec_len): approximation_( vec_len),
+        r_iter_( vec_len), z_iter_( vec_len), p_iter_( vec_len),
+        q_iter_( vec_len) {}
+    /**
+     * Reallocate the vectors only if the system size has changed
+     */
+    void prepare( size_t vec_len){
+        if( approximation_.getVecLen() != vec_len ){
+            approximation_ = MathVectorT<Value_t>( vec_len);
+            r_iter_ = MathVectorT<Value_t>( vec_len);
+            z_iter_ = MathVectorT<Value_t>( vec_len);
+            p_iter_ = MathVectorT<Value_t>( vec_len);
+            q_iter_ = MathVectorT<Value_t>( vec_len);
+        }
+    }
+    MathVectorT<Value_t>& getApproximation(){
+        return approximation_;
+    }
+    MathVectorT<Value_t>& getR(){
+        return r_iter_;
+    }
+    MathVectorT<Value_t>& getZ(){
+        return z_iter_;
+    }
+    MathVectorT<Value_t>& getP(){
+        return p_iter_;
+    }
+    MathVectorT<Value_t>& getQ(){
+        return q_iter_;
+    }
+private:
+    // The current approximation x_{k}
+    MathVectorT<Value_t> approximation_;
+    // A residual r_{k}
+    MathVectorT<Value_t> r_iter_;
+    // A preconditioned residual z_{k}
+    MathVectorT<Value_t> z_iter_;
+    // A search direction p_{k}
+    MathVectorT<Value_t> p_iter_;
+    // A product of the matrix and the search direction q_{k}
+    MathVectorT<Value_t> q_iter_;
+};
+typedef SolverWorkspaceT<double> SolverWorkspace;
+typedef SolverWorkspaceT<float> SolverWorkspaceFloat;
 
-SolverSolution solverCG( NetGraph& matrix, MathVector& right_part, bool print_debug,
-               double convergence_accuracy);
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, bool use_fused = true);
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, SolverWorkspace& workspace,
+               bool use_fused = true);
+SolverSolution solverCG( MatrixOperator& matrix, MathVector& right_part, bool print_debug,
+               double convergence_accuracy, Preconditioner& preconditioner,
+               SolverWorkspace& workspace, bool use_fused = true);
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug, double convergence_accuracy);
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug, double convergence_accuracy,
+               SolverWorkspace& workspace);
+SolverSolution solverCGPersistent( MatrixOperator& matrix, MathVector& right_part,
+               bool print_debug, double convergence_accuracy,
+               Preconditioner& preconditioner, SolverWorkspace& workspace);
+SolverSolution solverCGMixed( NetGraph& matrix, MathVector& right_part,
+               bool print_debug, double convergence_accuracy);
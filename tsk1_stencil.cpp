@@ -0,0 +1,192 @@
+/**
+ * The graph matrix, that is calculated on the fly
+ */
+#include <omp.h>
+#include "tsk1_stencil.h"
+/**
+ * Calculate the diagonal from the matrix parameters
+ * Make the matrix diagonally dominant, as NetGraph::fillMatrix does.
+ * The cells are summed in the order of the edges of a row in JA.
+ */
+void StencilMatrix::fillDiagonal(){
+    const double DOMINANCE_COEFF = 2;
+    #pragma omp parallel for
+    for( size_t row_idx = 0; row_idx <= row_len_; ++row_idx ){
+        for( size_t column_idx = 0; column_idx <= column_len_; ++column_idx ){
+            size_t node_idx = row_idx * (column_len_ + 1) + column_idx;
+            // A sum of all matrix cells on the row, except for the diagonal
+            double row_sum = 0;
+            if( row_idx > 0 ){
+                row_sum += fabs( calculateCell( node_idx,
+                    node_idx - (column_len_ + 1)));
+                if( column_idx < column_len_ &&
+                    isCellDivided( (row_idx - 1) * column_len_ + column_idx) ){
+                    row_sum += fabs( calculateCell( node_idx,
+                        node_idx - column_len_));
+                }
+            }
+            if( column_idx > 0 ){
+                row_sum += fabs( calculateCell( node_idx, node_idx - 1));
+            }
+            if( column_idx < column_len_ ){
+                row_sum += fabs( calculateCell( node_idx, node_idx + 1));
+            }
+            if( row_idx < row_len_ ){
+                if( column_idx > 0 &&
+                    isCellDivided( row_idx * column_len_ + column_idx - 1) ){
+                    row_sum += fabs( calculateCell( node_idx,
+                        node_idx + column_len_));
+                }
+                row_sum += fabs( calculateCell( node_idx,
+                    node_idx + (column_len_ + 1)));
+            }
+            diagonal_[node_idx] = DOMINANCE_COEFF * row_sum;
+        }
+    }
+}
+/**
+ * Multiply the nodes of a grid row to the vector by the multiplication
+ * of the pattern of the divided cells
+ * Results:
+ *      The dot product of the vector and the result on the nodes
+ */
+double StencilMatrix::multiplyGridRow( const double* vec, double* result,
+                                       size_t row_idx){
+    switch( pattern_ ){
+    case MatrixParameters::PATTERN_ALL_DIVIDED:
+        return multiplyPatternRow<MatrixParameters::PATTERN_ALL_DIVIDED>(
+            vec, result, row_idx);
+    case MatrixParameters::PATTERN_NONE_DIVIDED:
+        return multiplyPatternRow<MatrixParameters::PATTERN_NONE_DIVIDED>(
+            vec, result, row_idx);
+    case MatrixParameters::PATTERN_ALTERNATING:
+        return multiplyPatternRow<MatrixParameters::PATTERN_ALTERNATING>(
+            vec, result, row_idx);
+    default:
+        return multiplyPatternRow<MatrixParameters::PATTERN_GENERIC>(
+            vec, result, row_idx);
+    }
+}
+/**
+ * Multiply a grid row, the first and the last rows of the grid
+ * don't have the neighbors above and below
+ */
+template <MatrixParameters::DividePattern_t pattern>
+double StencilMatrix::multiplyPatternRow( const double* vec, double* result,
+                                          size_t row_idx){
+    if( row_idx > 0 && row_idx < row_len_ ){
+        return multiplyRowNodes<pattern, true, true>( vec, result, row_idx);
+    } else if( row_len_ == 0 ){
+        return multiplyRowNodes<pattern, false, false>( vec, result, row_idx);
+    } else if( row_idx == 0 ){
+        return multiplyRowNodes<pattern, false, true>( vec, result, row_idx);
+    }
+    return multiplyRowNodes<pattern, true, false>( vec, result, row_idx);
+}
+/**
+ * Multiply the nodes of a grid row. The first and the last nodes
+ * are taken out of the loop, so the inner nodes don't check the borders
+ */
+template <MatrixParameters::DividePattern_t pattern,
+          bool has_upper, bool has_lower>
+double StencilMatrix::multiplyRowNodes( const double* vec, double* result,
+                                        size_t row_idx){
+    if( column_len_ == 0 ){
+        return multiplyNode<pattern, has_upper, has_lower, false, false>(
+            vec, result, row_idx, 0);
+    }
+    double sum = multiplyNode<pattern, has_upper, has_lower, false, true>(
+        vec, result, row_idx, 0);
+    for( size_t column_idx = 1; column_idx < column_len_; ++column_idx ){
+        sum += multiplyNode<pattern, has_upper, has_lower, true, true>(
+            vec, result, row_idx, column_idx);
+    }
+    sum += multiplyNode<pattern, has_upper, has_lower, true, false>(
+        vec, result, row_idx, column_len_);
+    return sum;
+}
+/**
+ * Multiply a row of the matrix to the vector, the neighbors of the node
+ * are the template parameters
+ * Results:
+ *      The product of the vector and the result on the node
+ */
+template <MatrixParameters::DividePattern_t pattern,
+          bool has_upper, bool has_lower, bool has_left, bool has_right>
+inline double StencilMatrix::multiplyNode( const double* vec, double* result,
+                                           size_t row_idx, size_t column_idx){
+    size_t node_idx = row_idx * (column_len_ + 1) + column_idx;
+    double row_product = 0;
+    if( has_upper ){
+        size_t neighbor_idx = node_idx - (column_len_ + 1);
+        row_product += calculateCell( node_idx, neighbor_idx) *
+            vec[neighbor_idx];
+        if( has_right &&
+            isCellDivided<pattern>( (row_idx - 1) * column_len_ + column_idx) ){
+            neighbor_idx = node_idx - column_len_;
+            row_product += calculateCell( node_idx, neighbor_idx) *
+                vec[neighbor_idx];
+        }
+    }
+    if( has_left ){
+        row_product += calculateCell( node_idx, node_idx - 1) *
+            vec[node_idx - 1];
+    }
+    row_product += diagonal_[node_idx] * vec[node_idx];
+    if( has_right ){
+        row_product += calculateCell( node_idx, node_idx + 1) *
+            vec[node_idx + 1];
+    }
+    if( has_lower ){
+        size_t neighbor_idx = 0;
+        if( has_left &&
+            isCellDivided<pattern>( row_idx * column_len_ + column_idx - 1) ){
+            neighbor_idx = node_idx + column_len_;
+            row_product += calculateCell( node_idx, neighbor_idx) *
+                vec[neighbor_idx];
+        }
+        neighbor_idx = node_idx + (column_len_ + 1);
+        row_product += calculateCell( node_idx, neighbor_idx) *
+            vec[neighbor_idx];
+    }
+    result[node_idx] = row_product;
+    return vec[node_idx] * row_product;
+}
+void StencilMatrix::multiply( MathVector& vec, MathVector& result){
+    multiplyDot( vec, result);
+}
+double StencilMatrix::multiplyDot( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    assert( &result != &vec);
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel for schedule( static) reduction( +:sum)
+    for( size_t row_idx = 0; row_idx <= row_len_; ++row_idx ){
+        sum += multiplyGridRow( vec_values, result_values, row_idx);
+    }
+    return sum;
+}
+double StencilMatrix::multiplyDotInRegion( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp for schedule( static) nowait
+    for( size_t row_idx = 0; row_idx <= row_len_; ++row_idx ){
+        sum += multiplyGridRow( vec_values, result_values, row_idx);
+    }
+    return sum;
+}
+/**
+ * Copy the stored diagonal
+ */
+void StencilMatrix::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        diagonal[node_idx] = diagonal_[node_idx];
+    }
+}
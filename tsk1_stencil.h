@@ -0,0 +1,76 @@
+#ifndef STENCIL_H
+    #define STENCIL_H
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A matrix of the graph, that is never stored.
+ * The edges of a node follow from the matrix parameters, and the cells
+ * are cos( i + j + i*j), so the multiplication calculates them on the fly.
+ * Only the diagonal is stored: it is the sum of the row cells,
+ * and the preconditioner needs it too.
+ */
+class StencilMatrix: public MatrixOperator{
+public:
+StencilMatrix( MatrixParameters *params_p): row_len_( params_p->getRowLen()),
+    column_len_( params_p->getColumnLen()),
+    not_divided_( params_p->getNotDivided()),
+    divided_( params_p->getDivided()),
+    pattern_( params_p->getDividePattern()){
+    nodes_count_ = (row_len_ + 1) * (column_len_ + 1);
+    diagonal_ = allocateArray<double>( nodes_count_);
+}
+StencilMatrix( const StencilMatrix&) = delete;
+~StencilMatrix(){
+    freeArray( diagonal_);
+}
+size_t getNodesCount(){
+    return nodes_count_;
+}
+double* getDiagonal(){
+    return diagonal_;
+}
+void fillDiagonal();
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void copyDiagonal( MathVector& diagonal);
+private:
+    /**
+     * Is the cell divided by the pattern of the matrix parameters
+     */
+    bool isCellDivided( size_t cell_idx){
+        return cell_idx % (divided_ + not_divided_) >= not_divided_;
+    }
+    template <MatrixParameters::DividePattern_t pattern>
+    bool isCellDivided( size_t cell_idx){
+        return MatrixParameters::isCellDivided<pattern>( cell_idx,
+            not_divided_, divided_);
+    }
+    /**
+     * Calculate a matrix cell of an edge, as NetGraph::fillMatrix does
+     */
+    static double calculateCell( size_t node_idx, size_t neighbor_idx){
+        return cos( node_idx + neighbor_idx + node_idx * neighbor_idx);
+    }
+    double multiplyGridRow( const double* vec, double* result, size_t row_idx);
+    template <MatrixParameters::DividePattern_t pattern>
+    double multiplyPatternRow( const double* vec, double* result,
+                               size_t row_idx);
+    template <MatrixParameters::DividePattern_t pattern,
+              bool has_upper, bool has_lower>
+    double multiplyRowNodes( const double* vec, double* result,
+                             size_t row_idx);
+    template <MatrixParameters::DividePattern_t pattern,
+              bool has_upper, bool has_lower, bool has_left, bool has_right>
+    double multiplyNode( const double* vec, double* result, size_t row_idx,
+                         size_t column_idx);
+    size_t row_len_;
+    size_t column_len_;
+    size_t not_divided_;
+    size_t divided_;
+    // The pattern of the divided cells, that the multiplication is taken for
+    MatrixParameters::DividePattern_t pattern_;
+    size_t nodes_count_;
+    double* diagonal_;
+};
+#endif
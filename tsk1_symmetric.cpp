@@ -0,0 +1,181 @@
+/**
+ * The symmetric graph matrix, that stores the upper triangle
+ */
+#include <algorithm>
+#include <omp.h>
+#include "tsk1_symmetric.h"
+/**
+ * Take the diagonal and the upper triangle of the graph
+ * The graph matrix must be symmetric, as the filled graph is
+ */
+SymmetricGraph::SymmetricGraph( NetGraph& graph){
+    nodes_count_ = graph.getNodesCount();
+    int* graph_IA = graph.getIA();
+    int* graph_JA = graph.getJA();
+    double* graph_A = graph.getA();
+    IA = allocateArray<int>( nodes_count_ + 1);
+    // Count the cells of the rows, then write them
+    size_t edges_count = 0;
+    bandwidth_ = 0;
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        IA[node_idx] = edges_count;
+        size_t end_idx = graph_IA[node_idx + 1];
+        for( size_t edge_idx = graph_IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx ){
+            size_t column_idx = graph_JA[edge_idx];
+            if( column_idx >= node_idx ){
+                ++edges_count;
+                bandwidth_ = std::max( bandwidth_, column_idx - node_idx);
+            }
+        }
+    }
+    IA[nodes_count_] = edges_count;
+    edges_count_ = edges_count;
+    JA = allocateArray<int>( edges_count_);
+    A = allocateArray<double>( edges_count_);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        size_t end_idx = graph_IA[node_idx + 1];
+        size_t cell_idx = IA[node_idx];
+        // The columns of a row are sorted, so the diagonal is the first
+        for( size_t edge_idx = graph_IA[node_idx]; edge_idx < end_idx;
+             ++edge_idx ){
+            if( graph_JA[edge_idx] >= static_cast<int>( node_idx) ){
+                JA[cell_idx] = graph_JA[edge_idx];
+                A[cell_idx] = graph_A[edge_idx];
+                ++cell_idx;
+            }
+        }
+        assert( JA[IA[node_idx]] == static_cast<int>( node_idx));
+    }
+}
+/**
+ * Split the rows between the threads by the number of cells
+ * and allocate the halo buffers
+ */
+void SymmetricGraph::prepareThreads( size_t threads_num){
+    if( row_partition_.size() == threads_num + 1 ){
+        return;
+    }
+    row_partition_.assign( threads_num + 1, nodes_count_);
+    row_partition_[0] = 0;
+    for( size_t part_idx = 1; part_idx < threads_num; ++part_idx ){
+        size_t edges_bound = edges_count_ * part_idx / threads_num;
+        row_partition_[part_idx] = std::lower_bound( IA, IA + nodes_count_,
+            edges_bound) - IA;
+    }
+    halo_.assign( threads_num * bandwidth_, 0);
+}
+/**
+ * Multiply the parts of the current thread to the vector.
+ * Must be called by every thread of the parallel region.
+ * The team may have less threads than the parts, so a thread takes
+ * the parts from its number with the step of the team size,
+ * every part has its own halo.
+ * The dot product (x, Ax) is the sum of a_ii * x_i^2 and 2 * a_ij * x_i * x_j,
+ * so it is calculated from the cells without the final result.
+ * Results:
+ *      The partial dot product of the thread
+ */
+double SymmetricGraph::multiplyDotThread( const double* vec, double* result){
+    size_t parts_count = row_partition_.size() - 1;
+    size_t threads_num = omp_get_num_threads();
+    size_t thread_idx = omp_get_thread_num();
+    double sum = 0;
+    for( size_t part_idx = thread_idx; part_idx < parts_count;
+         part_idx += threads_num ){
+        sum += multiplyDotPart( part_idx, vec, result);
+    }
+    #pragma omp barrier
+    // Add the halo of the previous parts, that falls into the current parts
+    for( size_t part_idx = thread_idx; part_idx < parts_count;
+         part_idx += threads_num ){
+        size_t start_row = row_partition_[part_idx];
+        size_t end_row = row_partition_[part_idx + 1];
+        for( size_t prev_idx = 0; prev_idx < part_idx; ++prev_idx ){
+            size_t halo_start = row_partition_[prev_idx + 1];
+            size_t from_row = std::max( halo_start, start_row);
+            size_t to_row = std::min( halo_start + bandwidth_, end_row);
+            const double* prev_halo = halo_.data() + prev_idx * bandwidth_;
+            for( size_t node_idx = from_row; node_idx < to_row; ++node_idx ){
+                result[node_idx] += prev_halo[node_idx - halo_start];
+            }
+        }
+    }
+    return sum;
+}
+/**
+ * Multiply the rows of the part to the vector. The symmetric cells,
+ * that fall after the part, are written to its halo.
+ * Results:
+ *      The partial dot product of the part
+ */
+double SymmetricGraph::multiplyDotPart( size_t part_idx, const double* vec,
+                                        double* result){
+    size_t start_row = row_partition_[part_idx];
+    size_t end_row = row_partition_[part_idx + 1];
+    double* halo = halo_.data() + part_idx * bandwidth_;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx ){
+        result[node_idx] = 0;
+    }
+    for( size_t halo_idx = 0; halo_idx < bandwidth_; ++halo_idx ){
+        halo[halo_idx] = 0;
+    }
+    double sum = 0;
+    for( size_t node_idx = start_row; node_idx < end_row; ++node_idx ){
+        double node_value = vec[node_idx];
+        double row_product = A[IA[node_idx]] * node_value;
+        // The upper triangle without the diagonal
+        double upper_product = 0;
+        size_t end_idx = IA[node_idx + 1];
+        for( size_t cell_idx = IA[node_idx] + 1; cell_idx < end_idx;
+             ++cell_idx ){
+            size_t column_idx = JA[cell_idx];
+            upper_product += A[cell_idx] * vec[column_idx];
+            // The symmetric cell of the lower triangle
+            if( column_idx < end_row ){
+                result[column_idx] += A[cell_idx] * node_value;
+            } else{
+                halo[column_idx - end_row] += A[cell_idx] * node_value;
+            }
+        }
+        result[node_idx] += row_product + upper_product;
+        sum += node_value * ( row_product + 2 * upper_product);
+    }
+    return sum;
+}
+void SymmetricGraph::multiply( MathVector& vec, MathVector& result){
+    multiplyDot( vec, result);
+}
+double SymmetricGraph::multiplyDot( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    assert( &result != &vec);
+    prepareThreads( omp_get_max_threads());
+    const double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel reduction( +:sum)
+    {
+        sum += multiplyDotThread( vec_values, result_values);
+    }
+    return sum;
+}
+double SymmetricGraph::multiplyDotInRegion( MathVector& vec, MathVector& result){
+    assert( vec.getVecLen() == nodes_count_);
+    assert( result.getVecLen() == nodes_count_);
+    double sum = multiplyDotThread( vec.getValues(), result.getValues());
+    // The halo buffers are cleared by the next multiplication
+    #pragma omp barrier
+    return sum;
+}
+/**
+ * Copy the diagonal from the first cells of the rows
+ */
+void SymmetricGraph::copyDiagonal( MathVector& diagonal){
+    assert( diagonal.getVecLen() == nodes_count_);
+    #pragma omp parallel for
+    for( size_t node_idx = 0; node_idx < nodes_count_; ++node_idx ){
+        diagonal[node_idx] = A[IA[node_idx]];
+    }
+}
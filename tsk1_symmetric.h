@@ -0,0 +1,68 @@
+#ifndef SYMMETRIC_H
+    #define SYMMETRIC_H
+#include <vector>
+#include "tsk1_graph_prepare.h"
+#include "tsk1_vector.h"
+/**
+ * A symmetric matrix of the graph, that stores only the diagonal
+ * and the upper triangle in CSR. The first cell of a row is the diagonal.
+ * A cell a_ij, j > i, adds a_ij * x_j to y_i and a_ij * x_i to y_j,
+ * so a thread writes to the rows after its part. These rows are at most
+ * bandwidth rows after the part, the thread adds to them through its own
+ * halo buffer, and the buffers are summed after all threads finish the rows.
+ */
+class SymmetricGraph: public MatrixOperator{
+public:
+SymmetricGraph( NetGraph& graph);
+SymmetricGraph( const SymmetricGraph&) = delete;
+~SymmetricGraph(){
+    freeArray( IA);
+    freeArray( JA);
+    freeArray( A);
+}
+size_t getNodesCount(){
+    return nodes_count_;
+}
+// A number of the stored cells: the diagonal and the upper triangle
+size_t getEdgesCount(){
+    return edges_count_;
+}
+// The maximum distance between the row and the column of a cell
+size_t getBandwidth(){
+    return bandwidth_;
+}
+/**
+ * Get the memory of the matrix arrays in bytes
+ */
+size_t getMemorySize(){
+    return ( nodes_count_ + 1 + edges_count_) * sizeof( int) +
+        edges_count_ * sizeof( double);
+}
+void multiply( MathVector& vec, MathVector& result);
+double multiplyDot( MathVector& vec, MathVector& result);
+double multiplyDotInRegion( MathVector& vec, MathVector& result);
+void prepareThreads( size_t threads_num);
+void copyDiagonal( MathVector& diagonal);
+private:
+    double multiplyDotThread( const double* vec, double* result);
+    double multiplyDotPart( size_t part_idx, const double* vec,
+                            double* result);
+    int* IA;
+    int* JA;
+    double* A;
+    size_t nodes_count_;
+    size_t edges_count_;
+    size_t bandwidth_;
+    /**
+     * The rows of the parts with almost the same number of cells.
+     * The part part_idx has the rows
+     * [row_partition_[part_idx]; row_partition_[part_idx + 1])
+     */
+    std::vector<size_t> row_partition_;
+    /**
+     * The halo of the part part_idx are bandwidth_ elements from
+     * part_idx * bandwidth_, they are added to the rows after the part
+     */
+    std::vector<double> halo_;
+};
+#endif
@@ -2,6 +2,7 @@
  * Different utilities for the parsing
  */
 #include <cstring>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 #include <stdint.h>
@@ -9,6 +10,9 @@
 #include <windows.h>
 #include <psapi.h>
 #endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
 #include "tsk1_real.h"
 #include "tsk1_graph_prepare.h"
 // Measure memory usage on Windows
@@ -27,6 +31,18 @@ void printHelp(){
     std::cout << "File must be put at the same directory" << std::endl;
     std::cout << "-d enables a debug print" << std::endl;
     std::cout << "-t (--threads) specify a number of threads" << std::endl;
+    std::cout << "-b (--bind) close|spread|master binds the threads to the places" << std::endl;
+    std::cout << "-l (--places) threads|cores|sockets|LIST specify the places of the threads (cores by default)" << std::endl;
+    std::cout << "-u (--unfused) disables the fused solver operations" << std::endl;
+    std::cout << "-p (--persistent) runs the solver in one parallel region" << std::endl;
+    std::cout << "-g (--two-pass) generates the graph and fills it in two passes" << std::endl;
+    std::cout << "-f (--format) csr|dia|sell|stencil|sym|delta specify a storage format of the matrix" << std::endl;
+    std::cout << "-s (--sigma) specify a sorting window of the sell format" << std::endl;
+    std::cout << "-w (--wide) uses the 64-bit indices of the graph" << std::endl;
+    std::cout << "-m (--mixed) runs the solver in float with the refinement in double" << std::endl;
+    std::cout << "-r (--reorder) grid|rcm|morton specify the order of the graph nodes" << std::endl;
+    std::cout << "-k (--preconditioner) jacobi|ic0|ssor|gmg|amg specify the preconditioner of the solver" << std::endl;
+    std::cout << "-a (--arena) none|small|thp|huge specify the pages of the arena of the arrays" << std::endl;
 }
 /**
  * Read the parameters from the file
@@ -80,6 +96,129 @@ int parseCMDArguments( int argc, char** argv,
         if( !strcmp( "-d", argv[arg_idx]) ){
             program_env_p->setDebugPrint( true);
         }
+        if( !strcmp( "--unfused", argv[arg_idx]) || 
+            !strcmp( "-u", argv[arg_idx]) ){
+            program_env_p->setFusedOps( false);
+        }
+        if( !strcmp( "--persistent", argv[arg_idx]) || 
+            !strcmp( "-p", argv[arg_idx]) ){
+            program_env_p->setPersistentSolver( true);
+        }
+        if( !strcmp( "--two-pass", argv[arg_idx]) || 
+            !strcmp( "-g", argv[arg_idx]) ){
+            program_env_p->setTwoPassFill( true);
+        }
+        if( !strcmp( "--wide", argv[arg_idx]) || 
+            !strcmp( "-w", argv[arg_idx]) ){
+            program_env_p->setWideIndex( true);
+        }
+        if( !strcmp( "--mixed", argv[arg_idx]) || 
+            !strcmp( "-m", argv[arg_idx]) ){
+            program_env_p->setMixedPrecision( true);
+        }
+        if( !strcmp( "--format", argv[arg_idx]) || 
+            !strcmp( "-f", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse a matrix format" << std::endl;
+                return -1;
+            }
+            if( !strcmp( "csr", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat( ProgramEnv::MATRIX_FORMAT_CSR);
+            } else if( !strcmp( "dia", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat( ProgramEnv::MATRIX_FORMAT_DIA);
+            } else if( !strcmp( "sell", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat( ProgramEnv::MATRIX_FORMAT_SELL);
+            } else if( !strcmp( "stencil", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat(
+                    ProgramEnv::MATRIX_FORMAT_STENCIL);
+            } else if( !strcmp( "sym", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat(
+                    ProgramEnv::MATRIX_FORMAT_SYMMETRIC);
+            } else if( !strcmp( "delta", argv[arg_idx + 1]) ){
+                program_env_p->setMatrixFormat(
+                    ProgramEnv::MATRIX_FORMAT_COMPRESSED);
+            } else{
+                std::cout << "Can't parse a matrix format" << std::endl;
+                return -1;
+            }
+        }
+        if( !strcmp( "--reorder", argv[arg_idx]) || 
+            !strcmp( "-r", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse an order of nodes" << std::endl;
+                return -1;
+            }
+            if( !strcmp( "grid", argv[arg_idx + 1]) ){
+                program_env_p->setNodeOrder( ProgramEnv::NODE_ORDER_GRID);
+            } else if( !strcmp( "rcm", argv[arg_idx + 1]) ){
+                program_env_p->setNodeOrder( ProgramEnv::NODE_ORDER_RCM);
+            } else if( !strcmp( "morton", argv[arg_idx + 1]) ){
+                program_env_p->setNodeOrder( ProgramEnv::NODE_ORDER_MORTON);
+            } else{
+                std::cout << "Can't parse an order of nodes" << std::endl;
+                return -1;
+            }
+        }
+        if( !strcmp( "--preconditioner", argv[arg_idx]) || 
+            !strcmp( "-k", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse a preconditioner" << std::endl;
+                return -1;
+            }
+            if( !strcmp( "jacobi", argv[arg_idx + 1]) ){
+                program_env_p->setPreconditionerType(
+                    ProgramEnv::PRECONDITIONER_JACOBI);
+            } else if( !strcmp( "ic0", argv[arg_idx + 1]) ){
+                program_env_p->setPreconditionerType(
+                    ProgramEnv::PRECONDITIONER_IC0);
+            } else if( !strcmp( "ssor", argv[arg_idx + 1]) ){
+                program_env_p->setPreconditionerType(
+                    ProgramEnv::PRECONDITIONER_SSOR);
+            } else if( !strcmp( "gmg", argv[arg_idx + 1]) ){
+                program_env_p->setPreconditionerType(
+                    ProgramEnv::PRECONDITIONER_GMG);
+            } else if( !strcmp( "amg", argv[arg_idx + 1]) ){
+                program_env_p->setPreconditionerType(
+                    ProgramEnv::PRECONDITIONER_AMG);
+            } else{
+                std::cout << "Can't parse a preconditioner" << std::endl;
+                return -1;
+            }
+        }
+        if( !strcmp( "--arena", argv[arg_idx]) || 
+            !strcmp( "-a", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse the arena pages" << std::endl;
+                return -1;
+            }
+            if( !strcmp( "none", argv[arg_idx + 1]) ){
+                program_env_p->setArenaPages( MemoryArena::PAGES_NONE);
+            } else if( !strcmp( "small", argv[arg_idx + 1]) ){
+                program_env_p->setArenaPages( MemoryArena::PAGES_SMALL);
+            } else if( !strcmp( "thp", argv[arg_idx + 1]) ){
+                program_env_p->setArenaPages(
+                    MemoryArena::PAGES_TRANSPARENT);
+            } else if( !strcmp( "huge", argv[arg_idx + 1]) ){
+                program_env_p->setArenaPages( MemoryArena::PAGES_HUGE);
+            } else{
+                std::cout << "Can't parse the arena pages" << std::endl;
+                return -1;
+            }
+        }
+        if( !strcmp( "--sigma", argv[arg_idx]) || 
+            !strcmp( "-s", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse a sorting window" << std::endl;
+                return -1;
+            }
+            int sort_window = 0;
+            if( !(std::istringstream( argv[arg_idx + 1]) >> sort_window) 
+                || sort_window <= 0){
+                std::cout << "Can't parse a sorting window" << std::endl;
+                return -1;
+            }
+            program_env_p->setSortWindow( sort_window);
+        }
         if( !strcmp( "--threads", argv[arg_idx]) || 
             !strcmp( "-t", argv[arg_idx]) ){
             if( arg_idx + 1 >= argc ){
@@ -94,9 +233,77 @@ int parseCMDArguments( int argc, char** argv,
             }
             program_env_p->setThreadsNum( num_threads);
         }
+        if( !strcmp( "--bind", argv[arg_idx]) || 
+            !strcmp( "-b", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse a binding of threads" << std::endl;
+                return -1;
+            }
+            if( !strcmp( "close", argv[arg_idx + 1]) ){
+                program_env_p->setThreadBind( ProgramEnv::THREAD_BIND_CLOSE);
+            } else if( !strcmp( "spread", argv[arg_idx + 1]) ){
+                program_env_p->setThreadBind( ProgramEnv::THREAD_BIND_SPREAD);
+            } else if( !strcmp( "master", argv[arg_idx + 1]) ){
+                program_env_p->setThreadBind( ProgramEnv::THREAD_BIND_MASTER);
+            } else{
+                std::cout << "Can't parse a binding of threads" << std::endl;
+                return -1;
+            }
+        }
+        if( !strcmp( "--places", argv[arg_idx]) || 
+            !strcmp( "-l", argv[arg_idx]) ){
+            if( arg_idx + 1 >= argc ){
+                std::cout << "Can't parse the places of threads" << std::endl;
+                return -1;
+            }
+            program_env_p->setThreadPlaces( argv[arg_idx + 1]);
+        }
     }
     return 0;
 }
+/**
+ * Bind the threads to the places, if the options ask it.
+ * The OpenMP runtime reads OMP_PROC_BIND and OMP_PLACES, when the program
+ * starts, so the variables are set, and the program is started again
+ * with the same arguments. The started program finds the variables set
+ * and continues.
+ * Results:
+ *     -1, if failure. 0 otherwise, the program doesn't return,
+ *     if it is started again
+ */
+int bindThreads( char** argv, ProgramEnv* program_env_p){
+    const char* bind_names[] = { "", "close", "spread", "master" };
+    ProgramEnv::ThreadBind_t thread_bind = program_env_p->getThreadBind();
+    std::string thread_places = program_env_p->getThreadPlaces();
+    if( thread_bind == ProgramEnv::THREAD_BIND_NONE ){
+        if( !thread_places.empty() ){
+            std::cout << "The places need a binding of threads" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+    if( thread_places.empty() ){
+        thread_places = "cores";
+    }
+    const char* current_bind = getenv( "OMP_PROC_BIND");
+    const char* current_places = getenv( "OMP_PLACES");
+    if( current_bind && current_places &&
+        !strcmp( current_bind, bind_names[thread_bind]) &&
+        thread_places == current_places ){
+        return 0;
+    }
+#ifdef __linux__
+    setenv( "OMP_PROC_BIND", bind_names[thread_bind], 1);
+    setenv( "OMP_PLACES", thread_places.c_str(), 1);
+    execv( "/proc/self/exe", argv);
+    std::cout << "Can't start the program with the bound threads" << std::endl;
+    return -1;
+#else
+    std::cout << "Set OMP_PROC_BIND and OMP_PLACES to bind the threads "
+    "on this OS" << std::endl;
+    return -1;
+#endif
+}
 /**
  * Get the memory usage of the program
  */
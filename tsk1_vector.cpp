@@ -1,4 +1,5 @@
 #include "tsk1_vector.h"
+#include "tsk1_simd.h"
 #include "tests/test_Vector.h"
 #include <cassert>
 /** 
@@ -9,10 +10,15 @@ double dotProduct( MathVector& vec_a, MathVector& vec_b){
     assert( vec_a.getVecLen() == vec_b.getVecLen());
     if( vec_a.getVecLen() == vec_b.getVecLen() ){
         size_t vec_len = vec_a.getVecLen();
+        double* values_a = vec_a.getValues();
+        double* values_b = vec_b.getValues();
         double sum = 0;
-        #pragma omp parallel for reduction( +:sum)
-        for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
-            sum += vec_a[vec_idx] * vec_b[vec_idx];
+        #pragma omp parallel reduction( +:sum)
+        {
+            size_t start_idx = 0, end_idx = 0;
+            getThreadRange( vec_len, start_idx, end_idx);
+            sum += dotProductKernel( values_a + start_idx, values_b + start_idx,
+                end_idx - start_idx);
         }
         return sum;
     } else{
@@ -27,82 +33,249 @@ double dotProduct( MathVector& vec_a, MathVector& vec_b){
  */
 MathVector linearCombination( MathVector& vec_a, MathVector& vec_b, 
                    double alpha_coeff, double beta_coeff){ // Linear coefficients
+    MathVector new_vec( vec_a.getVecLen());
+    linearCombination( vec_a, vec_b, alpha_coeff, beta_coeff, new_vec);
+    return new_vec;
+}
+/** 
+ * Calculate a linear combination of the two vectors into the result vector
+ * The result may be one of the vectors, e.g. y = a*x + b*y
+ */
+void linearCombination( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, // Linear coefficients
+                   MathVector& result){
     assert( vec_a.getVecLen() == vec_b.getVecLen());
+    assert( vec_a.getVecLen() == result.getVecLen());
     size_t vec_len = vec_a.getVecLen();
-    MathVector new_vec( vec_len);
-    #pragma omp parallel for
-    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
-        new_vec[vec_idx] = alpha_coeff * vec_a[vec_idx] + 
-            beta_coeff * vec_b[vec_idx];
+    double* values_a = vec_a.getValues();
+    double* values_b = vec_b.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel
+    {
+        size_t start_idx = 0, end_idx = 0;
+        getThreadRange( vec_len, start_idx, end_idx);
+        linearCombinationKernel( values_a + start_idx, values_b + start_idx,
+            alpha_coeff, beta_coeff, result_values + start_idx,
+            end_idx - start_idx);
     }
-    return new_vec;
 }
 /**
  * Multiply a graph matrix to the vector
  * A graph matrix is in the sparse form
  */
 MathVector sparseMV( NetGraph& graph, MathVector& vec){
-    int* IA = graph.getIA(), *JA = graph.getJA();
-    double* A = graph.getA();
+    MathVector new_vec( graph.getNodesCount());
+    sparseMV( graph, vec, new_vec);
+    return new_vec;
+}
+/**
+ * Multiply a graph matrix to the vector, y = A*x
+ * The result must not be the multiplied vector
+ */
+template <typename Index_t, typename Value_t>
+void sparseMV( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+               MathVector& result){
+    Index_t* IA = graph.getIA(), *JA = graph.getJA();
+    Value_t* A = graph.getA();
     size_t nodes_count = graph.getNodesCount();
-    size_t edges_count = graph.getEdgesCount();
     size_t vec_len = vec.getVecLen();
     assert( vec_len == nodes_count );
-    MathVector new_vec( nodes_count);
-    #pragma omp parallel for
-    for( size_t node_idx = 0; node_idx < nodes_count; ++node_idx){
-        new_vec[node_idx] = 0;
-        /**
-         * For the rightmost node IA doesn't specify the edges index.
-         * Instead, get it from the graph
-         */
-        size_t end_idx = node_idx + 1 < nodes_count ? IA[node_idx + 1] :
-            edges_count;
-        for( size_t edge_idx = IA[node_idx]; edge_idx < end_idx; ++edge_idx){
-            size_t column_idx = JA[edge_idx];
-            new_vec[node_idx] += vec[column_idx] * A[edge_idx]; 
-        }
+    assert( result.getVecLen() == nodes_count );
+    assert( &result != &vec );
+    // The threads get the parts with the same number of not-null cells
+    graph.prepareThreads( omp_get_max_threads());
+    const std::vector<size_t>& partition = graph.getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    #pragma omp parallel for schedule( static, 1)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sparseMVDotKernel( IA, JA, A, vec_values, result_values,
+            partition[part_idx], partition[part_idx + 1]);
+    }
+}
+/**
+ * Multiply a graph matrix to the vector, y = A*x,
+ * and calculate a dot product x*y in the same pass
+ * Results:
+ *      The dot product of the vector and the result
+ */
+template <typename Index_t, typename Value_t>
+double sparseMVDot( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+                    MathVector& result){
+    Index_t* IA = graph.getIA(), *JA = graph.getJA();
+    Value_t* A = graph.getA();
+    size_t nodes_count = graph.getNodesCount();
+    assert( vec.getVecLen() == nodes_count );
+    assert( result.getVecLen() == nodes_count );
+    assert( &result != &vec );
+    graph.prepareThreads( omp_get_max_threads());
+    const std::vector<size_t>& partition = graph.getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel for schedule( static, 1) reduction( +:sum)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sum += sparseMVDotKernel( IA, JA, A, vec_values, result_values,
+            partition[part_idx], partition[part_idx + 1]);
+    }
+    return sum;
+}
+/**
+ * Multiply the float graph to the float vector for the mixed precision
+ * solver. The dot product is summed in double.
+ */
+double sparseMVDot( NetGraphFloat& graph, MathVectorFloat& vec,
+                    MathVectorFloat& result){
+    int* IA = graph.getIA(), *JA = graph.getJA();
+    float* A = graph.getA();
+    size_t nodes_count = graph.getNodesCount();
+    assert( vec.getVecLen() == nodes_count );
+    assert( result.getVecLen() == nodes_count );
+    assert( &result != &vec );
+    graph.prepareThreads( omp_get_max_threads());
+    const std::vector<size_t>& partition = graph.getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    float* vec_values = vec.getValues();
+    float* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp parallel for schedule( static, 1) reduction( +:sum)
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sum += sparseMVDotKernel( IA, JA, A, vec_values, result_values,
+            partition[part_idx], partition[part_idx + 1]);
+    }
+    return sum;
+}
+/**
+ * The operations for a persistent parallel region.
+ * The loops use the static schedule, so a thread works with the same
+ * vector elements in every operation.
+ * The barrier at the end of the loop is kept only if the next operation
+ * may read the elements written by the other threads.
+ */
+void copyValuesInRegion( MathVector& source, MathVector& result){
+    assert( source.getVecLen() == result.getVecLen());
+    size_t vec_len = source.getVecLen();
+    const double* source_values = source.getValues();
+    double* result_values = result.getValues();
+    #pragma omp for schedule( static)
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx ){
+        result_values[vec_idx] = source_values[vec_idx];
     }
-    return new_vec;
+}
+void linearCombinationInRegion( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, // Linear coefficients
+                   MathVector& result){
+    assert( vec_a.getVecLen() == vec_b.getVecLen());
+    assert( vec_a.getVecLen() == result.getVecLen());
+    size_t vec_len = vec_a.getVecLen();
+    // The result may be one of the vectors, so the pointers may alias
+    const double* a_values = vec_a.getValues();
+    const double* b_values = vec_b.getValues();
+    double* result_values = result.getValues();
+    #pragma omp for schedule( static)
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        result_values[vec_idx] = alpha_coeff * a_values[vec_idx] +
+            beta_coeff * b_values[vec_idx];
+    }
+}
+/**
+ * Results:
+ *      The partial dot product of the thread
+ */
+double dotProductInRegion( MathVector& vec_a, MathVector& vec_b){
+    assert( vec_a.getVecLen() == vec_b.getVecLen());
+    size_t vec_len = vec_a.getVecLen();
+    const double* a_values = vec_a.getValues();
+    const double* b_values = vec_b.getValues();
+    double sum = 0;
+    #pragma omp for schedule( static) nowait
+    for( size_t vec_idx = 0; vec_idx < vec_len; ++vec_idx){
+        sum += a_values[vec_idx] * b_values[vec_idx];
+    }
+    return sum;
+}
+/**
+ * Results:
+ *      The partial dot product of the vector and the result of the thread
+ */
+template <typename Index_t, typename Value_t>
+double sparseMVDotInRegion( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+                   MathVector& result){
+    Index_t* IA = graph.getIA(), *JA = graph.getJA();
+    Value_t* A = graph.getA();
+    size_t nodes_count = graph.getNodesCount();
+    assert( vec.getVecLen() == nodes_count );
+    assert( result.getVecLen() == nodes_count );
+    assert( &result != &vec );
+    /**
+     * The rows are taken from the partition, that prepareThreads() made
+     * before the region, so the other threads may read the result
+     * only after a barrier
+     */
+    const std::vector<size_t>& partition = graph.getRowPartition();
+    size_t parts_count = partition.size() - 1;
+    double* vec_values = vec.getValues();
+    double* result_values = result.getValues();
+    double sum = 0;
+    #pragma omp for schedule( static, 1) nowait
+    for( size_t part_idx = 0; part_idx < parts_count; ++part_idx ){
+        sum += sparseMVDotKernel( IA, JA, A, vec_values, result_values,
+            partition[part_idx], partition[part_idx + 1]);
+    }
+    return sum;
 }
 /**
- * The wrappers over the basic operations.
- * Calculate the time of the basic operations and append it to the time.
+ * The multiplications of the graphs, that NetGraphT instantiates
+ */
+template void sparseMV( NetGraphT<int, double>&, MathVector&, MathVector&);
+template void sparseMV( NetGraphT<int64_t, double>&, MathVector&, MathVector&);
+template void sparseMV( NetGraphT<int, float>&, MathVector&, MathVector&);
+template void sparseMV( NetGraphT<int64_t, float>&, MathVector&, MathVector&);
+template double sparseMVDot( NetGraphT<int, double>&, MathVector&, MathVector&);
+template double sparseMVDot( NetGraphT<int64_t, double>&, MathVector&,
+                   MathVector&);
+template double sparseMVDot( NetGraphT<int, float>&, MathVector&, MathVector&);
+template double sparseMVDot( NetGraphT<int64_t, float>&, MathVector&,
+                   MathVector&);
+template double sparseMVDotInRegion( NetGraphT<int, double>&, MathVector&,
+                   MathVector&);
+template double sparseMVDotInRegion( NetGraphT<int64_t, double>&, MathVector&,
+                   MathVector&);
+template double sparseMVDotInRegion( NetGraphT<int, float>&, MathVector&,
+                   MathVector&);
+template double sparseMVDotInRegion( NetGraphT<int64_t, float>&, MathVector&,
+                   MathVector&);
+/**
+ * The wrappers over the matrix operations.
+ * Calculate the time of the operations and append it to the time.
  * The time is calculated only if MEASURE_VECTOR_OPS define is set
  */
-double dotProductWithMeasure( MathVector& vec_a, MathVector& vec_b, double&
-time){
-	#ifdef MEASURE_VECTOR_OPS
-    double start_time = omp_get_wtime();
-	#endif
-    double dot_product = dotProduct( vec_a, vec_b);
+void sparseMVWithMeasure( MatrixOperator& matrix, MathVector& vec,
+                   MathVector& result, double& time){
 	#ifdef MEASURE_VECTOR_OPS
-    double end_time = omp_get_wtime();
-    time += (end_time - start_time);
-	#endif
-    return dot_product;
-}
-MathVector linearCombinationWithMeasure( MathVector& vec_a, MathVector& vec_b, 
-                   double alpha_coeff, double beta_coeff, double& time){
-	#ifdef MEASURE_VECTOR_OPS				
     double start_time = omp_get_wtime();
 	#endif
-    MathVector linear_combination = linearCombination( vec_a, vec_b,
-    alpha_coeff, beta_coeff);
+    matrix.multiply( vec, result);
 	#ifdef MEASURE_VECTOR_OPS
     double end_time = omp_get_wtime();
     time += end_time - start_time;
+	#else
+    ( void)time;
 	#endif
-    return linear_combination;
 }
-MathVector sparseMVWithMeasure( NetGraph& graph, MathVector& vec, double& time){
+double sparseMVDotWithMeasure( MatrixOperator& matrix, MathVector& vec,
+                   MathVector& result, double& time){
 	#ifdef MEASURE_VECTOR_OPS
     double start_time = omp_get_wtime();
 	#endif
-    MathVector sparse_mv = sparseMV( graph, vec);
+    double dot_product = matrix.multiplyDot( vec, result);
 	#ifdef MEASURE_VECTOR_OPS
     double end_time = omp_get_wtime();
     time += end_time - start_time;
+	#else
+    ( void)time;
 	#endif
-    return sparse_mv;
-}
\ No newline at end of file
+    return dot_product;
+}
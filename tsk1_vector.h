@@ -4,41 +4,90 @@
 #include <cmath>
 #include <cassert>
 #include <iostream>
+#include <vector>
 #include "omp.h"
 #include "tsk1_graph_prepare.h"
+#include "tsk1_expression.h"
 /**
  * A mathematical vector
+ * The elements are of the value type, the solver uses MathVector of doubles
+ * A vector is a leaf of the expressions in tsk1_expression.h:
+ *      p = z + b*p; x += alpha*p; r -= alpha*q
+ * are single loops without the temporary vectors.
  */
-#include <cassert>
-class MathVector{
+template <typename Value_t>
+class MathVectorT: public VectorExpression<MathVectorT<Value_t> >{
 public:
-MathVector( size_t vec_len){
-    values_ = new double[vec_len];
+/**
+ * The values are zero. The threads write the parts, that they process
+ * in the operations, so the pages are first touched on their NUMA nodes.
+ */
+MathVectorT( size_t vec_len){
+    values_ = allocateArray<Value_t>( vec_len);
     vec_len_ = vec_len;
+    setZero();
 }
-~MathVector(){
-    delete values_;
+~MathVectorT(){
+    freeArray( values_);
 }
-MathVector( const MathVector& source){
+MathVectorT( const MathVectorT& source){
     vec_len_ = source.getVecLen();
-    values_ = new double[vec_len_];
-    double* source_values = source.getValues();
+    values_ = allocateArray<Value_t>( vec_len_);
+    Value_t* source_values = source.getValues();
+    #pragma omp parallel for schedule( static)
     for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx ){
         values_[vec_idx] = source_values[vec_idx];
     }
 }
+/**
+ * Take the values of a temporary vector without copying them
+ */
+MathVectorT( MathVectorT&& source){
+    vec_len_ = source.vec_len_;
+    values_ = source.values_;
+    source.vec_len_ = 0;
+    source.values_ = nullptr;
+}
+MathVectorT& operator=( MathVectorT&& source){
+    if( this != &source ){
+        freeArray( values_);
+        vec_len_ = source.vec_len_;
+        values_ = source.values_;
+        source.vec_len_ = 0;
+        source.values_ = nullptr;
+    }
+    return *this;
+}
+/**
+ * Assign an expression in one loop
+ */
+template <typename Expression_t>
+MathVectorT& operator=( const VectorExpression<Expression_t>& expression){
+    evaluate( assign( *this, expression));
+    return *this;
+}
+template <typename Expression_t>
+MathVectorT& operator+=( const VectorExpression<Expression_t>& expression){
+    evaluate( assign( *this, *this + expression.self()));
+    return *this;
+}
+template <typename Expression_t>
+MathVectorT& operator-=( const VectorExpression<Expression_t>& expression){
+    evaluate( assign( *this, *this - expression.self()));
+    return *this;
+}
 /**
  * Access the values array through the subscript operator.
  */
-double& operator[]( size_t vec_idx ){
+Value_t& operator[]( size_t vec_idx ){
     assert( vec_idx < vec_len_);
     return values_[vec_idx];
 }
-const double& operator[]( size_t vec_idx) const{
+const Value_t& operator[]( size_t vec_idx) const{
     assert( vec_idx < vec_len_);
     return values_[vec_idx];
 }
-double* getValues() const{
+Value_t* getValues() const{
     return values_;
 }
 size_t getVecLen() const{
@@ -47,11 +96,22 @@ size_t getVecLen() const{
 void setVecLen( int vec_len){
     vec_len_ = vec_len;
 }
+/**
+ * Set the values to zero
+ * The elements are split between the threads by the static schedule,
+ * as the vector operations split them
+ */
+void setZero(){
+    #pragma omp parallel for schedule( static)
+    for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx){
+        values_[vec_idx] = 0;
+    }
+}
 /**
  * Fill a vector
  */
-void fillVector( int threads_num = 1){ // A number of threads
-    #pragma omp parallel for
+void fillVector(){
+    #pragma omp parallel for schedule( static)
     for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx){
         values_[vec_idx] = sin( vec_idx);
     }
@@ -69,25 +129,39 @@ void printVector(){
 /** 
  * Copy values of another vector
  */
-void copyValues( const MathVector& source){
+void copyValues( const MathVectorT& source){
     assert( source.getVecLen() == vec_len_);
-    #pragma omp parallel for
+    #pragma omp parallel for schedule( static)
     for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx ){
         values_[vec_idx] = source[vec_idx];
     }
 }
+/**
+ * Copy values of a vector with another value type,
+ * e.g. round the doubles to the floats
+ */
+template <typename Source_t>
+void convertValues( const MathVectorT<Source_t>& source){
+    assert( source.getVecLen() == vec_len_);
+    Source_t* source_values = source.getValues();
+    #pragma omp parallel for schedule( static)
+    for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx ){
+        values_[vec_idx] = static_cast<Value_t>( source_values[vec_idx]);
+    }
+}
 /** 
  * Get a L2-norm of a vector
  */
 double calculateL2(){
     double l2_norm = 0;
+    #pragma omp parallel for schedule( static) reduction( +:l2_norm)
     for( size_t vec_idx = 0; vec_idx < vec_len_; ++vec_idx ){
         l2_norm += values_[vec_idx] * values_[vec_idx];
     }
     return sqrt( l2_norm);
 }
 private:
-    double* values_;
+    Value_t* values_;
     size_t vec_len_;
 };
 double dotProduct( MathVector& vec_a, MathVector& vec_b);
@@ -95,12 +169,90 @@ MathVector linearCombination( MathVector& vec_a, MathVector& vec_b,
                    double alpha_coeff, double beta_coeff);
 MathVector sparseMV( NetGraph& graph, MathVector& vec);
 /**
- * The wrappers over the basic operations.
- * Calculate the time of the basic operations and append it to the time.
- */
-double dotProductWithMeasure( MathVector& vec_a, MathVector& vec_b, double&
-time);
-MathVector linearCombinationWithMeasure( MathVector& vec_a, MathVector& vec_b, 
-                   double alpha_coeff, double beta_coeff, double& time);
-MathVector sparseMVWithMeasure( NetGraph& graph, MathVector& vec, double& time);
+ * The variants of the operations, that write into the preallocated vector.
+ * They don't allocate memory, so they are used inside the solver loop.
+ */
+void linearCombination( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, MathVector& result);
+template <typename Index_t, typename Value_t>
+void sparseMV( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+                   MathVector& result);
+/**
+ * The fused operations of the solver.
+ * They do the work of several basic operations in one pass over the memory.
+ */
+template <typename Index_t, typename Value_t>
+double sparseMVDot( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+                   MathVector& result);
+/**
+ * The multiplication of the inner solver of the mixed precision solver.
+ * The vectors and the cells are float, the dot product is summed in double.
+ */
+double sparseMVDot( NetGraphFloat& graph, MathVectorFloat& vec,
+                   MathVectorFloat& result);
+enum {
+    // Doubles in a cache line, so the threads don't share the lines
+    SCRATCH_PADDING = 8
+};
+/**
+ * A shared scratch for the reductions inside a parallel region.
+ * Every thread writes its partial sum to its own padded slot,
+ * then all threads sum the slots in the same order.
+ * The two sets of the slots are used in turn, so the next reduction
+ * doesn't overwrite the slots that are still read.
+ */
+class ReductionScratch{
+public:
+    ReductionScratch( int threads_num): threads_num_( threads_num),
+        partial_sums_( 2 * threads_num * SCRATCH_PADDING, 0),
+        generations_( threads_num * SCRATCH_PADDING, 0) {}
+    /**
+     * Sum the partial values of the threads.
+     * Must be called by every thread of the parallel region.
+     * Results:
+     *      The sum, the same for every thread
+     */
+    double reduce( double partial_sum){
+        int thread_idx = omp_get_thread_num();
+        assert( thread_idx < threads_num_);
+        size_t& generation = generations_[thread_idx * SCRATCH_PADDING];
+        double* slots = &partial_sums_[(generation % 2) * threads_num_ *
+            SCRATCH_PADDING];
+        ++generation;
+        slots[thread_idx * SCRATCH_PADDING] = partial_sum;
+        #pragma omp barrier
+        double sum = 0;
+        for( int slot_idx = 0; slot_idx < threads_num_; ++slot_idx ){
+            sum += slots[slot_idx * SCRATCH_PADDING];
+        }
+        return sum;
+    }
+private:
+    int threads_num_;
+    std::vector<double> partial_sums_;
+    // A number of the reductions made by a thread
+    std::vector<size_t> generations_;
+};
+/**
+ * The operations for a persistent parallel region.
+ * They must be called by every thread of the enclosing parallel region,
+ * the work is shared with the orphaned omp for.
+ * The operations with a dot product return the partial sum of the thread,
+ * sum it with the ReductionScratch.
+ */
+void copyValuesInRegion( MathVector& source, MathVector& result);
+void linearCombinationInRegion( MathVector& vec_a, MathVector& vec_b,
+                   double alpha_coeff, double beta_coeff, MathVector& result);
+double dotProductInRegion( MathVector& vec_a, MathVector& vec_b);
+template <typename Index_t, typename Value_t>
+double sparseMVDotInRegion( NetGraphT<Index_t, Value_t>& graph, MathVector& vec,
+                   MathVector& result);
+/**
+ * The wrappers over the matrix operations.
+ * Calculate the time of the operations and append it to the time.
+ */
+void sparseMVWithMeasure( MatrixOperator& matrix, MathVector& vec,
+                   MathVector& result, double& time);
+double sparseMVDotWithMeasure( MatrixOperator& matrix, MathVector& vec,
+                   MathVector& result, double& time);
 #endif